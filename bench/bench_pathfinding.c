@@ -0,0 +1,661 @@
+/*
+    bench_pathfinding.c
+
+    Micro-benchmark for Pathfinding_FindPath.
+    Built with a larger map (see `make bench`) and compares open-set
+    implementations and search algorithms on empty, maze,
+    random-obstacle and mixed-terrain layouts, then times an
+    unreachable goal with and without region labels, batch scaling,
+    map storage layouts at several sizes, cluster graph queries at
+    several sizes and map file loading.
+
+    All maps are generated from a fixed seed so runs are comparable.
+*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/core/map.h"
+#include "../src/core/mapfile.h"
+#include "../src/core/pathfinding.h"
+#include "../src/core/cluster.h"
+#include "../src/core/pathpool.h"
+
+typedef struct
+{
+    const char *name;
+    void (*build)(Map *map);
+} BenchMap;
+
+// Size of every benchmark map
+#define BENCH_MAP_WIDTH 256
+#define BENCH_MAP_HEIGHT 256
+
+static Map bench_map;
+static Path bench_path;
+static PathContext bench_ctx;
+
+#define BENCH_BATCH_SIZE 64
+
+static PathRequest bench_requests[BENCH_BATCH_SIZE];
+static PathResult bench_results[BENCH_BATCH_SIZE];
+
+static double bench_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static unsigned int bench_rand(unsigned int *state)
+{
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 16;
+}
+
+// Fresh all-walkable map of the benchmark size
+static void bench_init_map(Map *map)
+{
+    Map_Free(map);
+
+    if (!Map_Init(map, BENCH_MAP_WIDTH, BENCH_MAP_HEIGHT))
+    {
+        fprintf(stderr, "Failed to allocate map\n");
+        exit(1);
+    }
+}
+
+static void build_empty(Map *map)
+{
+    bench_init_map(map);
+}
+
+/*
+    Perfect maze carved on odd cells with an iterative backtracker.
+    Corridors are one tile wide, so paths take long detours.
+*/
+static void build_maze(Map *map)
+{
+    static int stack[BENCH_MAP_WIDTH * BENCH_MAP_HEIGHT];
+    unsigned int state = 1234;
+
+    bench_init_map(map);
+
+    for (int y = 0; y < BENCH_MAP_HEIGHT; y++)
+        for (int x = 0; x < BENCH_MAP_WIDTH; x++)
+            Map_SetWalkable(map, x, y, false);
+
+    int top = 0;
+    stack[top++] = 1 * BENCH_MAP_WIDTH + 1;
+    Map_SetWalkable(map, 1, 1, true);
+
+    const int dirs[4][2] = { { 0, -2 }, { 2, 0 }, { 0, 2 }, { -2, 0 } };
+
+    while (top > 0)
+    {
+        int cell = stack[top - 1];
+        int cx = cell % BENCH_MAP_WIDTH;
+        int cy = cell / BENCH_MAP_WIDTH;
+
+        int options[4];
+        int option_count = 0;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            int nx = cx + dirs[i][0];
+            int ny = cy + dirs[i][1];
+
+            if (nx <= 0 || ny <= 0 || nx >= BENCH_MAP_WIDTH - 1 || ny >= BENCH_MAP_HEIGHT - 1)
+                continue;
+
+            if (Map_IsWalkable(map, nx, ny))
+                continue;
+
+            options[option_count++] = i;
+        }
+
+        if (option_count == 0)
+        {
+            top--;
+            continue;
+        }
+
+        int dir = options[bench_rand(&state) % option_count];
+        int nx = cx + dirs[dir][0];
+        int ny = cy + dirs[dir][1];
+
+        Map_SetWalkable(map, cx + dirs[dir][0] / 2, cy + dirs[dir][1] / 2, true);
+        Map_SetWalkable(map, nx, ny, true);
+
+        stack[top++] = ny * BENCH_MAP_WIDTH + nx;
+    }
+}
+
+static void build_random(Map *map)
+{
+    unsigned int state = 42;
+
+    bench_init_map(map);
+
+    for (int y = 0; y < BENCH_MAP_HEIGHT; y++)
+    {
+        for (int x = 0; x < BENCH_MAP_WIDTH; x++)
+        {
+            if (bench_rand(&state) % 100 < 20)
+                Map_SetWalkable(map, x, y, false);
+        }
+    }
+}
+
+/*
+    Random obstacles over mixed terrain: road, grass and swamp.
+    JPS falls back to A* here, as step costs are not uniform.
+*/
+static void build_terrain(Map *map)
+{
+    unsigned int state = 99;
+
+    bench_init_map(map);
+
+    for (int y = 0; y < BENCH_MAP_HEIGHT; y++)
+    {
+        for (int x = 0; x < BENCH_MAP_WIDTH; x++)
+        {
+            unsigned int roll = bench_rand(&state) % 100;
+
+            if (roll < 15)
+                Map_SetWalkable(map, x, y, false);
+            else if (roll < 50)
+                Map_SetCost(map, x, y, MAP_COST_GRASS);
+            else if (roll < 65)
+                Map_SetCost(map, x, y, MAP_COST_SWAMP);
+        }
+    }
+}
+
+// Queries run corner to corner, on odd cells so maze endpoints are open
+#define BENCH_START 1
+#define BENCH_GOAL_TX (BENCH_MAP_WIDTH - 2 - (BENCH_MAP_WIDTH % 2 == 0))
+#define BENCH_GOAL_TY (BENCH_MAP_HEIGHT - 2 - (BENCH_MAP_HEIGHT % 2 == 0))
+
+/*
+    Open map with the goal walled in: the worst case for a search,
+    which has to exhaust the start's whole region before failing.
+*/
+static void build_walled(Map *map)
+{
+    bench_init_map(map);
+
+    for (int y = BENCH_GOAL_TY - 1; y <= BENCH_GOAL_TY + 1; y++)
+        for (int x = BENCH_GOAL_TX - 1; x <= BENCH_GOAL_TX + 1; x++)
+            Map_SetWalkable(map, x, y, false);
+}
+
+static double bench_run(const Map *map, const PathOptions *options, int iterations, bool *found)
+{
+    double begin = bench_now_ms();
+
+    for (int i = 0; i < iterations; ++i)
+        *found = Pathfinding_FindPath(
+            &bench_ctx,
+            map,
+            BENCH_START, BENCH_START,
+            BENCH_GOAL_TX, BENCH_GOAL_TY,
+            options,
+            &bench_path
+        );
+
+    return (bench_now_ms() - begin) / iterations;
+}
+
+/*
+    Random-map batch timed with 1, 2, 4, ... workers up to twice the
+    online core count. Speedup is relative to one worker.
+*/
+static void bench_batch_scaling(void)
+{
+    unsigned int state = 99;
+
+    build_random(&bench_map);
+    Map_UpdateComponents(&bench_map);
+
+    for (int i = 0; i < BENCH_BATCH_SIZE; ++i)
+    {
+        PathRequest *request = &bench_requests[i];
+
+        // Left edge to right edge so every query is long
+        request->start_tx = 0;
+        request->start_ty = (int)(bench_rand(&state) % BENCH_MAP_HEIGHT);
+        request->goal_tx = BENCH_MAP_WIDTH - 1;
+        request->goal_ty = (int)(bench_rand(&state) % BENCH_MAP_HEIGHT);
+        request->options = (PathOptions){0};
+
+        Map_SetWalkable(&bench_map, request->start_tx, request->start_ty, true);
+        Map_SetWalkable(&bench_map, request->goal_tx, request->goal_ty, true);
+    }
+
+    Map_UpdateComponents(&bench_map);
+
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (cores < 1)
+        cores = 1;
+
+    printf("\nBatch of %d queries, %ld online cores\n", BENCH_BATCH_SIZE, cores);
+    printf("%-8s %12s %9s\n", "workers", "batch ms", "speedup");
+
+    double single_ms = 0.0;
+
+    for (int workers = 1; workers <= 2 * cores; workers *= 2)
+    {
+        static PathWorkerPool pool;
+
+        if (!PathWorkerPool_Init(&pool, workers, BENCH_MAP_WIDTH * BENCH_MAP_HEIGHT))
+        {
+            fprintf(stderr, "Failed to start %d workers\n", workers);
+            return;
+        }
+
+        const int iterations = 3;
+        double begin = bench_now_ms();
+
+        for (int i = 0; i < iterations; ++i)
+            Pathfinding_FindPaths(&pool, &bench_map, bench_requests, BENCH_BATCH_SIZE, bench_results);
+
+        double batch_ms = (bench_now_ms() - begin) / iterations;
+
+        if (workers == 1)
+            single_ms = batch_ms;
+
+        printf("%-8d %12.3f %8.1fx\n", workers, batch_ms, single_ms / batch_ms);
+
+        PathWorkerPool_Free(&pool);
+    }
+}
+
+/*
+    A* and flood-fill (region relabel) throughput for each map storage
+    layout, on random maps of several sizes. Throughput is tiles
+    expanded or labelled per microsecond.
+*/
+static void bench_layouts(void)
+{
+    static const int sizes[] = { 256, 512, 1024 };
+
+    static const struct
+    {
+        const char *name;
+        MapLayout layout;
+    } layouts[] =
+    {
+        { "rows",     { 0 } },
+        { "8x8",      { .block_size = 8 } },
+        { "16x16",    { .block_size = 16 } },
+        { "8x8 z",    { .block_size = 8, .morton = true } },
+        { "16x16 z",  { .block_size = 16, .morton = true } },
+    };
+
+    static Map map;
+    static PathContext ctx;
+
+    const int max_size = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+
+    if (!PathContext_Init(&ctx, max_size * max_size))
+    {
+        fprintf(stderr, "Failed to allocate path context\n");
+        return;
+    }
+
+    printf("\nStorage layouts, random map\n");
+    printf("%-6s %-8s %10s %12s %12s %12s %12s\n",
+        "size", "layout", "exp", "a* ms", "exp/us", "flood ms", "tiles/us");
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        int size = sizes[s];
+
+        for (size_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); ++l)
+        {
+            unsigned int state = 42;
+
+            Map_Free(&map);
+
+            if (!Map_InitLayout(&map, size, size, &layouts[l].layout))
+            {
+                fprintf(stderr, "Failed to allocate map\n");
+                break;
+            }
+
+            for (int y = 0; y < size; y++)
+                for (int x = 0; x < size; x++)
+                    if (bench_rand(&state) % 100 < 20)
+                        Map_SetWalkable(&map, x, y, false);
+
+            Map_UpdateComponents(&map);
+
+            // A quarter of the way in, clear of small pockets at the
+            // corner, to the farthest tile on the diagonal it reaches
+            int start = size / 4;
+            int goal = size - 1;
+
+            Map_SetWalkable(&map, start, start, true);
+            Map_UpdateComponents(&map);
+
+            while (goal > start && !(Map_IsWalkable(&map, goal, goal) && Map_AreConnected(&map, start, start, goal, goal)))
+                goal--;
+
+            const int iterations = 5;
+            double begin = bench_now_ms();
+
+            for (int i = 0; i < iterations; ++i)
+                Pathfinding_FindPath(&ctx, &map, start, start, goal, goal, NULL, &bench_path);
+
+            double search_ms = (bench_now_ms() - begin) / iterations;
+            int expansions = ctx.expansions;
+
+            begin = bench_now_ms();
+
+            for (int i = 0; i < iterations; ++i)
+            {
+                map.components_dirty = true;
+                Map_UpdateComponents(&map);
+            }
+
+            double flood_ms = (bench_now_ms() - begin) / iterations;
+
+            printf("%-6d %-8s %10d %12.3f %12.1f %12.3f %12.1f\n",
+                size,
+                layouts[l].name,
+                expansions,
+                search_ms,
+                expansions / (search_ms * 1000.0),
+                flood_ms,
+                (double)size * size / (flood_ms * 1000.0));
+        }
+    }
+
+    Map_Free(&map);
+    PathContext_Free(&ctx);
+}
+
+/*
+    Long orders through the cluster graph on random maps from the game
+    map up to 1024x1024: the abstract search plus the first segment a
+    unit waits for, against a tile search of the whole route. The
+    segment is bounded by a sector, so only the abstract search grows
+    with the map.
+*/
+static void bench_clusters(void)
+{
+    static const int sizes[][2] = { { 20, 15 }, { 128, 128 }, { 512, 512 }, { 1024, 1024 } };
+
+    static Map map;
+    static PathContext ctx;
+    static ClusterGraph graph;
+    static ClusterPath abstract_path;
+
+    const int max_size = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1][0];
+
+    if (!PathContext_Init(&ctx, max_size * max_size))
+    {
+        fprintf(stderr, "Failed to allocate path context\n");
+        return;
+    }
+
+    printf("\nCluster graph, random map, corner to corner\n");
+    printf("%-10s %12s %10s %12s %12s %12s %12s\n",
+        "size", "build ms", "waypoints", "abstract ms", "segment ms", "order ms", "a* ms");
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        int width = sizes[s][0];
+        int height = sizes[s][1];
+        unsigned int state = 42;
+
+        Map_Free(&map);
+
+        if (!Map_Init(&map, width, height))
+        {
+            fprintf(stderr, "Failed to allocate map\n");
+            break;
+        }
+
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++)
+                if (bench_rand(&state) % 100 < 20)
+                    Map_SetWalkable(&map, x, y, false);
+
+        Map_SetWalkable(&map, 1, 1, true);
+        Map_UpdateComponents(&map);
+
+        // Farthest tile on the diagonal the corner reaches
+        int goal_tx = width - 1;
+        int goal_ty = height - 1;
+
+        while (goal_tx > 1 && goal_ty > 1 &&
+            !(Map_IsWalkable(&map, goal_tx, goal_ty) && Map_AreConnected(&map, 1, 1, goal_tx, goal_ty)))
+        {
+            goal_tx--;
+            goal_ty--;
+        }
+
+        double begin = bench_now_ms();
+
+        if (!ClusterGraph_Init(&graph, &map))
+        {
+            fprintf(stderr, "Failed to allocate cluster graph\n");
+            break;
+        }
+
+        double build_ms = bench_now_ms() - begin;
+
+        const int iterations = 20;
+        bool found = true;
+
+        begin = bench_now_ms();
+
+        for (int i = 0; i < iterations && found; ++i)
+            found = ClusterGraph_FindPath(&graph, &map, 1, 1, goal_tx, goal_ty, &abstract_path);
+
+        double abstract_ms = (bench_now_ms() - begin) / iterations;
+
+        begin = bench_now_ms();
+
+        for (int i = 0; i < iterations && found; ++i)
+            ClusterGraph_RefineSegment(&ctx, &map, &abstract_path, 0, &bench_path);
+
+        double segment_ms = (bench_now_ms() - begin) / iterations;
+
+        begin = bench_now_ms();
+
+        for (int i = 0; i < iterations; ++i)
+            Pathfinding_FindPath(&ctx, &map, 1, 1, goal_tx, goal_ty, NULL, &bench_path);
+
+        double search_ms = (bench_now_ms() - begin) / iterations;
+
+        char label[24];
+        snprintf(label, sizeof(label), "%dx%d", width, height);
+
+        printf("%-10s %12.3f %10d %12.3f %12.3f %12.3f %12.3f\n",
+            label,
+            build_ms,
+            found ? abstract_path.count : 0,
+            abstract_ms,
+            segment_ms,
+            abstract_ms + segment_ms,
+            search_ms);
+
+        ClusterGraph_Free(&graph);
+    }
+
+    Map_Free(&map);
+    PathContext_Free(&ctx);
+}
+
+/*
+    A 1024x1024 random map saved once, then loaded by mapping the
+    file, against building the same map tile by tile with Map_Init.
+*/
+static void bench_map_file(void)
+{
+    static Map map;
+    const char *path = "bench_map.rtsmap";
+    const int size = 1024;
+    unsigned int state = 42;
+
+    double begin = bench_now_ms();
+
+    if (!Map_Init(&map, size, size))
+    {
+        fprintf(stderr, "Failed to allocate map\n");
+        return;
+    }
+
+    for (int y = 0; y < size; y++)
+        for (int x = 0; x < size; x++)
+            if (bench_rand(&state) % 100 < 20)
+                Map_SetWalkable(&map, x, y, false);
+
+    double build_ms = bench_now_ms() - begin;
+
+    if (!MapFile_Save(&map, path))
+    {
+        fprintf(stderr, "Failed to write %s\n", path);
+        Map_Free(&map);
+        return;
+    }
+
+    Map_Free(&map);
+
+    const int iterations = 20;
+    bool loaded = true;
+
+    begin = bench_now_ms();
+
+    for (int i = 0; i < iterations && loaded; ++i)
+    {
+        loaded = MapFile_Load(&map, path);
+        Map_Free(&map);
+    }
+
+    double load_ms = (bench_now_ms() - begin) / iterations;
+
+    remove(path);
+
+    if (!loaded)
+    {
+        fprintf(stderr, "Failed to load %s\n", path);
+        return;
+    }
+
+    printf("\nMap file, %dx%d: built in %.3f ms, loaded in %.1f us\n",
+        size, size, build_ms, load_ms * 1000.0);
+}
+
+int main(void)
+{
+    const BenchMap maps[] =
+    {
+        { "empty",  build_empty  },
+        { "maze",   build_maze   },
+        { "random", build_random },
+        { "terrain", build_terrain },
+    };
+
+    const PathOptions heap_options = { .open_set = PATH_OPEN_SET_BINARY_HEAP };
+    const PathOptions scan_options = { .open_set = PATH_OPEN_SET_LINEAR_SCAN };
+    const PathOptions jps_options = { .algorithm = PATH_ALGORITHM_JPS };
+    const PathOptions alt_options = { .heuristic = PATH_HEURISTIC_LANDMARKS };
+    const PathOptions bidir_options = { .algorithm = PATH_ALGORITHM_BIDIRECTIONAL };
+    const PathOptions diagonal_options = { .connectivity = PATH_CONNECTIVITY_8 };
+    const PathOptions bucket_options = { .open_set = PATH_OPEN_SET_BUCKET_QUEUE };
+    const PathOptions smooth_options = { .smooth = true };
+
+    if (!PathContext_Init(&bench_ctx, BENCH_MAP_WIDTH * BENCH_MAP_HEIGHT))
+    {
+        fprintf(stderr, "Failed to allocate path context\n");
+        return 1;
+    }
+
+    printf("Pathfinding benchmark, %dx%d map\n", BENCH_MAP_WIDTH, BENCH_MAP_HEIGHT);
+    printf("%-8s %-6s %8s %12s %12s %9s %12s %10s %10s %12s %12s %10s %12s %9s %12s %12s %9s %12s\n",
+        "map", "found", "length", "heap ms", "scan ms", "speedup", "jps ms",
+        "exp", "alt exp", "alt ms", "lm build ms", "bidir exp", "bidir ms",
+        "8-dir len", "8-dir ms", "bucket ms", "waypoints", "smooth ms");
+
+    for (size_t m = 0; m < sizeof(maps) / sizeof(maps[0]); ++m)
+    {
+        maps[m].build(&bench_map);
+        Map_SetWalkable(&bench_map, BENCH_START, BENCH_START, true);
+        Map_SetWalkable(&bench_map, BENCH_GOAL_TX, BENCH_GOAL_TY, true);
+        Map_UpdateComponents(&bench_map);
+
+        double build_begin = bench_now_ms();
+        Map_UpdateLandmarks(&bench_map, INT_MAX);
+        double build_ms = bench_now_ms() - build_begin;
+
+        bool found = false;
+        double heap_ms = bench_run(&bench_map, &heap_options, 20, &found);
+        int length = bench_path.length;
+        int expansions = bench_ctx.expansions;
+        double scan_ms = bench_run(&bench_map, &scan_options, 2, &found);
+        double jps_ms = bench_run(&bench_map, &jps_options, 20, &found);
+        double alt_ms = bench_run(&bench_map, &alt_options, 20, &found);
+        int alt_expansions = bench_ctx.expansions;
+        double bidir_ms = bench_run(&bench_map, &bidir_options, 20, &found);
+        int bidir_expansions = bench_ctx.expansions;
+        double diagonal_ms = bench_run(&bench_map, &diagonal_options, 20, &found);
+        int diagonal_length = bench_path.length;
+        double bucket_ms = bench_run(&bench_map, &bucket_options, 20, &found);
+        double smooth_ms = bench_run(&bench_map, &smooth_options, 20, &found);
+        int waypoints = bench_path.length;
+
+        printf("%-8s %-6s %8d %12.3f %12.3f %8.1fx %12.3f %10d %10d %12.3f %12.3f %10d %12.3f %9d %12.3f %12.3f %9d %12.3f\n",
+            maps[m].name,
+            found ? "yes" : "no",
+            length,
+            heap_ms,
+            scan_ms,
+            scan_ms / heap_ms,
+            jps_ms,
+            expansions,
+            alt_expansions,
+            alt_ms,
+            build_ms,
+            bidir_expansions,
+            bidir_ms,
+            diagonal_length,
+            diagonal_ms,
+            bucket_ms,
+            waypoints,
+            smooth_ms);
+    }
+
+    // Same walled-in query with region labels treated as stale
+    build_walled(&bench_map);
+    Map_SetWalkable(&bench_map, BENCH_GOAL_TX, BENCH_GOAL_TY, true);
+    Map_UpdateComponents(&bench_map);
+
+    bool found = false;
+    double labelled_ms = bench_run(&bench_map, &heap_options, 20, &found);
+    bench_map.components_dirty = true;
+    double unlabelled_ms = bench_run(&bench_map, &heap_options, 20, &found);
+
+    printf("\nUnreachable goal: %.3f ms with region labels, %.3f ms without\n",
+        labelled_ms, unlabelled_ms);
+
+    bench_batch_scaling();
+    bench_layouts();
+    bench_clusters();
+    bench_map_file();
+
+    PathContext_Free(&bench_ctx);
+    Map_Free(&bench_map);
+
+    return 0;
+}
@@ -0,0 +1,807 @@
+#include "cluster.h"
+
+#include <stdlib.h>
+
+/*
+    Cluster module builds and searches the HPA* abstract graph.
+
+    Abstract node ids:
+    - cluster * CLUSTER_MAX_ENTRANCES + slot  -> entrance slot
+    - node_count - 2                          -> query start
+    - node_count - 1                          -> query goal
+
+    Edges:
+    - entrance -> entrance of the same sector, precomputed cost
+    - entrance -> adjacent entrance across a sector border, the cost
+      of the tile entered
+    - start/goal <-> entrances of their own sector, computed per query
+
+    Every edge costs what the tiles it enters cost (Map_GetCost), as
+    in the tile search, so the costs are directed.
+
+    It does NOT:
+    - Modify Map
+    - Track occupancy (refinement handles it)
+*/
+
+#define CLUSTER_TILE_COUNT (CLUSTER_SIZE * CLUSTER_SIZE)
+
+// neighbour offsets (Up, Right, Down, Left)
+static const int CLUSTER_OFFSETS[4][2] =
+{
+    { 0, -1 },
+    { 1,  0 },
+    { 0,  1 },
+    { -1, 0 }
+};
+
+static int Cluster_IndexOf(const ClusterGraph *graph, int tx, int ty)
+{
+    return (ty / CLUSTER_SIZE) * graph->clusters_x + tx / CLUSTER_SIZE;
+}
+
+static bool Cluster_IsInside(const ClusterGraph *graph, int tx, int ty)
+{
+    return tx >= 0 && ty >= 0 && tx < graph->width && ty < graph->height;
+}
+
+static bool Cluster_Contains(const Cluster *cluster, int tx, int ty)
+{
+    return tx >= cluster->x0 && tx < cluster->x0 + cluster->width &&
+           ty >= cluster->y0 && ty < cluster->y0 + cluster->height;
+}
+
+static int Cluster_FindEntrance(const Cluster *cluster, int tx, int ty)
+{
+    for (int i = 0; i < cluster->entrance_count; ++i)
+    {
+        if (cluster->entrance_tiles[i][0] == tx && cluster->entrance_tiles[i][1] == ty)
+            return i;
+    }
+
+    return -1;
+}
+
+// Corner tiles can sit on two borders; they are stored once
+static void Cluster_AddEntrance(Cluster *cluster, int tx, int ty)
+{
+    if (Cluster_FindEntrance(cluster, tx, ty) != -1)
+        return;
+
+    if (cluster->entrance_count >= CLUSTER_MAX_ENTRANCES)
+        return;
+
+    cluster->entrance_tiles[cluster->entrance_count][0] = tx;
+    cluster->entrance_tiles[cluster->entrance_count][1] = ty;
+    cluster->entrance_count++;
+}
+
+/*
+    Walks one border of a sector and places entrances on every run of
+    tiles that are walkable on both sides of the border.
+
+    The neighbouring sector scans the same tile pairs from its side,
+    so both sides agree on where entrances are without sharing state.
+*/
+static void Cluster_ScanBorder(
+    Cluster *cluster,
+    const Map *map,
+    int start_tx,
+    int start_ty,
+    int along_dx,
+    int along_dy,
+    int across_dx,
+    int across_dy,
+    int length)
+{
+    int run_start = -1;
+
+    for (int i = 0; i <= length; ++i)
+    {
+        bool open = false;
+
+        if (i < length)
+        {
+            int tx = start_tx + i * along_dx;
+            int ty = start_ty + i * along_dy;
+
+            open = Map_IsWalkable(map, tx, ty) &&
+                   Map_IsWalkable(map, tx + across_dx, ty + across_dy);
+        }
+
+        if (open && run_start == -1)
+            run_start = i;
+
+        if (open || run_start == -1)
+            continue;
+
+        int run_length = i - run_start;
+
+        if (run_length >= CLUSTER_ENTRANCE_SPLIT)
+        {
+            int last = i - 1;
+            Cluster_AddEntrance(cluster, start_tx + run_start * along_dx, start_ty + run_start * along_dy);
+            Cluster_AddEntrance(cluster, start_tx + last * along_dx, start_ty + last * along_dy);
+        }
+        else
+        {
+            int middle = run_start + (run_length - 1) / 2;
+            Cluster_AddEntrance(cluster, start_tx + middle * along_dx, start_ty + middle * along_dy);
+        }
+
+        run_start = -1;
+    }
+}
+
+// Open set entries of a sector walk: cost * CLUSTER_TILE_COUNT + local tile
+static void Cluster_WalkPush(int *heap, int *count, int key)
+{
+    int i = (*count)++;
+
+    while (i > 0 && heap[(i - 1) / 2] > key)
+    {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+
+    heap[i] = key;
+}
+
+static int Cluster_WalkPop(int *heap, int *count)
+{
+    int top = heap[0];
+    int last = heap[--(*count)];
+    int i = 0;
+
+    for (;;)
+    {
+        int child = 2 * i + 1;
+
+        if (child >= *count)
+            break;
+
+        if (child + 1 < *count && heap[child + 1] < heap[child])
+            child++;
+
+        if (heap[child] >= last)
+            break;
+
+        heap[i] = heap[child];
+        i = child;
+    }
+
+    if (*count > 0)
+        heap[i] = last;
+
+    return top;
+}
+
+/*
+    Cheapest walk restricted to one sector: Dijkstra where a step
+    costs what the tile it enters costs (Map_GetCost), as in the tile
+    search, so abstract routes price terrain the way refinement does.
+    dist is indexed by local tile (y - y0) * width + (x - x0), -1 = unreached.
+    The origin itself is always accepted so query endpoints can be seeded.
+*/
+static void Cluster_Walk(const Cluster *cluster, const Map *map, int origin_tx, int origin_ty, int *dist)
+{
+    // Stale entries stay queued, at most one per relaxed step
+    int heap[4 * CLUSTER_TILE_COUNT + 1];
+    int count = 0;
+
+    for (int i = 0; i < cluster->width * cluster->height; ++i)
+        dist[i] = -1;
+
+    int origin = (origin_ty - cluster->y0) * cluster->width + (origin_tx - cluster->x0);
+    dist[origin] = 0;
+    Cluster_WalkPush(heap, &count, origin);
+
+    while (count > 0)
+    {
+        int key = Cluster_WalkPop(heap, &count);
+        int local = key % CLUSTER_TILE_COUNT;
+
+        if (key / CLUSTER_TILE_COUNT > dist[local])
+            continue;
+
+        int tx = cluster->x0 + local % cluster->width;
+        int ty = cluster->y0 + local / cluster->width;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            int nx = tx + CLUSTER_OFFSETS[i][0];
+            int ny = ty + CLUSTER_OFFSETS[i][1];
+
+            if (!Cluster_Contains(cluster, nx, ny))
+                continue;
+
+            if (!Map_IsWalkable(map, nx, ny))
+                continue;
+
+            int next = (ny - cluster->y0) * cluster->width + (nx - cluster->x0);
+            int cost = dist[local] + Map_GetCost(map, nx, ny);
+
+            if (dist[next] != -1 && dist[next] <= cost)
+                continue;
+
+            dist[next] = cost;
+            Cluster_WalkPush(heap, &count, cost * CLUSTER_TILE_COUNT + next);
+        }
+    }
+}
+
+static int Cluster_LocalDistance(const Cluster *cluster, const int *dist, int tx, int ty)
+{
+    return dist[(ty - cluster->y0) * cluster->width + (tx - cluster->x0)];
+}
+
+static void Cluster_Rebuild(ClusterGraph *graph, const Map *map, int cluster_index)
+{
+    Cluster *cluster = &graph->clusters[cluster_index];
+    int x0 = cluster->x0;
+    int y0 = cluster->y0;
+    int x1 = x0 + cluster->width - 1;
+    int y1 = y0 + cluster->height - 1;
+
+    cluster->entrance_count = 0;
+    cluster->dirty = false;
+
+    if (y0 > 0)
+        Cluster_ScanBorder(cluster, map, x0, y0, 1, 0, 0, -1, cluster->width);
+
+    if (x1 < map->width - 1)
+        Cluster_ScanBorder(cluster, map, x1, y0, 0, 1, 1, 0, cluster->height);
+
+    if (y1 < map->height - 1)
+        Cluster_ScanBorder(cluster, map, x0, y1, 1, 0, 0, 1, cluster->width);
+
+    if (x0 > 0)
+        Cluster_ScanBorder(cluster, map, x0, y0, 0, 1, -1, 0, cluster->height);
+
+    int dist[CLUSTER_TILE_COUNT];
+
+    for (int i = 0; i < cluster->entrance_count; ++i)
+    {
+        Cluster_Walk(cluster, map, cluster->entrance_tiles[i][0], cluster->entrance_tiles[i][1], dist);
+
+        for (int j = 0; j < cluster->entrance_count; ++j)
+        {
+            cluster->distances[i][j] = Cluster_LocalDistance(
+                cluster, dist, cluster->entrance_tiles[j][0], cluster->entrance_tiles[j][1]);
+        }
+    }
+}
+
+static void Cluster_MarkDirty(ClusterGraph *graph, int cluster_index)
+{
+    Cluster *cluster = &graph->clusters[cluster_index];
+
+    if (cluster->dirty)
+        return;
+
+    cluster->dirty = true;
+    graph->dirty_list[graph->dirty_count++] = cluster_index;
+}
+
+static void Cluster_RefreshDirty(ClusterGraph *graph, const Map *map)
+{
+    for (int i = 0; i < graph->dirty_count; ++i)
+        Cluster_Rebuild(graph, map, graph->dirty_list[i]);
+
+    graph->dirty_count = 0;
+}
+
+bool ClusterGraph_Init(ClusterGraph *graph, const Map *map)
+{
+    graph->width = map->width;
+    graph->height = map->height;
+    graph->clusters_x = (map->width + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+    graph->clusters_y = (map->height + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+
+    int cluster_count = graph->clusters_x * graph->clusters_y;
+
+    graph->node_count = cluster_count * CLUSTER_MAX_ENTRANCES + 2;
+    graph->dirty_count = 0;
+    graph->generation = 0;
+
+    graph->clusters = calloc((size_t)cluster_count, sizeof(Cluster));
+    graph->dirty_list = malloc((size_t)cluster_count * sizeof(int));
+    graph->g_cost = malloc((size_t)graph->node_count * sizeof(int));
+    graph->f_cost = malloc((size_t)graph->node_count * sizeof(int));
+    graph->parent = malloc((size_t)graph->node_count * sizeof(int));
+    graph->heap_index = malloc((size_t)graph->node_count * sizeof(int));
+    graph->open_heap = malloc((size_t)graph->node_count * sizeof(int));
+    graph->stamp = calloc((size_t)graph->node_count, sizeof(unsigned int));
+    graph->closed = malloc((size_t)graph->node_count * sizeof(bool));
+
+    if (!graph->clusters || !graph->dirty_list || !graph->g_cost || !graph->f_cost ||
+        !graph->parent || !graph->heap_index || !graph->open_heap ||
+        !graph->stamp || !graph->closed)
+    {
+        ClusterGraph_Free(graph);
+        return false;
+    }
+
+    for (int cy = 0; cy < graph->clusters_y; ++cy)
+    {
+        for (int cx = 0; cx < graph->clusters_x; ++cx)
+        {
+            Cluster *cluster = &graph->clusters[cy * graph->clusters_x + cx];
+
+            cluster->x0 = cx * CLUSTER_SIZE;
+            cluster->y0 = cy * CLUSTER_SIZE;
+            cluster->width = map->width - cluster->x0 < CLUSTER_SIZE ? map->width - cluster->x0 : CLUSTER_SIZE;
+            cluster->height = map->height - cluster->y0 < CLUSTER_SIZE ? map->height - cluster->y0 : CLUSTER_SIZE;
+        }
+    }
+
+    for (int i = 0; i < cluster_count; ++i)
+        Cluster_Rebuild(graph, map, i);
+
+    return true;
+}
+
+void ClusterGraph_Free(ClusterGraph *graph)
+{
+    free(graph->clusters);
+    free(graph->dirty_list);
+    free(graph->g_cost);
+    free(graph->f_cost);
+    free(graph->parent);
+    free(graph->heap_index);
+    free(graph->open_heap);
+    free(graph->stamp);
+    free(graph->closed);
+
+    *graph = (ClusterGraph){0};
+}
+
+void ClusterGraph_MarkTileDirty(ClusterGraph *graph, int tx, int ty)
+{
+    if (!Cluster_IsInside(graph, tx, ty))
+        return;
+
+    int own = Cluster_IndexOf(graph, tx, ty);
+    Cluster_MarkDirty(graph, own);
+
+    // A border tile also decides where the neighbour's entrances go
+    for (int i = 0; i < 4; ++i)
+    {
+        int nx = tx + CLUSTER_OFFSETS[i][0];
+        int ny = ty + CLUSTER_OFFSETS[i][1];
+
+        if (!Cluster_IsInside(graph, nx, ny))
+            continue;
+
+        int other = Cluster_IndexOf(graph, nx, ny);
+
+        if (other != own)
+            Cluster_MarkDirty(graph, other);
+    }
+}
+
+void ClusterGraph_ApplyMapChanges(ClusterGraph *graph, const Map *map, MapChangeReader *reader)
+{
+    MapChange changes[64];
+    int count;
+
+    while ((count = Map_ReadChanges(map, reader, changes, 64)) > 0)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            const MapChange *change = &changes[i];
+
+            // Entrances depend on walkability, distances on cost too
+            if ((change->flags & (MAP_CHANGE_WALKABLE | MAP_CHANGE_COST)) == 0)
+                continue;
+
+            for (int ty = change->min_ty; ty <= change->max_ty; ++ty)
+                for (int tx = change->min_tx; tx <= change->max_tx; ++tx)
+                    ClusterGraph_MarkTileDirty(graph, tx, ty);
+        }
+    }
+}
+
+/*
+    Abstract open set: binary min-heap ordered by (f_cost, node id),
+    with decrease-key through heap_index. Same tie-breaking rule as
+    the tile-level search, so abstract routes are deterministic.
+*/
+static bool Cluster_HeapLess(const ClusterGraph *graph, int a, int b)
+{
+    if (graph->f_cost[a] != graph->f_cost[b])
+        return graph->f_cost[a] < graph->f_cost[b];
+
+    return a < b;
+}
+
+static void Cluster_HeapSwap(ClusterGraph *graph, int i, int j)
+{
+    int a = graph->open_heap[i];
+    int b = graph->open_heap[j];
+
+    graph->open_heap[i] = b;
+    graph->open_heap[j] = a;
+
+    graph->heap_index[b] = i;
+    graph->heap_index[a] = j;
+}
+
+static void Cluster_HeapSiftUp(ClusterGraph *graph, int i)
+{
+    while (i > 0)
+    {
+        int parent = (i - 1) / 2;
+
+        if (!Cluster_HeapLess(graph, graph->open_heap[i], graph->open_heap[parent]))
+            break;
+
+        Cluster_HeapSwap(graph, i, parent);
+        i = parent;
+    }
+}
+
+static int Cluster_HeapPop(ClusterGraph *graph, int *open_count)
+{
+    if (*open_count == 0)
+        return -1;
+
+    int top = graph->open_heap[0];
+    int count = --(*open_count);
+
+    if (count > 0)
+    {
+        graph->open_heap[0] = graph->open_heap[count];
+        graph->heap_index[graph->open_heap[0]] = 0;
+
+        int i = 0;
+
+        while (1)
+        {
+            int left = 2 * i + 1;
+            int right = left + 1;
+            int smallest = i;
+
+            if (left < count && Cluster_HeapLess(graph, graph->open_heap[left], graph->open_heap[smallest]))
+                smallest = left;
+
+            if (right < count && Cluster_HeapLess(graph, graph->open_heap[right], graph->open_heap[smallest]))
+                smallest = right;
+
+            if (smallest == i)
+                break;
+
+            Cluster_HeapSwap(graph, i, smallest);
+            i = smallest;
+        }
+    }
+
+    graph->heap_index[top] = -1;
+
+    return top;
+}
+
+/*
+    Per-query data: where start and goal sit and how far each is
+    from the entrances of its own sector.
+*/
+typedef struct
+{
+    int start_tx;
+    int start_ty;
+    int goal_tx;
+    int goal_ty;
+
+    int start_cluster;
+    int goal_cluster;
+
+    int start_dist[CLUSTER_MAX_ENTRANCES];
+    int goal_dist[CLUSTER_MAX_ENTRANCES];
+
+    // In-sector start -> goal distance when they share a sector, else -1
+    int direct_dist;
+} ClusterQuery;
+
+static void Cluster_NodeTile(const ClusterGraph *graph, const ClusterQuery *query, int node, int *tx, int *ty)
+{
+    if (node == graph->node_count - 2)
+    {
+        *tx = query->start_tx;
+        *ty = query->start_ty;
+        return;
+    }
+
+    if (node == graph->node_count - 1)
+    {
+        *tx = query->goal_tx;
+        *ty = query->goal_ty;
+        return;
+    }
+
+    const Cluster *cluster = &graph->clusters[node / CLUSTER_MAX_ENTRANCES];
+    int slot = node % CLUSTER_MAX_ENTRANCES;
+
+    *tx = cluster->entrance_tiles[slot][0];
+    *ty = cluster->entrance_tiles[slot][1];
+}
+
+static void Cluster_Relax(ClusterGraph *graph, const ClusterQuery *query, int *open_count, int from, int to, int cost)
+{
+    if (graph->stamp[to] != graph->generation)
+    {
+        graph->stamp[to] = graph->generation;
+        graph->closed[to] = false;
+        graph->heap_index[to] = -1;
+        graph->g_cost[to] = 0;
+    }
+
+    if (graph->closed[to])
+        return;
+
+    int tentative_g = graph->g_cost[from] + cost;
+    bool queued = graph->heap_index[to] != -1;
+
+    if (queued && tentative_g >= graph->g_cost[to])
+        return;
+
+    int tx;
+    int ty;
+    Cluster_NodeTile(graph, query, to, &tx, &ty);
+
+    graph->g_cost[to] = tentative_g;
+    graph->f_cost[to] = tentative_g + abs(tx - query->goal_tx) + abs(ty - query->goal_ty);
+    graph->parent[to] = from;
+
+    if (!queued)
+    {
+        int i = (*open_count)++;
+        graph->open_heap[i] = to;
+        graph->heap_index[to] = i;
+    }
+
+    Cluster_HeapSiftUp(graph, graph->heap_index[to]);
+}
+
+static void Cluster_Expand(ClusterGraph *graph, const Map *map, const ClusterQuery *query, int *open_count, int node)
+{
+    int start_node = graph->node_count - 2;
+    int goal_node = graph->node_count - 1;
+
+    if (node == start_node)
+    {
+        const Cluster *cluster = &graph->clusters[query->start_cluster];
+
+        for (int i = 0; i < cluster->entrance_count; ++i)
+        {
+            if (query->start_dist[i] >= 0)
+                Cluster_Relax(graph, query, open_count, node,
+                    query->start_cluster * CLUSTER_MAX_ENTRANCES + i, query->start_dist[i]);
+        }
+
+        if (query->direct_dist >= 0)
+            Cluster_Relax(graph, query, open_count, node, goal_node, query->direct_dist);
+
+        return;
+    }
+
+    int cluster_index = node / CLUSTER_MAX_ENTRANCES;
+    int slot = node % CLUSTER_MAX_ENTRANCES;
+    const Cluster *cluster = &graph->clusters[cluster_index];
+
+    // Intra-sector edges
+    for (int j = 0; j < cluster->entrance_count; ++j)
+    {
+        if (j != slot && cluster->distances[slot][j] >= 0)
+            Cluster_Relax(graph, query, open_count, node,
+                cluster_index * CLUSTER_MAX_ENTRANCES + j, cluster->distances[slot][j]);
+    }
+
+    // Inter-sector edges: entrance tiles facing each other across a border
+    int tx = cluster->entrance_tiles[slot][0];
+    int ty = cluster->entrance_tiles[slot][1];
+
+    for (int i = 0; i < 4; ++i)
+    {
+        int nx = tx + CLUSTER_OFFSETS[i][0];
+        int ny = ty + CLUSTER_OFFSETS[i][1];
+
+        if (!Cluster_IsInside(graph, nx, ny))
+            continue;
+
+        int other_index = Cluster_IndexOf(graph, nx, ny);
+
+        if (other_index == cluster_index)
+            continue;
+
+        int other_slot = Cluster_FindEntrance(&graph->clusters[other_index], nx, ny);
+
+        if (other_slot != -1)
+            Cluster_Relax(graph, query, open_count, node,
+                other_index * CLUSTER_MAX_ENTRANCES + other_slot, Map_GetCost(map, nx, ny));
+    }
+
+    if (cluster_index == query->goal_cluster && query->goal_dist[slot] >= 0)
+        Cluster_Relax(graph, query, open_count, node, goal_node, query->goal_dist[slot]);
+}
+
+static void Cluster_PrepareQuery(const ClusterGraph *graph, const Map *map, ClusterQuery *query)
+{
+    int dist[CLUSTER_TILE_COUNT];
+
+    query->start_cluster = Cluster_IndexOf(graph, query->start_tx, query->start_ty);
+    query->goal_cluster = Cluster_IndexOf(graph, query->goal_tx, query->goal_ty);
+
+    const Cluster *start_cluster = &graph->clusters[query->start_cluster];
+    const Cluster *goal_cluster = &graph->clusters[query->goal_cluster];
+
+    Cluster_Walk(start_cluster, map, query->start_tx, query->start_ty, dist);
+
+    for (int i = 0; i < start_cluster->entrance_count; ++i)
+    {
+        query->start_dist[i] = Cluster_LocalDistance(
+            start_cluster, dist, start_cluster->entrance_tiles[i][0], start_cluster->entrance_tiles[i][1]);
+    }
+
+    query->direct_dist = -1;
+
+    if (query->start_cluster == query->goal_cluster)
+        query->direct_dist = Cluster_LocalDistance(start_cluster, dist, query->goal_tx, query->goal_ty);
+
+    // A walk from the goal prices the tiles it enters; reversed, the
+    // entrance is left instead and the goal entered
+    Cluster_Walk(goal_cluster, map, query->goal_tx, query->goal_ty, dist);
+
+    for (int i = 0; i < goal_cluster->entrance_count; ++i)
+    {
+        int tx = goal_cluster->entrance_tiles[i][0];
+        int ty = goal_cluster->entrance_tiles[i][1];
+        int from_goal = Cluster_LocalDistance(goal_cluster, dist, tx, ty);
+
+        query->goal_dist[i] = from_goal < 0 ? -1 :
+            from_goal - Map_GetCost(map, tx, ty) + Map_GetCost(map, query->goal_tx, query->goal_ty);
+    }
+}
+
+/*
+    Writes the abstract route, dropping each sector's exit tile:
+    the next waypoint is the entry tile one step across the border,
+    so a refined segment spans one sector plus the crossing step.
+*/
+static bool Cluster_BuildWaypoints(const ClusterGraph *graph, const ClusterQuery *query, ClusterPath *out_path)
+{
+    int goal_node = graph->node_count - 1;
+    int start_node = graph->node_count - 2;
+
+    int reversed[CLUSTER_PATH_MAX];
+    int count = 0;
+    int next = -1;
+
+    for (int node = goal_node; node != -1; node = graph->parent[node])
+    {
+        bool is_exit = node != start_node && node != goal_node &&
+                       next != -1 && next != goal_node &&
+                       next / CLUSTER_MAX_ENTRANCES != node / CLUSTER_MAX_ENTRANCES;
+
+        next = node;
+
+        if (is_exit)
+            continue;
+
+        if (count >= CLUSTER_PATH_MAX)
+            return false;
+
+        reversed[count++] = node;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        Cluster_NodeTile(graph, query, reversed[count - 1 - i],
+            &out_path->waypoints[i][0], &out_path->waypoints[i][1]);
+    }
+
+    out_path->count = count;
+
+    return true;
+}
+
+bool ClusterGraph_FindPath(
+    ClusterGraph *graph,
+    const Map *map,
+    int start_tx,
+    int start_ty,
+    int goal_tx,
+    int goal_ty,
+    ClusterPath *out_path
+)
+{
+    out_path->count = 0;
+
+    if (!Map_IsInside(map, start_tx, start_ty) || !Map_IsInside(map, goal_tx, goal_ty))
+        return false;
+
+    if (!Map_IsWalkable(map, goal_tx, goal_ty))
+        return false;
+
+    if (!Map_AreConnected(map, start_tx, start_ty, goal_tx, goal_ty))
+        return false;
+
+    Cluster_RefreshDirty(graph, map);
+
+    ClusterQuery query;
+    query.start_tx = start_tx;
+    query.start_ty = start_ty;
+    query.goal_tx = goal_tx;
+    query.goal_ty = goal_ty;
+
+    Cluster_PrepareQuery(graph, map, &query);
+
+    // Same stale-on-generation scheme as PathContext
+    graph->generation++;
+
+    if (graph->generation == 0)
+    {
+        for (int i = 0; i < graph->node_count; ++i)
+            graph->stamp[i] = 0;
+
+        graph->generation = 1;
+    }
+
+    int start_node = graph->node_count - 2;
+    int goal_node = graph->node_count - 1;
+    int open_count = 0;
+
+    graph->stamp[start_node] = graph->generation;
+    graph->closed[start_node] = false;
+    graph->g_cost[start_node] = 0;
+    graph->f_cost[start_node] = abs(start_tx - goal_tx) + abs(start_ty - goal_ty);
+    graph->parent[start_node] = -1;
+    graph->open_heap[open_count++] = start_node;
+    graph->heap_index[start_node] = 0;
+
+    while (1)
+    {
+        int node = Cluster_HeapPop(graph, &open_count);
+
+        if (node == -1)
+            return false;
+
+        if (node == goal_node)
+            break;
+
+        graph->closed[node] = true;
+
+        Cluster_Expand(graph, map, &query, &open_count, node);
+    }
+
+    return Cluster_BuildWaypoints(graph, &query, out_path);
+}
+
+bool ClusterGraph_RefineSegment(
+    PathContext *ctx,
+    const Map *map,
+    const ClusterPath *abstract_path,
+    int segment,
+    Path *out_path
+)
+{
+    if (segment < 0 || segment + 1 >= abstract_path->count)
+        return false;
+
+    // Endpoints are at most one sector apart, but occupied tiles can
+    // close the way between them; the budget stops the search from
+    // flooding the rest of the map looking for another
+    Pathfinding_BeginSearch(
+        ctx,
+        map,
+        abstract_path->waypoints[segment][0],
+        abstract_path->waypoints[segment][1],
+        abstract_path->waypoints[segment + 1][0],
+        abstract_path->waypoints[segment + 1][1],
+        NULL
+    );
+
+    Pathfinding_StepSearch(ctx, map, CLUSTER_REFINE_BUDGET);
+
+    // A search still running has used up its budget
+    return Pathfinding_FinishSearch(ctx, out_path);
+}
@@ -0,0 +1,128 @@
+#ifndef CLUSTER_H
+#define CLUSTER_H
+
+#include <stdbool.h>
+#include "map.h"
+#include "pathfinding.h"
+
+/*
+Hierarchical pathfinding (HPA*) over fixed-size map clusters.
+
+The map is divided into CLUSTER_SIZE x CLUSTER_SIZE sectors.
+Where two sectors share a walkable border run, an entrance tile is
+placed on each side. Distances between entrances of the same sector
+are precomputed, giving a small abstract graph that long queries
+search instead of the tile grid. Distances are costs: each step costs
+what the tile it enters costs (Map_GetCost), as in the tile search.
+
+The abstract graph is built from terrain walkability and cost.
+Occupancy changes every time a unit steps, so it is left to the
+tile-level refinement, which treats occupied tiles as blocked.
+*/
+
+#define CLUSTER_SIZE 8
+
+// Runs at least this long get an entrance at both ends instead of the middle
+#define CLUSTER_ENTRANCE_SPLIT 6
+
+// At most CLUSTER_SIZE / 2 runs fit on one border, four borders per sector
+#define CLUSTER_MAX_ENTRANCES (4 * (CLUSTER_SIZE / 2))
+
+// Upper bound on waypoints in an abstract path
+#define CLUSTER_PATH_MAX 1024
+
+// Node expansions a refined segment may use: the two sectors it spans
+// twice over, room for detours around units without leaving the area
+#define CLUSTER_REFINE_BUDGET (4 * CLUSTER_SIZE * CLUSTER_SIZE)
+
+typedef struct
+{
+    // Tile rectangle covered by this sector
+    int x0;
+    int y0;
+    int width;
+    int height;
+
+    int entrance_count;
+    int entrance_tiles[CLUSTER_MAX_ENTRANCES][2];
+
+    // Cheapest in-sector walk from entrance [i] to [j], -1 if none
+    int distances[CLUSTER_MAX_ENTRANCES][CLUSTER_MAX_ENTRANCES];
+
+    // Set by ClusterGraph_MarkTileDirty, cleared on rebuild
+    bool dirty;
+} Cluster;
+
+typedef struct
+{
+    // Size of the map the graph was built for
+    int width;
+    int height;
+
+    int clusters_x;
+    int clusters_y;
+    Cluster *clusters;
+
+    // Sectors waiting for a rebuild before the next query
+    int *dirty_list;
+    int dirty_count;
+
+    // Abstract search scratch, one entry per abstract node
+    // (every entrance slot of every sector, plus start and goal)
+    int node_count;
+    int *g_cost;
+    int *f_cost;
+    int *parent;
+    int *heap_index;
+    int *open_heap;
+    unsigned int *stamp;
+    bool *closed;
+    unsigned int generation;
+} ClusterGraph;
+
+/*
+Abstract route: start tile, the tile where each crossed sector is
+entered, goal tile. Consecutive waypoints are at most one sector
+apart and are refined to tiles one segment at a time.
+*/
+typedef struct
+{
+    int waypoints[CLUSTER_PATH_MAX][2];
+    int count;
+} ClusterPath;
+
+// Allocates and builds every sector. Returns false on allocation failure.
+bool ClusterGraph_Init(ClusterGraph *graph, const Map *map);
+void ClusterGraph_Free(ClusterGraph *graph);
+
+// Must be called after a tile's walkability or cost changes.
+// Affected sectors are rebuilt lazily on the next query.
+void ClusterGraph_MarkTileDirty(ClusterGraph *graph, int tx, int ty);
+
+// Marks the tiles of every walkability or cost change the reader has not seen
+// yet, draining the map's change log once per tick instead of being
+// told about each tile.
+void ClusterGraph_ApplyMapChanges(ClusterGraph *graph, const Map *map, MapChangeReader *reader);
+
+// Searches the abstract graph. Returns false if no route exists.
+bool ClusterGraph_FindPath(
+    ClusterGraph *graph,
+    const Map *map,
+    int start_tx,
+    int start_ty,
+    int goal_tx,
+    int goal_ty,
+    ClusterPath *out_path
+);
+
+// Refines abstract segment [segment, segment + 1] into tiles. Fails
+// if no route is found within CLUSTER_REFINE_BUDGET expansions.
+bool ClusterGraph_RefineSegment(
+    PathContext *ctx,
+    const Map *map,
+    const ClusterPath *abstract_path,
+    int segment,
+    Path *out_path
+);
+
+#endif
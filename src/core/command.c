@@ -1,40 +1,167 @@
-#include "raylib.h"
+#include <stddef.h>
 #include "command.h"
+#include "trace.h"
 
 //Clears the unit's movement queue.
-static void ClearMovementQueue(Unit *unit)
+static void ClearMovementQueue(Unit *unit, Map *map, PathScheduler *scheduler)
 {
-	unit->movement.count = 0;
-	unit->movement.current_index = 0;
+	if (unit->flow)
+	{
+		// Flow steps claim their target tile up front; give it back
+		if (unit->moving)
+			Map_SetOccupied(map, unit->target_tx, unit->target_ty, false);
+
+		unit->target_claimed = false;
+
+		FlowField_Release(unit->flow);
+		unit->flow = NULL;
+	}
+	else if (unit->cooperative && unit->moving)
+	{
+		// Cooperative steps hand their tile over on departure; take it back
+		Map_SetOccupied(map, unit->target_tx, unit->target_ty, false);
+		Map_SetOccupied(map, unit->tx, unit->ty, true);
+		unit->holds_tile = true;
+		unit->target_claimed = false;
+	}
+
+	// A newer order replaces any search still queued for the unit
+	PathScheduler_Cancel(scheduler, unit);
+	unit->abstract_segment = -1;
+
+	Unit_ClearPath(unit);
 	unit->moving = false;
 }
 
-void Command_MoveUnit(Unit *unit, Map *map, int target_tx, int target_ty, Path *debug_out)
+void Command_MoveUnit(
+    Unit *unit,
+    Map *map,
+    PathScheduler *scheduler,
+    int target_tx,
+    int target_ty,
+    PathDebug *debug_out
+)
 {
-	ClearMovementQueue(unit);
+	ClearMovementQueue(unit, map, scheduler);
 
-    Path path;
+    // Planned against the reservation table as the unit moves
+    if (unit->cooperative)
+    {
+        Unit_SetCooperativeGoal(unit, target_tx, target_ty);
+        TRACE_EVENT(TRACE_EVENT_COOPERATIVE_ORDER, 0, unit->id, target_tx, target_ty, 0);
+        return;
+    }
 
-    bool found = Pathfinding_FindPath(map, unit->tx, unit->ty, target_tx, target_ty, &path);
+    // Planned on the first blockage, once the route is known
+    if (unit->replanner)
+        Replanner_SetGoal(unit->replanner, target_tx, target_ty);
 
-    if (debug_out) *debug_out = path;  // copy even on failure; clears stale overlay
+    if (!PathScheduler_Submit(scheduler, map, unit, target_tx, target_ty, debug_out))
+    {
+        TRACE_EVENT(TRACE_EVENT_ORDER_DROPPED, 0, unit->id, target_tx, target_ty, 0);
+        return;
+    }
 
-    if (!found)
-    	return;
+    TRACE_EVENT(TRACE_EVENT_MOVE_ORDER, 0, unit->id, target_tx, target_ty, 0);
+}
+
+/*
+    Smallest radius r whose diamond of 2r^2 + 2r + 1 tiles holds the group.
+    Units stop once blocked this close to the goal.
+*/
+static int GroupArriveDistance(int unit_count)
+{
+    int radius = 0;
+
+    while (2 * radius * radius + 2 * radius + 1 < unit_count)
+        radius++;
 
-    // Copy path into movement queue
-    // Skip index 0 because that is the unit's current tile
+    return radius;
+}
+
+/*
+    Walkable tile number 'slot' in order of Manhattan distance from the
+    target, walking each diamond ring clockwise from its top corner.
+    Cooperative units need a tile each: two units sharing a goal would
+    keep claiming it from each other.
+    Returns false if the rings run off the map first.
+*/
+static bool GroupGoalTile(const Map *map, int target_tx, int target_ty, int slot, int *out_tx, int *out_ty)
+{
+    int found = 0;
+    int max_radius = map->width + map->height;
 
-    for (int i = 1; i < path.length; ++i)
+    for (int radius = 0; radius <= max_radius; ++radius)
     {
-    	if (unit->movement.count >= MAX_PATH_LENGTH)
-    		break;
+        int ring = radius == 0 ? 1 : 4 * radius;
 
-    	unit->movement.tiles[unit->movement.count][0] = path.tiles[i][0];
-    	unit->movement.tiles[unit->movement.count][1] = path.tiles[i][1];
+        for (int i = 0; i < ring; ++i)
+        {
+            int side = radius == 0 ? 0 : i / radius;
+            int step = radius == 0 ? 0 : i % radius;
+            int dx;
+            int dy;
 
-    	unit->movement.count++;
+            switch (side)
+            {
+                case 0: dx = step;           dy = -radius + step; break;
+                case 1: dx = radius - step;  dy = step;           break;
+                case 2: dx = -step;          dy = radius - step;  break;
+                default: dx = -radius + step; dy = -step;         break;
+            }
+
+            if (!Map_IsWalkable(map, target_tx + dx, target_ty + dy))
+                continue;
+
+            if (found++ == slot)
+            {
+                *out_tx = target_tx + dx;
+                *out_ty = target_ty + dy;
+                return true;
+            }
+        }
     }
 
-    TraceLog(LOG_INFO, "Path length: %d", path.length);
+    return false;
+}
+
+void Command_MoveGroup(
+    Unit *units,
+    int unit_count,
+    Map *map,
+    PathScheduler *scheduler,
+    FlowFieldCache *flow_cache,
+    int target_tx,
+    int target_ty
+)
+{
+    // Fields hold route costs; terrain around the goal is priced like the goal
+    int arrive_distance = GroupArriveDistance(unit_count) * Map_GetCost(map, target_tx, target_ty);
+    int cooperative_slot = 0;
+
+    for (int i = 0; i < unit_count; ++i)
+    {
+        Unit *unit = &units[i];
+
+        if (unit->cooperative)
+        {
+            int goal_tx;
+            int goal_ty;
+
+            if (GroupGoalTile(map, target_tx, target_ty, cooperative_slot++, &goal_tx, &goal_ty))
+                Command_MoveUnit(unit, map, scheduler, goal_tx, goal_ty, NULL);
+
+            continue;
+        }
+
+        ClearMovementQueue(unit, map, scheduler);
+
+        // One reference per unit; released as each unit arrives
+        unit->flow = FlowFieldCache_Acquire(flow_cache, map, target_tx, target_ty);
+        unit->flow_arrive_distance = arrive_distance;
+        unit->flow_wait_time = 0.0f;
+
+        if (unit->flow == NULL)
+            Command_MoveUnit(unit, map, scheduler, target_tx, target_ty, NULL);
+    }
 }
@@ -4,10 +4,38 @@
 #include "unit.h"
 #include "map.h"
 #include "pathfinding.h"
+#include "flowfield.h"
+#include "pathsched.h"
 
 // Issue a move command to a unit.
-// Builds a straight-line (Manhattan) path from current tile.
-// to the target tile and stores it inside the unit movement queue
-void Command_MoveUnit(Unit *unit, Map *map, int target_tx, int target_ty, Path *debug_out);
+// The path search is queued on the scheduler and the unit waits
+// with path_pending set until it completes. Units with a replanner
+// are also retargeted; it plans on the first blockage along the
+// scheduled route. Cooperative units skip the scheduler and plan
+// against their reservation table as they move.
+// debug_out is optional; when set it receives the search trace
+void Command_MoveUnit(
+    Unit *unit,
+    Map *map,
+    PathScheduler *scheduler,
+    int target_tx,
+    int target_ty,
+    PathDebug *debug_out
+);
+
+// Issue the same move command to a group of units.
+// Units share one cached flow field toward the target instead of
+// searching individually. Falls back to per-unit paths if the
+// flow field cache is full. Cooperative units are given a tile
+// each around the target and plan against their reservation table.
+void Command_MoveGroup(
+    Unit *units,
+    int unit_count,
+    Map *map,
+    PathScheduler *scheduler,
+    FlowFieldCache *flow_cache,
+    int target_tx,
+    int target_ty
+);
 
 #endif
@@ -0,0 +1,345 @@
+#include "flowfield.h"
+
+#include <limits.h>
+#include <stdlib.h>
+
+/*
+    Flow field module.
+
+    It owns:
+    - Field storage (fixed number of slots)
+    - Goal-keyed sharing and reference counts
+
+    It does NOT:
+    - Move units
+    - Modify Map
+*/
+
+// neighbour offsets (Up, Right, Down, Left)
+static const int FLOW_OFFSETS[4][2] =
+{
+    { 0, -1 },
+    { 1,  0 },
+    { 0,  1 },
+    { -1, 0 }
+};
+
+static int FlowField_Index(const FlowField *field, int tx, int ty)
+{
+    return ty * field->width + tx;
+}
+
+static bool FlowField_IsInside(const FlowField *field, int tx, int ty)
+{
+    return tx >= 0 && ty >= 0 && tx < field->width && ty < field->height;
+}
+
+// Heap order: lower cost first, lower tile index on ties
+static bool FlowField_Before(const int *integration, int a, int b)
+{
+    if (integration[a] != integration[b])
+        return integration[a] < integration[b];
+
+    return a < b;
+}
+
+static void FlowField_HeapSwap(int *heap, int *slots, int a, int b)
+{
+    int tile = heap[a];
+
+    heap[a] = heap[b];
+    heap[b] = tile;
+    slots[heap[a]] = a;
+    slots[heap[b]] = b;
+}
+
+static void FlowField_HeapUp(int *heap, int *slots, const int *integration, int slot)
+{
+    while (slot > 0)
+    {
+        int parent = (slot - 1) / 2;
+
+        if (!FlowField_Before(integration, heap[slot], heap[parent]))
+            break;
+
+        FlowField_HeapSwap(heap, slots, slot, parent);
+        slot = parent;
+    }
+}
+
+static void FlowField_HeapDown(int *heap, int *slots, const int *integration, int count, int slot)
+{
+    for (;;)
+    {
+        int best = slot;
+        int left = 2 * slot + 1;
+        int right = left + 1;
+
+        if (left < count && FlowField_Before(integration, heap[left], heap[best]))
+            best = left;
+
+        if (right < count && FlowField_Before(integration, heap[right], heap[best]))
+            best = right;
+
+        if (best == slot)
+            break;
+
+        FlowField_HeapSwap(heap, slots, slot, best);
+        slot = best;
+    }
+}
+
+/*
+    Integration pass: Dijkstra from the goal over walkable tiles. A step
+    costs what the tile it enters costs (Map_GetCost), as in the path
+    search, so a tile's value is the cost of its cheapest route.
+    Direction pass: each tile points at the neighbour its cheapest route
+    enters first, first in Up/Right/Down/Left order on ties, so fields
+    are deterministic.
+*/
+static void FlowField_Build(FlowField *field, FlowFieldCache *cache, const Map *map, int goal_tx, int goal_ty)
+{
+    int *heap = cache->queue;
+    int *slots = cache->heap_slots;
+    int count = 0;
+
+    field->goal_tx = goal_tx;
+    field->goal_ty = goal_ty;
+    field->width = map->width;
+    field->height = map->height;
+    field->map_revision = Map_GetWalkabilityRevision(map);
+    field->valid = true;
+
+    for (int i = 0; i < Map_TileCount(map); ++i)
+    {
+        field->integration[i] = FLOW_FIELD_UNREACHABLE;
+        field->directions[i] = FLOW_DIR_NONE;
+        slots[i] = -1;
+    }
+
+    int goal_index = FlowField_Index(field, goal_tx, goal_ty);
+    field->integration[goal_index] = 0;
+    field->directions[goal_index] = FLOW_DIR_GOAL;
+    heap[count] = goal_index;
+    slots[goal_index] = count++;
+
+    while (count > 0)
+    {
+        int index = heap[0];
+
+        FlowField_HeapSwap(heap, slots, 0, --count);
+        slots[index] = -1;
+        FlowField_HeapDown(heap, slots, field->integration, count, 0);
+
+        int tx = index % map->width;
+        int ty = index / map->width;
+
+        // Reaching this tile from a neighbour means entering it
+        int step_cost = field->integration[index] + Map_GetCost(map, tx, ty);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            int nx = tx + FLOW_OFFSETS[i][0];
+            int ny = ty + FLOW_OFFSETS[i][1];
+
+            if (!Map_IsWalkable(map, nx, ny))
+                continue;
+
+            int next = FlowField_Index(field, nx, ny);
+            int known = field->integration[next];
+
+            if (known != FLOW_FIELD_UNREACHABLE && known <= step_cost)
+                continue;
+
+            field->integration[next] = step_cost;
+
+            if (known == FLOW_FIELD_UNREACHABLE)
+            {
+                heap[count] = next;
+                slots[next] = count++;
+            }
+
+            FlowField_HeapUp(heap, slots, field->integration, slots[next]);
+        }
+    }
+
+    for (int ty = 0; ty < map->height; ++ty)
+    {
+        for (int tx = 0; tx < map->width; ++tx)
+        {
+            int index = FlowField_Index(field, tx, ty);
+
+            if (field->integration[index] <= 0)
+                continue;
+
+            int best_cost = INT_MAX;
+
+            for (int i = 0; i < 4; ++i)
+            {
+                int nx = tx + FLOW_OFFSETS[i][0];
+                int ny = ty + FLOW_OFFSETS[i][1];
+
+                if (!Map_IsInside(map, nx, ny))
+                    continue;
+
+                int remaining = field->integration[FlowField_Index(field, nx, ny)];
+
+                if (remaining == FLOW_FIELD_UNREACHABLE)
+                    continue;
+
+                int cost = remaining + Map_GetCost(map, nx, ny);
+
+                if (cost < best_cost)
+                {
+                    best_cost = cost;
+                    field->directions[index] = (unsigned char)i;
+                }
+            }
+        }
+    }
+}
+
+bool FlowFieldCache_Init(FlowFieldCache *cache, int node_count)
+{
+    cache->fields = calloc(FLOW_FIELD_CACHE_SIZE, sizeof(FlowField));
+    cache->queue = malloc((size_t)node_count * sizeof(int));
+    cache->heap_slots = malloc((size_t)node_count * sizeof(int));
+    cache->node_count = node_count;
+    cache->use_clock = 0;
+
+    if (cache->fields == NULL || cache->queue == NULL || cache->heap_slots == NULL)
+    {
+        FlowFieldCache_Free(cache);
+        return false;
+    }
+
+    for (int i = 0; i < FLOW_FIELD_CACHE_SIZE; ++i)
+    {
+        FlowField *field = &cache->fields[i];
+
+        field->integration = malloc((size_t)node_count * sizeof(int));
+        field->directions = malloc((size_t)node_count);
+
+        if (field->integration == NULL || field->directions == NULL)
+        {
+            FlowFieldCache_Free(cache);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void FlowFieldCache_Free(FlowFieldCache *cache)
+{
+    if (cache->fields != NULL)
+    {
+        for (int i = 0; i < FLOW_FIELD_CACHE_SIZE; ++i)
+        {
+            free(cache->fields[i].integration);
+            free(cache->fields[i].directions);
+        }
+    }
+
+    free(cache->fields);
+    free(cache->queue);
+    free(cache->heap_slots);
+
+    cache->fields = NULL;
+    cache->queue = NULL;
+    cache->heap_slots = NULL;
+    cache->node_count = 0;
+}
+
+FlowField *FlowFieldCache_Acquire(FlowFieldCache *cache, const Map *map, int goal_tx, int goal_ty)
+{
+    if (!Map_IsWalkable(map, goal_tx, goal_ty))
+        return NULL;
+
+    if (Map_TileCount(map) > cache->node_count)
+        return NULL;
+
+    FlowField *victim = NULL;
+
+    for (int i = 0; i < FLOW_FIELD_CACHE_SIZE; ++i)
+    {
+        FlowField *field = &cache->fields[i];
+
+        if (field->valid && field->goal_tx == goal_tx && field->goal_ty == goal_ty &&
+            field->width == map->width && field->height == map->height)
+        {
+            // Built before a terrain edit: bring it up to date in place
+            if (field->map_revision != Map_GetWalkabilityRevision(map))
+                FlowField_Build(field, cache, map, goal_tx, goal_ty);
+
+            field->ref_count++;
+            field->last_used = ++cache->use_clock;
+            return field;
+        }
+
+        if (field->ref_count > 0)
+            continue;
+
+        // Prefer empty slots, then the least recently used free one
+        if (victim == NULL ||
+            (victim->valid && (!field->valid || field->last_used < victim->last_used)))
+        {
+            victim = field;
+        }
+    }
+
+    if (victim == NULL)
+        return NULL;
+
+    FlowField_Build(victim, cache, map, goal_tx, goal_ty);
+    victim->ref_count = 1;
+    victim->last_used = ++cache->use_clock;
+
+    return victim;
+}
+
+void FlowField_Release(FlowField *field)
+{
+    if (field->ref_count > 0)
+        field->ref_count--;
+}
+
+void FlowFieldCache_Invalidate(FlowFieldCache *cache, const Map *map)
+{
+    for (int i = 0; i < FLOW_FIELD_CACHE_SIZE; ++i)
+    {
+        FlowField *field = &cache->fields[i];
+
+        if (!field->valid || field->map_revision == Map_GetWalkabilityRevision(map))
+            continue;
+
+        if (field->ref_count == 0)
+            field->valid = false;
+        else
+            FlowField_Build(field, cache, map, field->goal_tx, field->goal_ty);
+    }
+}
+
+int FlowField_GetDistance(const FlowField *field, int tx, int ty)
+{
+    if (!FlowField_IsInside(field, tx, ty))
+        return FLOW_FIELD_UNREACHABLE;
+
+    return field->integration[FlowField_Index(field, tx, ty)];
+}
+
+bool FlowField_NextTile(const FlowField *field, int tx, int ty, int *out_tx, int *out_ty)
+{
+    if (!FlowField_IsInside(field, tx, ty))
+        return false;
+
+    unsigned char dir = field->directions[FlowField_Index(field, tx, ty)];
+
+    if (dir == FLOW_DIR_NONE || dir == FLOW_DIR_GOAL)
+        return false;
+
+    *out_tx = tx + FLOW_OFFSETS[dir][0];
+    *out_ty = ty + FLOW_OFFSETS[dir][1];
+
+    return true;
+}
@@ -0,0 +1,104 @@
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include <stdbool.h>
+#include "map.h"
+
+/*
+Flow field for group movement.
+
+One Dijkstra pass from the goal gives every tile the cost of its
+cheapest route to the goal (integration field) and the neighbour that
+route enters first (direction field). Steps cost what the tile entered
+costs, as in the path search, so units go around swamps when a longer
+road is cheaper. Any number of units ordered to the same tile can then
+follow the field instead of running their own searches.
+
+Fields are built from terrain walkability and cost only, and remember
+the map's walkability revision they were built at. Occupancy changes
+as the group moves, so units check it step by step while following.
+*/
+
+// Number of distinct goals that can be cached at once
+#define FLOW_FIELD_CACHE_SIZE 8
+
+#define FLOW_FIELD_UNREACHABLE -1
+
+// Direction codes stored per tile
+#define FLOW_DIR_NONE 255  // unreachable
+#define FLOW_DIR_GOAL 254  // this is the goal tile
+
+typedef struct
+{
+    int goal_tx;
+    int goal_ty;
+
+    // Units currently following this field
+    int ref_count;
+
+    // Slot holds a built field
+    bool valid;
+
+    // Use stamp for evicting the least recently acquired free slot
+    unsigned int last_used;
+
+    // Size and walkability revision of the map the field was built on
+    int width;
+    int height;
+    unsigned int map_revision;
+
+    // Route cost to goal per tile, FLOW_FIELD_UNREACHABLE if none
+    int *integration;
+
+    // Index into the Up/Right/Down/Left offsets, or FLOW_DIR_*
+    unsigned char *directions;
+} FlowField;
+
+/*
+Fixed set of field slots keyed by goal tile.
+Identical orders share one field; a slot can only be reused once
+nothing references it.
+*/
+typedef struct
+{
+    FlowField *fields;
+    unsigned int use_clock;
+
+    // Tiles every slot has room for
+    int node_count;
+
+    // Open set shared by every build: a binary heap of tiles, and each
+    // tile's position in it, -1 when not queued
+    int *queue;
+    int *heap_slots;
+} FlowFieldCache;
+
+// Allocates the field slots, each for maps of up to node_count tiles.
+// Returns false on allocation failure.
+bool FlowFieldCache_Init(FlowFieldCache *cache, int node_count);
+void FlowFieldCache_Free(FlowFieldCache *cache);
+
+/*
+Returns a field leading to the goal with one reference added,
+building it if no cached field matches. A matching field built before
+the map's last terrain edit is rebuilt in place first.
+Returns NULL if the goal is invalid, the map has more tiles than
+the slots have room for, or every slot is referenced.
+*/
+FlowField *FlowFieldCache_Acquire(FlowFieldCache *cache, const Map *map, int goal_tx, int goal_ty);
+
+// Drops one reference. The field stays cached for later orders.
+void FlowField_Release(FlowField *field);
+
+// Catches fields up with terrain edits: out-of-date fields that are
+// referenced are rebuilt in place, unreferenced ones are dropped.
+void FlowFieldCache_Invalidate(FlowFieldCache *cache, const Map *map);
+
+// Route cost remaining from a tile, FLOW_FIELD_UNREACHABLE if none.
+int FlowField_GetDistance(const FlowField *field, int tx, int ty);
+
+// Writes the next tile toward the goal.
+// Returns false at the goal or on unreachable tiles.
+bool FlowField_NextTile(const FlowField *field, int tx, int ty, int *out_tx, int *out_ty);
+
+#endif
@@ -5,6 +5,14 @@
 #include "map.h"
 #include "unit.h"
 #include "pathfinding.h"
+#include "flowfield.h"
+#include "pathcache.h"
+#include "replan.h"
+#include "pathsched.h"
+#include "cluster.h"
+#include "pathstats.h"
+#include "reservation.h"
+#include "route.h"
 
 typedef struct {
 	bool has_move_order;
@@ -17,8 +25,43 @@ typedef struct {
 	Unit player_unit;
 	float time;
 
+	// Scratch storage reused by every path search
+	PathContext path_context;
+
+	// Counters and search times of every search run on path_context
+	PathStats path_stats;
+
+	// Recent path results, reused for repeated orders
+	PathCache path_cache;
+
+	// Move orders waiting for their search, advanced a slice per tick
+	PathScheduler path_scheduler;
+
+	// Sector graph long move orders are planned on, and the read
+	// position in the map's change log it catches up from
+	ClusterGraph clusters;
+	MapChangeReader cluster_changes;
+
+	// Abstract route of the player unit's current long order
+	ClusterPath player_abstract_path;
+
+	// Incremental planner attached to the player unit
+	Replanner player_replanner;
+
+	// Movement queues of every unit
+	RoutePool routes;
+
+	// Shared flow fields for group move orders
+	FlowFieldCache flow_cache;
+
+	// Claimed (tile, step) pairs of cooperative units, and the search
+	// they plan with; units opt in by pointing cooperative at it
+	ReservationTable reservations;
+	CooperativeSearch cooperative_search;
+
 	// debug pathfinding
-	Path debug_last_path;
+	// Trace of the last search, only recorded while the overlay is on
+	PathDebug debug_last_search;
 	bool debug_draw_pathfinding;
 
 	PendingInput input;
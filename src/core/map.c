@@ -1,9 +1,15 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "map.h"
 
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
 /*
     Map module owns spatial grid.
     It provides:
-    - Initialization
+    - Initialization and the storage of every per-tile layer
     - Boundary checks
     - Coordinate conversions
 
@@ -12,26 +18,662 @@
     - Handle input
 */
 
-void Map_Init(Map *map)
+// neighbour offsets (Up, Right, Down, Left)
+static const int MAP_OFFSETS[4][2] =
+{
+    { 0, -1 },
+    { 1,  0 },
+    { 0,  1 },
+    { -1, 0 }
+};
+
+_Static_assert((MAP_CHANGE_LOG_SIZE & (MAP_CHANGE_LOG_SIZE - 1)) == 0, "change log size must be a power of two");
+
+// Spreads the low four bits of value onto the even bit positions
+static int Map_MortonSpread(int value)
+{
+    value = (value | (value << 2)) & 0x33;
+    value = (value | (value << 1)) & 0x55;
+
+    return value;
+}
+
+// Gathers the even bit positions of value back into four bits
+static int Map_MortonCompact(int value)
+{
+    value &= 0x55;
+    value = (value | (value >> 1)) & 0x33;
+    value = (value | (value >> 2)) & 0x0F;
+
+    return value;
+}
+
+/*
+    Position of a tile in the tile, bit and region layers. Blocked
+    layouts store whole blocks one after another, a row of blocks at
+    a time; within a block tiles go row by row or along a Z-order
+    curve. The tile must be inside.
+*/
+static int Map_StorageIndex(const Map *map, int tx, int ty)
+{
+    if (map->block_shift == 0)
+        return ty * map->width + tx;
+
+    int shift = map->block_shift;
+    int mask = map->layout.block_size - 1;
+    int block = (ty >> shift) * map->blocks_per_row + (tx >> shift);
+    int local_x = tx & mask;
+    int local_y = ty & mask;
+    int local = map->layout.morton ?
+        Map_MortonSpread(local_x) | (Map_MortonSpread(local_y) << 1) :
+        (local_y << shift) | local_x;
+
+    return (block << (2 * shift)) | local;
+}
+
+// Tile at a storage position; may be padding outside the map
+static void Map_StorageTile(const Map *map, int index, int *out_tx, int *out_ty)
+{
+    if (map->block_shift == 0)
+    {
+        *out_tx = index % map->width;
+        *out_ty = index / map->width;
+        return;
+    }
+
+    int shift = map->block_shift;
+    int block = index >> (2 * shift);
+    int local = index & ((1 << (2 * shift)) - 1);
+    int local_x = map->layout.morton ? Map_MortonCompact(local) : local & (map->layout.block_size - 1);
+    int local_y = map->layout.morton ? Map_MortonCompact(local >> 1) : local >> shift;
+
+    *out_tx = ((block % map->blocks_per_row) << shift) | local_x;
+    *out_ty = ((block / map->blocks_per_row) << shift) | local_y;
+}
+
+/*
+    Bit layers. Row-major, padding bits past the last column of a row
+    are always clear; blocked, so are the bits of padding tiles. Row
+    reads mask outside tiles themselves.
+*/
+static size_t Map_BitPosition(const Map *map, int tx, int ty)
+{
+    if (map->block_shift == 0)
+        return (size_t)ty * (size_t)map->bit_row_words * MAP_BITS_PER_WORD + (size_t)tx;
+
+    return (size_t)Map_StorageIndex(map, tx, ty);
+}
+
+static bool Map_BitTest(const uint64_t *layer, const Map *map, int tx, int ty)
+{
+    size_t position = Map_BitPosition(map, tx, ty);
+
+    return (layer[position / MAP_BITS_PER_WORD] >> (position % MAP_BITS_PER_WORD)) & 1u;
+}
+
+static void Map_BitAssign(uint64_t *layer, const Map *map, int tx, int ty, bool value)
+{
+    size_t position = Map_BitPosition(map, tx, ty);
+    uint64_t bit = (uint64_t)1 << (position % MAP_BITS_PER_WORD);
+
+    if (value)
+        layer[position / MAP_BITS_PER_WORD] |= bit;
+    else
+        layer[position / MAP_BITS_PER_WORD] &= ~bit;
+}
+
+// Word of a row-major row at a word index that may lie outside the row
+static uint64_t Map_BitRowWord(const uint64_t *layer, const Map *map, int ty, int word)
+{
+    if (word < 0 || word >= map->bit_row_words)
+        return 0;
+
+    return layer[(size_t)ty * (size_t)map->bit_row_words + (size_t)word];
+}
+
+static uint64_t Map_RowInsideMask(const Map *map, int tx, int ty);
+
+/*
+    Blocked row read: the run crosses a block every block_size tiles.
+    Without Z-order a block's row is contiguous within one word and
+    is copied whole; with it, tiles are gathered one by one.
+*/
+static uint64_t Map_BlockedBitRow(const uint64_t *layer, const Map *map, int tx, int ty)
+{
+    uint64_t inside = Map_RowInsideMask(map, tx, ty);
+    uint64_t bits = 0;
+
+    while (inside != 0)
+    {
+        int first = __builtin_ctzll(inside);
+        int run_tx = tx + first;
+        int run = map->layout.block_size - (run_tx & (map->layout.block_size - 1));
+
+        if (run > MAP_BITS_PER_WORD - first)
+            run = MAP_BITS_PER_WORD - first;
+
+        uint64_t run_mask = ((uint64_t)1 << run) - 1;
+        uint64_t run_bits = 0;
+
+        if (map->layout.morton)
+        {
+            for (int i = 0; i < run; i++)
+                run_bits |= (uint64_t)Map_BitTest(layer, map, run_tx + i, ty) << i;
+        }
+        else
+        {
+            size_t position = Map_BitPosition(map, run_tx, ty);
+
+            run_bits = (layer[position / MAP_BITS_PER_WORD] >> (position % MAP_BITS_PER_WORD)) & run_mask;
+        }
+
+        // Tiles past the right edge read as padding, which is clear
+        bits |= run_bits << first;
+        inside &= ~(run_mask << first);
+    }
+
+    return bits;
+}
+
+/*
+    Bits of tiles tx .. tx + 63 on row ty, bit 0 first; outside tiles
+    read as 0. Row-major, built from the two words the run straddles.
+*/
+static uint64_t Map_BitRow(const uint64_t *layer, const Map *map, int tx, int ty)
+{
+    if (ty < 0 || ty >= map->height)
+        return 0;
+
+    if (map->block_shift != 0)
+        return Map_BlockedBitRow(layer, map, tx, ty);
+
+    // Floor division, so runs starting left of the map line up too
+    int word = tx >= 0 ? tx / MAP_BITS_PER_WORD : -((-tx + MAP_BITS_PER_WORD - 1) / MAP_BITS_PER_WORD);
+    int shift = tx - word * MAP_BITS_PER_WORD;
+
+    uint64_t low = Map_BitRowWord(layer, map, ty, word);
+
+    if (shift == 0)
+        return low;
+
+    uint64_t high = Map_BitRowWord(layer, map, ty, word + 1);
+
+    return (low >> shift) | (high << (MAP_BITS_PER_WORD - shift));
+}
+
+// Bits of the run tx .. tx + 63 that fall inside the map
+static uint64_t Map_RowInsideMask(const Map *map, int tx, int ty)
+{
+    if (ty < 0 || ty >= map->height || tx >= map->width || tx <= -MAP_BITS_PER_WORD)
+        return 0;
+
+    int first = tx < 0 ? -tx : 0;
+    int last = map->width - tx < MAP_BITS_PER_WORD ? map->width - tx : MAP_BITS_PER_WORD;
+
+    uint64_t mask = last == MAP_BITS_PER_WORD ? ~(uint64_t)0 : ((uint64_t)1 << last) - 1;
+
+    return mask & (~(uint64_t)0 << first);
+}
+
+/*
+    Records an edit that changed the tile: bumps the map and chunk
+    revisions and grows the chunk's pending rectangle.
+*/
+static void Map_NoteChange(Map *map, int tx, int ty, unsigned int flags)
+{
+    int chunk = (ty / MAP_CHUNK_SIZE) * map->chunks_per_row + tx / MAP_CHUNK_SIZE;
+    MapChange *pending = &map->pending_changes[chunk];
+
+    map->revision++;
+    map->chunk_revisions[chunk] = map->revision;
+
+    if (pending->flags == 0)
+    {
+        pending->min_tx = pending->max_tx = tx;
+        pending->min_ty = pending->max_ty = ty;
+        map->pending_chunks[map->pending_count++] = chunk;
+    }
+    else
+    {
+        if (tx < pending->min_tx)
+            pending->min_tx = tx;
+
+        if (tx > pending->max_tx)
+            pending->max_tx = tx;
+
+        if (ty < pending->min_ty)
+            pending->min_ty = ty;
+
+        if (ty > pending->max_ty)
+            pending->max_ty = ty;
+    }
+
+    pending->flags |= flags;
+    pending->revision = map->revision;
+}
+
+/*
+    A newly opened tile joins its neighbours' region.
+    Touching two different regions merges them, which is left
+    to the next relabel.
+*/
+static void Map_OpenComponent(Map *map, int tx, int ty)
+{
+    int label = MAP_COMPONENT_NONE;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        int nx = tx + MAP_OFFSETS[i][0];
+        int ny = ty + MAP_OFFSETS[i][1];
+
+        if (!Map_IsWalkable(map, nx, ny))
+            continue;
+
+        int neighbour = map->components[Map_StorageIndex(map, nx, ny)];
+
+        if (label == MAP_COMPONENT_NONE)
+            label = neighbour;
+        else if (neighbour != label)
+            map->components_dirty = true;
+    }
+
+    if (label == MAP_COMPONENT_NONE)
+        label = map->next_component++;
+
+    map->components[Map_StorageIndex(map, tx, ty)] = label;
+}
+
+/*
+    Blocking a tile can only split its region if the walkable
+    neighbours it separated are not linked around it. Neighbours
+    on adjacent sides are linked when the corner between them is
+    walkable; all four sides linked forms a ring, still one group.
+*/
+static void Map_CloseComponent(Map *map, int tx, int ty)
+{
+    bool open[4];
+    int open_count = 0;
+    int links = 0;
+
+    map->components[Map_StorageIndex(map, tx, ty)] = MAP_COMPONENT_NONE;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        open[i] = Map_IsWalkable(map, tx + MAP_OFFSETS[i][0], ty + MAP_OFFSETS[i][1]);
+
+        if (open[i])
+            open_count++;
+    }
+
+    for (int i = 0; i < 4; ++i)
+    {
+        int j = (i + 1) % 4;
+
+        if (!open[i] || !open[j])
+            continue;
+
+        int corner_tx = tx + MAP_OFFSETS[i][0] + MAP_OFFSETS[j][0];
+        int corner_ty = ty + MAP_OFFSETS[i][1] + MAP_OFFSETS[j][1];
+
+        if (Map_IsWalkable(map, corner_tx, corner_ty))
+            links++;
+    }
+
+    if (open_count - links > 1)
+        map->components_dirty = true;
+}
+
+/*
+    Size and storage geometry for a layout, with every layer pointer
+    cleared. Fails on a layout or size the map cannot store.
+*/
+static bool Map_SetupGeometry(Map *map, int width, int height, const MapLayout *layout)
 {
+    map->width = width;
+    map->height = height;
+    map->layout = layout != NULL ? *layout : (MapLayout){0};
+    map->block_shift = 0;
+    map->blocks_per_row = 0;
+    map->storage_count = 0;
+    map->bit_row_words = 0;
+    map->tiles = NULL;
+    map->walkable_bits = NULL;
+    map->occupied_bits = NULL;
+    map->owns_layers = false;
+    map->mapping = NULL;
+    map->mapping_size = 0;
+    map->components = NULL;
+    map->component_queue = NULL;
+    map->landmark_distances = NULL;
+    map->landmark_queue = NULL;
+    map->chunks_per_row = 0;
+    map->chunk_count = 0;
+    map->chunk_revisions = NULL;
+    map->pending_changes = NULL;
+    map->pending_chunks = NULL;
+    map->change_log = NULL;
+
+    bool valid_layout = map->layout.block_size == 0 ||
+        map->layout.block_size == 8 || map->layout.block_size == 16;
+
+    if (!valid_layout || width <= 0 || height <= 0 || width > INT32_MAX / height)
+        return false;
+
+    size_t storage_count = (size_t)width * (size_t)height;
+
+    if (map->layout.block_size == 0)
+    {
+        map->bit_row_words = (width + MAP_BITS_PER_WORD - 1) / MAP_BITS_PER_WORD;
+    }
+    else
+    {
+        int size = map->layout.block_size;
+
+        map->block_shift = size == 8 ? 3 : 4;
+        map->blocks_per_row = (width + size - 1) / size;
+
+        // Padded out to whole blocks; a block is a whole number of words
+        storage_count = (size_t)map->blocks_per_row * (size_t)((height + size - 1) / size) * (size_t)(size * size);
+
+        if (storage_count > INT32_MAX)
+            return false;
+    }
+
+    map->storage_count = (int)storage_count;
+
+    return true;
+}
+
+/*
+    Layers derived from the tiles rather than stored with them:
+    region labels, landmark tables and their work queues, and the
+    change tracking state. Labels start as MAP_COMPONENT_NONE and
+    every chunk at revision 0.
+*/
+static bool Map_AllocateDerived(Map *map)
+{
+    size_t count = (size_t)Map_TileCount(map);
+    size_t storage_count = (size_t)map->storage_count;
+
+    map->chunks_per_row = (map->width + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE;
+    map->chunk_count = map->chunks_per_row * ((map->height + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE);
+
+    map->components = calloc(storage_count, sizeof(int));
+    map->component_queue = malloc(storage_count * sizeof(int));
+    map->landmark_distances = malloc(MAP_LANDMARK_COUNT * count * sizeof(uint16_t));
+    map->landmark_queue = malloc(count * sizeof(int));
+    map->chunk_revisions = calloc((size_t)map->chunk_count, sizeof(unsigned int));
+    map->pending_changes = calloc((size_t)map->chunk_count, sizeof(MapChange));
+    map->pending_chunks = malloc((size_t)map->chunk_count * sizeof(int));
+    map->change_log = malloc(MAP_CHANGE_LOG_SIZE * sizeof(MapChange));
+
+    return map->components != NULL && map->component_queue != NULL &&
+           map->landmark_distances != NULL && map->landmark_queue != NULL &&
+           map->chunk_revisions != NULL && map->pending_changes != NULL &&
+           map->pending_chunks != NULL && map->change_log != NULL;
+}
+
+// Revisions and landmark build state of a freshly set up map
+static void Map_ResetState(Map *map)
+{
+    map->walkability_revision = 0;
+    map->revision = 0;
+    map->pending_count = 0;
+    map->change_count = 0;
+    map->costly_tile_count = 0;
+    map->next_component = 1;
+    map->components_dirty = false;
+
+    // No landmark tables until the first Map_UpdateLandmarks pass
+    for (int i = 0; i < MAP_LANDMARK_COUNT; i++)
+    {
+        map->landmark_tiles[i] = -1;
+        map->landmark_usable[i] = false;
+    }
+
+    map->landmark_build_index = 0;
+    map->landmark_build_revision = map->walkability_revision;
+    map->landmark_bfs_active = false;
+}
+
+bool Map_Init(Map *map, int width, int height)
+{
+    return Map_InitLayout(map, width, height, NULL);
+}
+
+bool Map_InitLayout(Map *map, int width, int height, const MapLayout *layout)
+{
+    if (!Map_SetupGeometry(map, width, height, layout))
+    {
+        Map_Free(map);
+        return false;
+    }
+
+    size_t storage_count = (size_t)map->storage_count;
+    size_t bit_words = Map_BitLayerWords(map);
+
+    map->tiles = malloc(storage_count * sizeof(Tile));
+    map->walkable_bits = malloc(bit_words * sizeof(uint64_t));
+    map->occupied_bits = malloc(bit_words * sizeof(uint64_t));
+    map->owns_layers = true;
+
+    if (map->tiles == NULL || map->walkable_bits == NULL || map->occupied_bits == NULL ||
+        !Map_AllocateDerived(map))
+    {
+        Map_Free(map);
+        return false;
+    }
+
     // Initialize all tiles as walkable
-    for (int y = 0; y < MAP_HEIGHT; y++)
+    for (size_t i = 0; i < storage_count; i++)
+    {
+        map->tiles[i].cost = MAP_TILE_COST_MIN;
+        map->components[i] = 1;
+    }
+
+    memset(map->walkable_bits, 0, bit_words * sizeof(uint64_t));
+    memset(map->occupied_bits, 0, bit_words * sizeof(uint64_t));
+
+    for (int ty = 0; ty < height; ty++)
+        for (int tx = 0; tx < width; tx++)
+            Map_BitAssign(map->walkable_bits, map, tx, ty, true);
+
+    Map_ResetState(map);
+
+    // Fully open map: a single region
+    map->next_component = 2;
+
+    return true;
+}
+
+/*
+    True if no padding bit of a bit layer is set. Row-major, padding is
+    the tail of each row's last word; blocked, it is the bits of the
+    padding tiles past the right and bottom edges.
+*/
+static bool Map_BitPaddingClear(const Map *map, const uint64_t *layer)
+{
+    if (map->block_shift == 0)
     {
-        for (int x = 0; x < MAP_WIDTH; x++)
+        int used = map->width % MAP_BITS_PER_WORD;
+
+        if (used == 0)
+            return true;
+
+        uint64_t padding = ~(uint64_t)0 << used;
+
+        for (int ty = 0; ty < map->height; ty++)
         {
-            map->tiles[y][x].walkable = 1;
-            map->tiles[y][x].occupied = 0;
+            if (layer[(size_t)(ty + 1) * (size_t)map->bit_row_words - 1] & padding)
+                return false;
         }
+
+        return true;
     }
+
+    for (int i = 0; i < map->storage_count; i++)
+    {
+        int tx;
+        int ty;
+
+        Map_StorageTile(map, i, &tx, &ty);
+
+        if (!Map_IsInside(map, tx, ty) && ((layer[i / MAP_BITS_PER_WORD] >> (i % MAP_BITS_PER_WORD)) & 1u))
+            return false;
+    }
+
+    return true;
 }
 
-bool Map_IsInside(const Map *map, int tx, int ty)
+/*
+    Checks layers handed in from outside hold values the map can have
+    produced: every cost in range and no padding bit set. Counts the
+    costly tiles on the way.
+*/
+static bool Map_CheckLayers(const Map *map, int *out_costly_count)
+{
+    int costly = 0;
+
+    for (int i = 0; i < map->storage_count; i++)
+    {
+        int cost = map->tiles[i].cost;
+
+        if (cost < MAP_TILE_COST_MIN || cost > MAP_TILE_COST_MAX)
+            return false;
+
+        if (cost != MAP_TILE_COST_MIN)
+        {
+            int tx;
+            int ty;
+
+            // Padding tiles of blocked layouts never count
+            Map_StorageTile(map, i, &tx, &ty);
+
+            if (Map_IsInside(map, tx, ty))
+                costly++;
+        }
+    }
+
+    if (!Map_BitPaddingClear(map, map->walkable_bits) || !Map_BitPaddingClear(map, map->occupied_bits))
+        return false;
+
+    *out_costly_count = costly;
+
+    return true;
+}
+
+bool Map_InitWithLayers(Map *map, int width, int height, const MapLayout *layout, const MapLayers *layers)
+{
+    bool sized = Map_SetupGeometry(map, width, height, layout) &&
+        layers->tiles_size == (size_t)map->storage_count * sizeof(Tile) &&
+        layers->walkable_size == Map_BitLayerWords(map) * sizeof(uint64_t) &&
+        layers->occupied_size == Map_BitLayerWords(map) * sizeof(uint64_t);
+
+    if (sized)
+    {
+        map->tiles = layers->tiles;
+        map->walkable_bits = layers->walkable_bits;
+        map->occupied_bits = layers->occupied_bits;
+    }
+
+    int costly_tile_count = 0;
+
+    if (!sized || !Map_CheckLayers(map, &costly_tile_count))
+    {
+        Map_Free(map);
+        return false;
+    }
+
+    map->mapping = layers->mapping;
+    map->mapping_size = layers->mapping_size;
+
+    if (!Map_AllocateDerived(map))
+    {
+        // The layers stay with the caller on failure
+        map->mapping = NULL;
+        Map_Free(map);
+        return false;
+    }
+
+    Map_ResetState(map);
+    map->costly_tile_count = costly_tile_count;
+
+    // Regions are unknown until the first Map_UpdateComponents
+    map->components_dirty = true;
+
+    return true;
+}
+
+void Map_Free(Map *map)
+{
+    if (map->owns_layers)
+    {
+        free(map->tiles);
+        free(map->walkable_bits);
+        free(map->occupied_bits);
+    }
+
+    if (map->mapping != NULL)
+        munmap(map->mapping, map->mapping_size);
+
+    free(map->components);
+    free(map->component_queue);
+    free(map->landmark_distances);
+    free(map->landmark_queue);
+    free(map->chunk_revisions);
+    free(map->pending_changes);
+    free(map->pending_chunks);
+    free(map->change_log);
+
+    map->tiles = NULL;
+    map->walkable_bits = NULL;
+    map->occupied_bits = NULL;
+    map->owns_layers = false;
+    map->mapping = NULL;
+    map->mapping_size = 0;
+    map->components = NULL;
+    map->component_queue = NULL;
+    map->landmark_distances = NULL;
+    map->landmark_queue = NULL;
+    map->chunk_revisions = NULL;
+    map->pending_changes = NULL;
+    map->pending_chunks = NULL;
+    map->change_log = NULL;
+    map->chunk_count = 0;
+    map->pending_count = 0;
+    map->bit_row_words = 0;
+    map->storage_count = 0;
+    map->width = 0;
+    map->height = 0;
+}
+
+size_t Map_BitLayerWords(const Map *map)
 {
-    // map currently unused, but kept for future flexibility
-    (void)map;
+    if (map->block_shift == 0)
+        return (size_t)map->bit_row_words * (size_t)map->height;
 
-    return tx >= 0 && tx < MAP_WIDTH &&
-           ty >= 0 && ty < MAP_HEIGHT;
+    return (size_t)map->storage_count / MAP_BITS_PER_WORD;
+}
+
+int Map_TileCount(const Map *map)
+{
+    return map->width * map->height;
+}
+
+int Map_Index(const Map *map, int tx, int ty)
+{
+    return ty * map->width + tx;
+}
+
+const uint16_t *Map_LandmarkTable(const Map *map, int landmark)
+{
+    return map->landmark_distances + (size_t)landmark * (size_t)Map_TileCount(map);
+}
+
+bool Map_IsInside(const Map *map, int tx, int ty)
+{
+    return tx >= 0 && tx < map->width &&
+           ty >= 0 && ty < map->height;
 }
 
 bool Map_IsWalkable(const Map *map, int tx, int ty)
@@ -41,8 +683,299 @@ bool Map_IsWalkable(const Map *map, int tx, int ty)
         return false;
     }
 
-    // for phase 2: everything is walkable
-    return map->tiles[ty][tx].walkable != 0;
+    return Map_BitTest(map->walkable_bits, map, tx, ty);
+}
+
+void Map_SetWalkable(Map *map, int tx, int ty, bool value)
+{
+    if (!Map_IsInside(map, tx, ty))
+        return;
+
+    if (Map_BitTest(map->walkable_bits, map, tx, ty) == value)
+        return;
+
+    Map_BitAssign(map->walkable_bits, map, tx, ty, value);
+    map->walkability_revision++;
+    Map_NoteChange(map, tx, ty, MAP_CHANGE_WALKABLE);
+
+    if (value)
+    {
+        Map_OpenComponent(map, tx, ty);
+
+        // A new opening can create shortcuts the tables do not know about
+        for (int i = 0; i < MAP_LANDMARK_COUNT; i++)
+            map->landmark_usable[i] = false;
+    }
+    else
+    {
+        Map_CloseComponent(map, tx, ty);
+    }
+}
+
+int Map_GetCost(const Map *map, int tx, int ty)
+{
+    if (!Map_IsInside(map, tx, ty))
+        return MAP_TILE_COST_MIN;
+
+    return map->tiles[Map_StorageIndex(map, tx, ty)].cost;
+}
+
+void Map_SetCost(Map *map, int tx, int ty, int cost)
+{
+    if (!Map_IsInside(map, tx, ty))
+        return;
+
+    if (cost < MAP_TILE_COST_MIN)
+        cost = MAP_TILE_COST_MIN;
+
+    if (cost > MAP_TILE_COST_MAX)
+        cost = MAP_TILE_COST_MAX;
+
+    int old_cost = map->tiles[Map_StorageIndex(map, tx, ty)].cost;
+
+    if (old_cost == cost)
+        return;
+
+    if (old_cost == MAP_TILE_COST_MIN)
+        map->costly_tile_count++;
+    else if (cost == MAP_TILE_COST_MIN)
+        map->costly_tile_count--;
+
+    // Cached routes may no longer be the cheapest
+    map->tiles[Map_StorageIndex(map, tx, ty)].cost = cost;
+    map->walkability_revision++;
+    Map_NoteChange(map, tx, ty, MAP_CHANGE_COST);
+}
+
+bool Map_HasUniformCost(const Map *map)
+{
+    return map->costly_tile_count == 0;
+}
+
+unsigned int Map_GetWalkabilityRevision(const Map *map)
+{
+    return map->walkability_revision;
+}
+
+void Map_UpdateComponents(Map *map)
+{
+    if (!map->components_dirty)
+        return;
+
+    // Walks the layers in storage order, so regions are flooded
+    // block by block on blocked layouts
+    int count = map->storage_count;
+
+    for (int i = 0; i < count; i++)
+        map->components[i] = -1;
+
+    int label = 1;
+
+    for (int start = 0; start < count; start++)
+    {
+        if (map->components[start] != -1)
+            continue;
+
+        int start_tx;
+        int start_ty;
+
+        Map_StorageTile(map, start, &start_tx, &start_ty);
+
+        // Padding tiles of a blocked layout are never walkable
+        if (!Map_IsWalkable(map, start_tx, start_ty))
+        {
+            map->components[start] = MAP_COMPONENT_NONE;
+            continue;
+        }
+
+        // Breadth-first flood of one region
+        int head = 0;
+        int tail = 0;
+
+        map->components[start] = label;
+        map->component_queue[tail++] = start;
+
+        while (head < tail)
+        {
+            int index = map->component_queue[head++];
+            int cx;
+            int cy;
+
+            Map_StorageTile(map, index, &cx, &cy);
+
+            for (int i = 0; i < 4; ++i)
+            {
+                int nx = cx + MAP_OFFSETS[i][0];
+                int ny = cy + MAP_OFFSETS[i][1];
+
+                if (!Map_IsWalkable(map, nx, ny))
+                    continue;
+
+                int next = Map_StorageIndex(map, nx, ny);
+
+                if (map->components[next] != -1)
+                    continue;
+
+                map->components[next] = label;
+                map->component_queue[tail++] = next;
+            }
+        }
+
+        label++;
+    }
+
+    map->next_component = label;
+    map->components_dirty = false;
+}
+
+bool Map_AreConnected(const Map *map, int ax, int ay, int bx, int by)
+{
+    if (map->components_dirty)
+        return true;
+
+    if (!Map_IsWalkable(map, ax, ay) || !Map_IsWalkable(map, bx, by))
+        return true;
+
+    return map->components[Map_StorageIndex(map, ax, ay)] == map->components[Map_StorageIndex(map, bx, by)];
+}
+
+/*
+    The first landmark is the walkable tile nearest the map centre.
+    Each later one is picked farthest-point: the tile whose nearest
+    earlier landmark is farthest away. Tiles the first landmark cannot
+    reach are skipped so small sealed pockets do not use up landmarks.
+    Returns -1 if no tile is walkable.
+*/
+static int Map_PickLandmark(const Map *map, int landmark)
+{
+    int best_index = -1;
+    int best_score = -1;
+
+    int count = Map_TileCount(map);
+    const uint16_t *first_table = Map_LandmarkTable(map, 0);
+
+    for (int index = 0; index < count; index++)
+    {
+        int tx = index % map->width;
+        int ty = index / map->width;
+
+        if (!Map_BitTest(map->walkable_bits, map, tx, ty))
+            continue;
+
+        int score;
+
+        if (landmark == 0)
+        {
+            int dx = 2 * tx - (map->width - 1);
+            int dy = 2 * ty - (map->height - 1);
+
+            // Closer to the centre scores higher
+            score = -((dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy));
+        }
+        else
+        {
+            if (first_table[index] == MAP_LANDMARK_UNREACHABLE)
+                continue;
+
+            score = MAP_LANDMARK_UNREACHABLE;
+
+            for (int j = 0; j < landmark; j++)
+            {
+                int distance = Map_LandmarkTable(map, j)[index];
+
+                if (distance < score)
+                    score = distance;
+            }
+        }
+
+        if (best_index < 0 || score > best_score)
+        {
+            best_score = score;
+            best_index = index;
+        }
+    }
+
+    return best_index;
+}
+
+void Map_UpdateLandmarks(Map *map, int budget)
+{
+    // Terrain changed: start a fresh pass from the first landmark
+    if (map->landmark_build_revision != map->walkability_revision)
+    {
+        map->landmark_build_revision = map->walkability_revision;
+        map->landmark_build_index = 0;
+        map->landmark_bfs_active = false;
+    }
+
+    while (budget > 0 && map->landmark_build_index < MAP_LANDMARK_COUNT)
+    {
+        int landmark = map->landmark_build_index;
+        uint16_t *distances = map->landmark_distances + (size_t)landmark * (size_t)Map_TileCount(map);
+
+        if (!map->landmark_bfs_active)
+        {
+            int tile = Map_PickLandmark(map, landmark);
+
+            if (tile < 0)
+            {
+                // Nothing walkable: leave every remaining table unused
+                map->landmark_build_index = MAP_LANDMARK_COUNT;
+                break;
+            }
+
+            // Rebuilt in place, so unusable while the search runs
+            map->landmark_usable[landmark] = false;
+            map->landmark_tiles[landmark] = tile;
+
+            for (int index = 0; index < Map_TileCount(map); index++)
+                distances[index] = MAP_LANDMARK_UNREACHABLE;
+
+            distances[tile] = 0;
+            map->landmark_queue[0] = tile;
+            map->landmark_queue_head = 0;
+            map->landmark_queue_tail = 1;
+            map->landmark_bfs_active = true;
+        }
+
+        // Breadth-first distances, resumable across calls
+        while (budget > 0 && map->landmark_queue_head < map->landmark_queue_tail)
+        {
+            int index = map->landmark_queue[map->landmark_queue_head++];
+            int cx = index % map->width;
+            int cy = index / map->width;
+            int next_distance = distances[index] + 1;
+
+            budget--;
+
+            if (next_distance >= MAP_LANDMARK_UNREACHABLE)
+                continue;
+
+            for (int i = 0; i < 4; ++i)
+            {
+                int nx = cx + MAP_OFFSETS[i][0];
+                int ny = cy + MAP_OFFSETS[i][1];
+
+                if (!Map_IsWalkable(map, nx, ny))
+                    continue;
+
+                int next = Map_Index(map, nx, ny);
+
+                if (distances[next] != MAP_LANDMARK_UNREACHABLE)
+                    continue;
+
+                distances[next] = (uint16_t)next_distance;
+                map->landmark_queue[map->landmark_queue_tail++] = next;
+            }
+        }
+
+        if (map->landmark_queue_head < map->landmark_queue_tail)
+            break;
+
+        map->landmark_usable[landmark] = true;
+        map->landmark_bfs_active = false;
+        map->landmark_build_index++;
+    }
 }
 
 bool Map_IsOccupied(const Map *map, int tx, int ty)
@@ -50,7 +983,7 @@ bool Map_IsOccupied(const Map *map, int tx, int ty)
     if (!Map_IsInside(map, tx, ty))
         return true;
 
-    return map->tiles[ty][tx].occupied != 0;
+    return Map_BitTest(map->occupied_bits, map, tx, ty);
 }
 
 void Map_SetOccupied(Map *map, int tx, int ty, bool value)
@@ -58,5 +991,136 @@ void Map_SetOccupied(Map *map, int tx, int ty, bool value)
     if (!Map_IsInside(map, tx, ty))
         return;
 
-    map->tiles[ty][tx].occupied = value ? 1: 0;
+    if (Map_BitTest(map->occupied_bits, map, tx, ty) == value)
+        return;
+
+    Map_BitAssign(map->occupied_bits, map, tx, ty, value);
+    Map_NoteChange(map, tx, ty, MAP_CHANGE_OCCUPIED);
+}
+
+uint64_t Map_WalkableRow(const Map *map, int tx, int ty)
+{
+    return Map_BitRow(map->walkable_bits, map, tx, ty);
+}
+
+uint64_t Map_OccupiedRow(const Map *map, int tx, int ty)
+{
+    return Map_BitRow(map->occupied_bits, map, tx, ty) | ~Map_RowInsideMask(map, tx, ty);
+}
+
+uint64_t Map_PassableRow(const Map *map, int tx, int ty)
+{
+    return Map_BitRow(map->walkable_bits, map, tx, ty) & ~Map_BitRow(map->occupied_bits, map, tx, ty);
+}
+
+void Map_SetOccupiedRow(Map *map, int tx, int ty, uint64_t mask, bool value)
+{
+    mask &= Map_RowInsideMask(map, tx, ty);
+
+    // Only tiles whose state flips count as edits
+    uint64_t current = Map_BitRow(map->occupied_bits, map, tx, ty);
+
+    mask &= value ? ~current : current;
+
+    for (uint64_t changed = mask; changed != 0; changed &= changed - 1)
+        Map_NoteChange(map, tx + __builtin_ctzll(changed), ty, MAP_CHANGE_OCCUPIED);
+
+    if (map->block_shift != 0)
+    {
+        // The row is spread over several blocks; set tile by tile
+        while (mask != 0)
+        {
+            int first = __builtin_ctzll(mask);
+
+            Map_BitAssign(map->occupied_bits, map, tx + first, ty, value);
+            mask &= mask - 1;
+        }
+
+        return;
+    }
+
+    // At most two words: the one holding tx and the next
+    while (mask != 0)
+    {
+        int first = __builtin_ctzll(mask);
+        int run_tx = tx + first;
+        int word_end = (run_tx / MAP_BITS_PER_WORD + 1) * MAP_BITS_PER_WORD;
+        int span = word_end - tx;
+
+        uint64_t part = span >= MAP_BITS_PER_WORD ? mask : mask & (((uint64_t)1 << span) - 1);
+        uint64_t *word = &map->occupied_bits[Map_BitPosition(map, run_tx, ty) / MAP_BITS_PER_WORD];
+        int offset = tx - (run_tx / MAP_BITS_PER_WORD) * MAP_BITS_PER_WORD;
+        uint64_t bits = offset >= 0 ? part << offset : part >> -offset;
+
+        if (value)
+            *word |= bits;
+        else
+            *word &= ~bits;
+
+        mask &= ~part;
+    }
+}
+
+unsigned int Map_GetRevision(const Map *map)
+{
+    return map->revision;
+}
+
+unsigned int Map_GetChunkRevision(const Map *map, int tx, int ty)
+{
+    if (!Map_IsInside(map, tx, ty))
+        return 0;
+
+    return map->chunk_revisions[(ty / MAP_CHUNK_SIZE) * map->chunks_per_row + tx / MAP_CHUNK_SIZE];
+}
+
+void Map_PublishChanges(Map *map)
+{
+    for (int i = 0; i < map->pending_count; i++)
+    {
+        MapChange *pending = &map->pending_changes[map->pending_chunks[i]];
+
+        map->change_log[map->change_count & (MAP_CHANGE_LOG_SIZE - 1)] = *pending;
+        map->change_count++;
+        pending->flags = 0;
+    }
+
+    map->pending_count = 0;
+}
+
+void Map_ChangeReaderInit(const Map *map, MapChangeReader *reader)
+{
+    reader->next = map->change_count;
+}
+
+int Map_ReadChanges(const Map *map, MapChangeReader *reader, MapChange *out, int capacity)
+{
+    if (capacity <= 0 || reader->next == map->change_count)
+        return 0;
+
+    // Overwritten before being read: report everything as changed
+    if (map->change_count - reader->next > MAP_CHANGE_LOG_SIZE)
+    {
+        out[0] = (MapChange){
+            .min_tx = 0,
+            .min_ty = 0,
+            .max_tx = map->width - 1,
+            .max_ty = map->height - 1,
+            .flags = MAP_CHANGE_ALL,
+            .revision = map->revision
+        };
+
+        reader->next = map->change_count;
+        return 1;
+    }
+
+    int count = 0;
+
+    while (count < capacity && reader->next != map->change_count)
+    {
+        out[count++] = map->change_log[reader->next & (MAP_CHANGE_LOG_SIZE - 1)];
+        reader->next++;
+    }
+
+    return count;
 }
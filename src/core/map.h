@@ -2,26 +2,312 @@
 #define MAP_H 
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include "../game/constants.h"
 
+// Walkability and occupancy live in the bit layers of Map
 typedef struct {
-	int walkable;  // 1 - walkable, 0 - blocked
-	int occupied;  // 1 - unit present, 0 - free
+	int cost;      // movement cost of entering, MAP_TILE_COST_MIN..MAX
 } Tile;
 
+// Tiles per word of a bit layer
+#define MAP_BITS_PER_WORD 64
+
+/*
+Storage order of the map's own per-tile layers (costs, walkability,
+occupancy and region labels). Row-major suits row scans; square
+blocks keep a tile's vertical neighbours and a compact search
+frontier in the same few cache lines. The choice is invisible
+through the Map_* API.
+*/
+typedef struct {
+	// Side of the square blocks, 8 or 16; 0 stores plain rows
+	int block_size;
+
+	// Orders tiles within a block along a Z-order (Morton) curve
+	// instead of row by row; ignored for row-major storage
+	bool morton;
+} MapLayout;
+
+/*
+Terrain movement costs.
+Searches charge the cost of the tile entered and units cross a tile
+that much slower, so the cheapest route is also the quickest walk.
+Open ground is the cheapest terrain; nothing may go below it,
+which keeps distance heuristics admissible.
+*/
+#define MAP_TILE_COST_MIN 1
+#define MAP_TILE_COST_MAX 15
+
+#define MAP_COST_ROAD  1
+#define MAP_COST_GRASS 2
+#define MAP_COST_SWAMP 4
+
+// Component id of blocked tiles
+#define MAP_COMPONENT_NONE 0
+
+// Landmarks used by the ALT heuristic
+#define MAP_LANDMARK_COUNT 8
+
+// Landmark distance of tiles the landmark cannot reach (or too far to store)
+#define MAP_LANDMARK_UNREACHABLE 0xFFFF
+
+// Tiles visited per Map_UpdateLandmarks call in the game loop
+#define MAP_LANDMARK_BUDGET 4096
+
+// Side of the square chunks changes are tracked by
+#define MAP_CHUNK_SIZE 16
+
+// Published changes kept for readers; a power of two
+#define MAP_CHANGE_LOG_SIZE 1024
+
+// What a change touched
+#define MAP_CHANGE_WALKABLE 0x1
+#define MAP_CHANGE_COST     0x2
+#define MAP_CHANGE_OCCUPIED 0x4
+#define MAP_CHANGE_ALL      (MAP_CHANGE_WALKABLE | MAP_CHANGE_COST | MAP_CHANGE_OCCUPIED)
+
+/*
+Edits within one chunk during one tick: the bounding rectangle of the
+tiles edited (inclusive), what changed and the map revision after the
+last of them.
+*/
+typedef struct {
+	int min_tx;
+	int min_ty;
+	int max_tx;
+	int max_ty;
+	unsigned int flags;
+	unsigned int revision;
+} MapChange;
+
+// A subscriber's position in the change log
+typedef struct {
+	uint32_t next;
+} MapChangeReader;
+
+/*
+Walkability and costs must be changed through Map_SetWalkable and
+Map_SetCost: writing tiles directly bypasses the revision counter,
+the component labels and the uniform-cost bookkeeping.
+
+The size and layout are chosen at init and every per-tile layer is
+allocated to match. Tiles, bits and region labels are stored in the
+layout's order; landmark tables stay row-major, indexed by Map_Index
+like the scratch of the search modules.
+*/
 typedef struct {
-	Tile tiles[MAP_HEIGHT][MAP_WIDTH];
+	int width;
+	int height;
+
+	MapLayout layout;
+
+	// log2 of the block size (0 when row-major), blocks across the
+	// map, and entries per layer once padded out to whole blocks
+	int block_shift;
+	int blocks_per_row;
+	int storage_count;
+
+	Tile *tiles;
+
+	// Walkability and occupancy, one bit per tile; a set bit means
+	// walkable or a unit present. Row-major, every row starts on a
+	// word boundary: tile (tx, ty) is bit tx % 64 of word
+	// ty * bit_row_words + tx / 64. Blocked, bit n of the layer is the
+	// tile at storage position n, so an 8x8 block is exactly one word.
+	// Searches test neighbours here instead of in the wider tile array.
+	int bit_row_words;
+	uint64_t *walkable_bits;
+	uint64_t *occupied_bits;
+
+	// Whether Map_Free frees the three layers above, and the file
+	// mapping they point into, unmapped by Map_Free (NULL if none)
+	bool owns_layers;
+	void *mapping;
+	size_t mapping_size;
+
+	// Bumped whenever any tile's walkability or cost changes.
+	// Lets caches tell whether terrain changed since they were built.
+	unsigned int walkability_revision;
+
+	// Bumped by every edit, occupancy included. Each chunk records
+	// the revision of its last edit, so a system can skip chunks
+	// unchanged since it last looked.
+	unsigned int revision;
+	int chunks_per_row;
+	int chunk_count;
+	unsigned int *chunk_revisions;
+
+	// Edits not yet published: one change per touched chunk, in the
+	// order chunks were first touched (flags 0 while untouched)
+	MapChange *pending_changes;
+	int *pending_chunks;
+	int pending_count;
+
+	// Published changes, MAP_CHANGE_LOG_SIZE most recent kept;
+	// change_count counts every change ever published
+	MapChange *change_log;
+	uint32_t change_count;
+
+	// Tiles costing more than MAP_TILE_COST_MIN; zero on uniform maps
+	int costly_tile_count;
+
+	// Connected region of each walkable tile (4-connected terrain,
+	// occupancy ignored). Tiles sharing an id can reach each other.
+	int *components;
+	int next_component;
+
+	// Set when an edit may have split or merged regions.
+	// Labels are only trusted again after Map_UpdateComponents.
+	bool components_dirty;
+
+	// Flood-fill queue for relabelling
+	int *component_queue;
+
+	// Exact terrain distances from each landmark tile (ALT heuristic).
+	// A table is usable once built; opening a tile makes every table
+	// possibly overestimate, so all are disabled until rebuilt.
+	// Blocking tiles only lengthens routes and keeps them admissible.
+	// One table of width * height entries per landmark (Map_LandmarkTable).
+	uint16_t *landmark_distances;
+	int landmark_tiles[MAP_LANDMARK_COUNT];
+	bool landmark_usable[MAP_LANDMARK_COUNT];
+
+	// Incremental rebuild: next landmark to build (COUNT when current),
+	// the walkability revision the pass started at and its BFS state
+	int landmark_build_index;
+	unsigned int landmark_build_revision;
+	bool landmark_bfs_active;
+	int landmark_queue_head;
+	int landmark_queue_tail;
+	int *landmark_queue;
 } Map;
 
-void Map_Init(Map *map);
+// Allocates an all-walkable width x height map stored row-major.
+// Returns false on allocation failure or a size that is not positive.
+bool Map_Init(Map *map, int width, int height);
+
+// As Map_Init with the given storage layout (NULL for row-major).
+// Also fails on a block size other than 0, 8 or 16.
+bool Map_InitLayout(Map *map, int width, int height, const MapLayout *layout);
+void Map_Free(Map *map);
+
+/*
+Tile, walkability and occupancy layers held outside the map, such as
+in a mapped map file (see mapfile.h). Map_InitWithLayers uses them in
+place: they must already be in the layout's storage order, with the
+sizes it implies.
+*/
+typedef struct {
+	Tile *tiles;
+	size_t tiles_size;
+	uint64_t *walkable_bits;
+	size_t walkable_size;
+	uint64_t *occupied_bits;
+	size_t occupied_size;
+
+	// Unmapped by Map_Free; NULL leaves the layers to the caller
+	void *mapping;
+	size_t mapping_size;
+} MapLayers;
+
+// Sets up a map over existing layers without copying them. Only
+// the derived layers are allocated; region labels start stale.
+// The layers are checked in one pass: every cost must be within
+// MAP_TILE_COST_MIN..MAX and every padding bit clear. The costly tile
+// count is taken from that pass.
+// Returns false, leaving the layers and mapping to the caller, if a
+// layer size does not match the layout, a check fails or allocation fails.
+bool Map_InitWithLayers(Map *map, int width, int height, const MapLayout *layout, const MapLayers *layers);
+
+// Words in each bit layer, including row or block padding
+size_t Map_BitLayerWords(const Map *map);
+
+// Tiles in the map, width * height
+int Map_TileCount(const Map *map);
+
+// Row-major index of a tile, ty * width + tx, as used by landmark
+// tables and search scratch whatever the storage layout; the tile
+// must be inside
+int Map_Index(const Map *map, int tx, int ty);
+
+// Distance table of one landmark, Map_TileCount entries
+const uint16_t *Map_LandmarkTable(const Map *map, int landmark);
 
 // Returns true if tile coordinates are inside map bounds
 bool Map_IsInside(const Map *map, int tx, int ty);
 
 // Returns true if tile is walkable (terrain-based)
 bool Map_IsWalkable(const Map *map, int tx, int ty);
+void Map_SetWalkable(Map *map, int tx, int ty, bool value);
+unsigned int Map_GetWalkabilityRevision(const Map *map);
+
+// Relabels connected regions if edits left them stale.
+// Cheap when nothing changed; call once per tick before searching.
+void Map_UpdateComponents(Map *map);
+
+// Returns false only when both tiles are walkable and known to lie in
+// different regions, so no path can exist. Conservative (true) while
+// labels are stale.
+bool Map_AreConnected(const Map *map, int ax, int ay, int bx, int by);
+
+// Advances the landmark table rebuild by up to budget tile visits.
+// Does nothing once tables match the current walkability.
+void Map_UpdateLandmarks(Map *map, int budget);
+
+// Movement cost of entering a tile; set values are clamped to range
+int Map_GetCost(const Map *map, int tx, int ty);
+void Map_SetCost(Map *map, int tx, int ty, int cost);
+
+// True when every tile costs MAP_TILE_COST_MIN
+bool Map_HasUniformCost(const Map *map);
 
 bool Map_IsOccupied(const Map *map, int tx, int ty);
 void Map_SetOccupied(Map *map, int tx, int ty, bool value);
 
+/*
+Change tracking. Edits that change a tile bump the map revision and
+their chunk's revision at once, and grow that chunk's pending dirty
+rectangle. Map_PublishChanges, called once per tick, moves the
+pending rectangles to the change log; each subscriber drains the log
+through its own reader, so path caches, cluster graphs or renderers
+redo only the rectangles that changed.
+*/
+unsigned int Map_GetRevision(const Map *map);
+
+// Revision of the last edit in the chunk holding the tile; 0 if never
+// edited or outside the map
+unsigned int Map_GetChunkRevision(const Map *map, int tx, int ty);
+
+// Appends this tick's dirty rectangles to the change log
+void Map_PublishChanges(Map *map);
+
+// Starts a reader at the end of the log: it sees later changes only
+void Map_ChangeReaderInit(const Map *map, MapChangeReader *reader);
+
+/*
+Copies up to capacity published changes the reader has not seen,
+oldest first, and advances it. A reader that fell more than
+MAP_CHANGE_LOG_SIZE changes behind gets one change covering the whole
+map instead. Returns the number copied; 0 once caught up.
+*/
+int Map_ReadChanges(const Map *map, MapChangeReader *reader, MapChange *out, int capacity);
+
+/*
+Row operations on 64 tiles at once: bit i of a row word stands for
+tile (tx + i, ty). tx need not be word-aligned and the run may start
+or end outside the map; outside tiles read as blocked and occupied,
+like the single-tile queries.
+*/
+uint64_t Map_WalkableRow(const Map *map, int tx, int ty);
+uint64_t Map_OccupiedRow(const Map *map, int tx, int ty);
+
+// Walkable and unoccupied tiles of the row
+uint64_t Map_PassableRow(const Map *map, int tx, int ty);
+
+// Sets or clears occupancy of the row tiles selected by mask;
+// bits for tiles outside the map are ignored
+void Map_SetOccupiedRow(Map *map, int tx, int ty, uint64_t mask, bool value);
+
 #endif
@@ -0,0 +1,247 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "mapfile.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+    Map file module.
+
+    It owns:
+    - The on-disk map format
+    - Writing maps out and mapping them back in
+
+    It does NOT:
+    - Own the loaded layers once loaded; the Map does
+    - Check tile values itself; Map_InitWithLayers does
+*/
+
+// Sections MapFile_Save writes, in file order
+static const uint32_t MAP_FILE_SECTIONS[] =
+{
+    MAP_SECTION_WALKABLE,
+    MAP_SECTION_COST,
+    MAP_SECTION_OCCUPIED
+};
+
+#define MAP_FILE_SECTION_COUNT (sizeof(MAP_FILE_SECTIONS) / sizeof(MAP_FILE_SECTIONS[0]))
+
+static uint64_t MapFile_Align(uint64_t offset)
+{
+    return (offset + MAP_FILE_ALIGNMENT - 1) / MAP_FILE_ALIGNMENT * MAP_FILE_ALIGNMENT;
+}
+
+static const void *MapFile_SectionData(const Map *map, uint32_t type, uint64_t *out_size)
+{
+    uint64_t bit_bytes = (uint64_t)Map_BitLayerWords(map) * sizeof(uint64_t);
+
+    switch (type)
+    {
+        case MAP_SECTION_WALKABLE:
+            *out_size = bit_bytes;
+            return map->walkable_bits;
+
+        case MAP_SECTION_COST:
+            *out_size = (uint64_t)map->storage_count * sizeof(Tile);
+            return map->tiles;
+
+        case MAP_SECTION_OCCUPIED:
+            *out_size = bit_bytes;
+            return map->occupied_bits;
+
+        default:
+            *out_size = 0;
+            return NULL;
+    }
+}
+
+// Zero bytes up to the next aligned offset
+static bool MapFile_Pad(FILE *file, uint64_t *offset)
+{
+    static const uint8_t zeros[MAP_FILE_ALIGNMENT];
+    uint64_t aligned = MapFile_Align(*offset);
+    size_t padding = (size_t)(aligned - *offset);
+
+    if (padding > 0 && fwrite(zeros, 1, padding, file) != padding)
+        return false;
+
+    *offset = aligned;
+    return true;
+}
+
+bool MapFile_Save(const Map *map, const char *path)
+{
+    MapFileHeader header;
+    MapFileSection sections[MAP_FILE_SECTION_COUNT];
+
+    memset(&header, 0, sizeof(header));
+    memset(sections, 0, sizeof(sections));
+
+    header.magic = MAP_FILE_MAGIC;
+    header.version = MAP_FILE_VERSION;
+    header.header_size = sizeof(MapFileHeader);
+    header.section_count = MAP_FILE_SECTION_COUNT;
+    header.width = map->width;
+    header.height = map->height;
+    header.block_size = map->layout.block_size;
+    header.flags = map->layout.morton ? MAP_FILE_FLAG_MORTON : 0;
+    header.costly_tile_count = map->costly_tile_count;
+    header.tile_size = sizeof(Tile);
+
+    uint64_t offset = sizeof(header) + sizeof(sections);
+
+    for (size_t i = 0; i < MAP_FILE_SECTION_COUNT; ++i)
+    {
+        offset = MapFile_Align(offset);
+
+        sections[i].type = MAP_FILE_SECTIONS[i];
+        sections[i].offset = offset;
+        MapFile_SectionData(map, sections[i].type, &sections[i].size);
+
+        offset += sections[i].size;
+    }
+
+    FILE *file = fopen(path, "wb");
+
+    if (file == NULL)
+        return false;
+
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(sections, sizeof(sections), 1, file) == 1;
+
+    offset = sizeof(header) + sizeof(sections);
+
+    for (size_t i = 0; written && i < MAP_FILE_SECTION_COUNT; ++i)
+    {
+        uint64_t size;
+        const void *data = MapFile_SectionData(map, sections[i].type, &size);
+
+        written = MapFile_Pad(file, &offset) &&
+            fwrite(data, 1, (size_t)size, file) == (size_t)size;
+
+        offset += size;
+    }
+
+    if (fclose(file) != 0)
+        written = false;
+
+    return written;
+}
+
+/*
+    Finds a section of the given type and checks it lies aligned and
+    whole within the file. Returns NULL if there is no such section.
+*/
+static const MapFileSection *MapFile_FindSection(
+    const MapFileHeader *header, const uint8_t *base, uint64_t file_size, uint32_t type)
+{
+    const MapFileSection *sections = (const MapFileSection *)(base + header->header_size);
+    uint32_t count = header->section_count;
+
+    if (count > MAP_FILE_MAX_SECTIONS)
+        count = MAP_FILE_MAX_SECTIONS;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const MapFileSection *section = &sections[i];
+
+        if (section->type != type)
+            continue;
+
+        bool inside = section->offset % MAP_FILE_ALIGNMENT == 0 &&
+            section->offset <= file_size &&
+            section->size <= file_size - section->offset;
+
+        return inside ? section : NULL;
+    }
+
+    return NULL;
+}
+
+bool MapFile_Load(Map *map, const char *path)
+{
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+
+    if (fstat(fd, &info) != 0 || (uint64_t)info.st_size < sizeof(MapFileHeader))
+    {
+        close(fd);
+        return false;
+    }
+
+    uint64_t file_size = (uint64_t)info.st_size;
+
+    // Private and writable: edits to the loaded map copy pages
+    // instead of reaching the file
+    void *mapping = mmap(NULL, (size_t)file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+    // The mapping keeps the file alive
+    close(fd);
+
+    if (mapping == MAP_FAILED)
+        return false;
+
+    uint8_t *base = mapping;
+    const MapFileHeader *header = mapping;
+
+    bool valid = header->magic == MAP_FILE_MAGIC &&
+        header->version == MAP_FILE_VERSION &&
+        header->header_size >= sizeof(MapFileHeader) &&
+        header->header_size % 8 == 0 &&
+        header->header_size <= file_size &&
+        header->tile_size == sizeof(Tile) &&
+        header->section_count <= (file_size - header->header_size) / sizeof(MapFileSection);
+
+    const MapFileSection *walkable = NULL;
+    const MapFileSection *cost = NULL;
+    const MapFileSection *occupied = NULL;
+
+    if (valid)
+    {
+        walkable = MapFile_FindSection(header, base, file_size, MAP_SECTION_WALKABLE);
+        cost = MapFile_FindSection(header, base, file_size, MAP_SECTION_COST);
+        occupied = MapFile_FindSection(header, base, file_size, MAP_SECTION_OCCUPIED);
+        valid = walkable != NULL && cost != NULL && occupied != NULL;
+    }
+
+    if (!valid)
+    {
+        munmap(mapping, (size_t)file_size);
+        return false;
+    }
+
+    MapLayout layout =
+    {
+        .block_size = header->block_size,
+        .morton = (header->flags & MAP_FILE_FLAG_MORTON) != 0
+    };
+
+    MapLayers layers =
+    {
+        .tiles = (Tile *)(base + cost->offset),
+        .tiles_size = (size_t)cost->size,
+        .walkable_bits = (uint64_t *)(base + walkable->offset),
+        .walkable_size = (size_t)walkable->size,
+        .occupied_bits = (uint64_t *)(base + occupied->offset),
+        .occupied_size = (size_t)occupied->size,
+        .mapping = mapping,
+        .mapping_size = (size_t)file_size
+    };
+
+    if (!Map_InitWithLayers(map, header->width, header->height, &layout, &layers))
+    {
+        munmap(mapping, (size_t)file_size);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,112 @@
+#ifndef MAPFILE_H
+#define MAPFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "map.h"
+
+/*
+Binary map files, loaded by mapping them into memory.
+
+A file is a fixed header, a section table and the sections, each
+section starting on a MAP_FILE_ALIGNMENT boundary. Sections hold the
+map's stored layers byte for byte, in the storage layout named by the
+header, so loading points the Map straight into the mapping with no
+copy. The only pass over the tiles is the value check below.
+
+Values are in the byte order of the machine that wrote the file; a
+file from a machine of the other order fails the magic check.
+
+The loader checks the structure (magic, version, sizes, alignment and
+bounds) and the values: a cost outside MAP_TILE_COST_MIN..MAX or a
+set padding bit in a bit layer fails the load. Costly tiles are
+counted again rather than taken from the header.
+
+Layout, offsets in bytes:
+    0   MapFileHeader
+    64  MapFileSection[section_count]
+    ..  sections, each aligned
+*/
+
+// "RMAP" read as a little-endian 32-bit value
+#define MAP_FILE_MAGIC 0x50414D52u
+#define MAP_FILE_VERSION 1
+
+// Alignment of every section; a cache line, and enough for any layer
+#define MAP_FILE_ALIGNMENT 64
+
+// Sections a loader will look at; later entries are ignored
+#define MAP_FILE_MAX_SECTIONS 16
+
+#define MAP_FILE_FLAG_MORTON 0x1
+
+typedef enum
+{
+    MAP_SECTION_NONE = 0,
+
+    // Walkability bit layer, Map_BitLayerWords words
+    MAP_SECTION_WALKABLE,
+
+    // Tile array with the movement costs, one Tile per stored tile
+    MAP_SECTION_COST,
+
+    // Occupancy bit layer, Map_BitLayerWords words
+    MAP_SECTION_OCCUPIED
+} MapFileSectionType;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+
+    // Size of this header; the section table follows it
+    uint32_t header_size;
+    uint32_t section_count;
+
+    int32_t width;
+    int32_t height;
+
+    // Storage layout of every section: MapLayout block size and flags
+    int32_t block_size;
+    uint32_t flags;
+
+    // Tiles costing more than MAP_TILE_COST_MIN when written, for tools
+    // that read the header alone; the loader counts them itself
+    int32_t costly_tile_count;
+
+    // sizeof(Tile) of the writer; the cost section is only usable as is
+    // if it matches
+    uint32_t tile_size;
+
+    uint8_t reserved[24];
+} MapFileHeader;
+
+typedef struct
+{
+    // MapFileSectionType; unknown types are skipped
+    uint32_t type;
+    uint32_t reserved;
+
+    // From the start of the file, a multiple of MAP_FILE_ALIGNMENT
+    uint64_t offset;
+    uint64_t size;
+} MapFileSection;
+
+_Static_assert(sizeof(MapFileHeader) == 64, "map file header must stay 64 bytes");
+_Static_assert(sizeof(MapFileSection) == 24, "map file section entry must stay 24 bytes");
+
+// Writes the map's size, layout and stored layers. Returns false if
+// the file cannot be written.
+bool MapFile_Save(const Map *map, const char *path);
+
+/*
+Maps a map file and sets up the map over it. The layers stay in the
+mapping, private to this process: edits copy the pages they touch and
+never reach the file. Region labels start stale and landmark tables
+empty, as after terrain edits. Map_Free unmaps the file.
+Like Map_Init, it does not free a map already in place.
+Returns false if the file cannot be mapped or is not a valid map file.
+*/
+bool MapFile_Load(Map *map, const char *path);
+
+#endif
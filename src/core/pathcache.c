@@ -0,0 +1,217 @@
+#include "pathcache.h"
+
+#include <stddef.h>
+
+/*
+    Path cache module.
+
+    It owns:
+    - A fixed set of cached Path results
+    - Hit/miss counters
+
+    It does NOT:
+    - Modify Map
+    - Cache failed searches
+*/
+
+void PathCache_Init(PathCache *cache)
+{
+    *cache = (PathCache){0};
+}
+
+static bool PathCache_PathContains(const Path *path, int tx, int ty)
+{
+    for (int i = 0; i < path->length; ++i)
+    {
+        if (path->tiles[i][0] == tx && path->tiles[i][1] == ty)
+            return true;
+    }
+
+    return false;
+}
+
+/*
+    Every tile after the start must still be enterable.
+    The start tile is skipped: the unit asking is standing on it.
+*/
+static bool PathCache_PathStillClear(const Map *map, const Path *path)
+{
+    for (int i = 1; i < path->length; ++i)
+    {
+        int tx = path->tiles[i][0];
+        int ty = path->tiles[i][1];
+
+        if (!Map_IsWalkable(map, tx, ty) || Map_IsOccupied(map, tx, ty))
+            return false;
+    }
+
+    return true;
+}
+
+// Every option that can change the resulting path; the debug sink cannot
+static bool PathCache_SameOptions(const PathOptions *a, const PathOptions *b)
+{
+    return a->open_set == b->open_set &&
+        a->algorithm == b->algorithm &&
+        a->heuristic == b->heuristic &&
+        a->connectivity == b->connectivity &&
+        a->corner_cutting == b->corner_cutting &&
+        a->smooth == b->smooth;
+}
+
+static PathCacheEntry *PathCache_Lookup(
+    PathCache *cache, const Map *map, int start_tx, int start_ty, int goal_tx, int goal_ty,
+    const PathOptions *options)
+{
+    unsigned int revision = Map_GetWalkabilityRevision(map);
+
+    for (int i = 0; i < PATH_CACHE_CAPACITY; ++i)
+    {
+        PathCacheEntry *entry = &cache->entries[i];
+
+        if (!entry->valid)
+            continue;
+
+        if (entry->start_tx != start_tx || entry->start_ty != start_ty ||
+            entry->goal_tx != goal_tx || entry->goal_ty != goal_ty ||
+            !PathCache_SameOptions(&entry->options, options))
+            continue;
+
+        if (entry->map_revision != revision)
+        {
+            entry->valid = false;
+            continue;
+        }
+
+        if (!PathCache_PathStillClear(map, &entry->path))
+        {
+            entry->valid = false;
+            cache->stats.invalidations++;
+            continue;
+        }
+
+        return entry;
+    }
+
+    return NULL;
+}
+
+// Empty slot if any, otherwise the least recently used entry
+static PathCacheEntry *PathCache_Victim(PathCache *cache)
+{
+    PathCacheEntry *victim = &cache->entries[0];
+
+    for (int i = 0; i < PATH_CACHE_CAPACITY; ++i)
+    {
+        PathCacheEntry *entry = &cache->entries[i];
+
+        if (!entry->valid)
+            return entry;
+
+        if (entry->last_used < victim->last_used)
+            victim = entry;
+    }
+
+    return victim;
+}
+
+bool PathCache_Get(
+    PathCache *cache,
+    const Map *map,
+    int start_tx,
+    int start_ty,
+    int goal_tx,
+    int goal_ty,
+    const PathOptions *options,
+    Path *out_path
+)
+{
+    const PathOptions defaults = {0};
+    PathCacheEntry *entry = PathCache_Lookup(
+        cache, map, start_tx, start_ty, goal_tx, goal_ty, options != NULL ? options : &defaults);
+
+    if (entry == NULL)
+    {
+        cache->stats.misses++;
+        return false;
+    }
+
+    entry->last_used = ++cache->use_clock;
+    cache->stats.hits++;
+
+    *out_path = entry->path;
+    return true;
+}
+
+void PathCache_Put(
+    PathCache *cache,
+    const Map *map,
+    int start_tx,
+    int start_ty,
+    int goal_tx,
+    int goal_ty,
+    const PathOptions *options,
+    const Path *path
+)
+{
+    PathCacheEntry *entry = PathCache_Victim(cache);
+
+    entry->start_tx = start_tx;
+    entry->start_ty = start_ty;
+    entry->goal_tx = goal_tx;
+    entry->goal_ty = goal_ty;
+    entry->map_revision = Map_GetWalkabilityRevision(map);
+    entry->options = options != NULL ? *options : (PathOptions){0};
+    entry->options.debug = NULL;
+    entry->last_used = ++cache->use_clock;
+    entry->valid = true;
+    entry->path = *path;
+}
+
+bool PathCache_FindPath(
+    PathCache *cache,
+    PathContext *ctx,
+    const Map *map,
+    int start_tx,
+    int start_ty,
+    int goal_tx,
+    int goal_ty,
+    const PathOptions *options,
+    Path *out_path
+)
+{
+    bool wants_trace = options != NULL && options->debug != NULL;
+
+    if (!wants_trace && PathCache_Get(cache, map, start_tx, start_ty, goal_tx, goal_ty, options, out_path))
+        return true;
+
+    if (wants_trace)
+        cache->stats.misses++;
+
+    bool found = Pathfinding_FindPath(ctx, map, start_tx, start_ty, goal_tx, goal_ty, options, out_path);
+
+    if (found)
+        PathCache_Put(cache, map, start_tx, start_ty, goal_tx, goal_ty, options, out_path);
+
+    return found;
+}
+
+void PathCache_InvalidateTile(PathCache *cache, int tx, int ty)
+{
+    for (int i = 0; i < PATH_CACHE_CAPACITY; ++i)
+    {
+        PathCacheEntry *entry = &cache->entries[i];
+
+        if (entry->valid && PathCache_PathContains(&entry->path, tx, ty))
+        {
+            entry->valid = false;
+            cache->stats.invalidations++;
+        }
+    }
+}
+
+void PathCache_Clear(PathCache *cache)
+{
+    for (int i = 0; i < PATH_CACHE_CAPACITY; ++i)
+        cache->entries[i].valid = false;
+}
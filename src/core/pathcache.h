@@ -0,0 +1,115 @@
+#ifndef PATHCACHE_H
+#define PATHCACHE_H
+
+#include <stdbool.h>
+#include "map.h"
+#include "pathfinding.h"
+
+/*
+LRU cache of successful path results, in front of Pathfinding_FindPath.
+
+Entries are keyed by (start, goal, search options, map walkability
+revision), so a query only gets a path searched the way it asked for,
+and any terrain edit retires every older entry at once. The debug sink
+is not part of the key. Occupancy changes far
+more often, so it is checked per entry instead: a hit is only served
+if no tile on the cached path has become blocked or occupied since.
+Systems that know exactly which tile changed can drop affected
+entries eagerly with PathCache_InvalidateTile.
+
+Failed searches are not cached: occupancy that blocks a route now may
+clear a moment later.
+*/
+
+#define PATH_CACHE_CAPACITY 32
+
+typedef struct
+{
+    int start_tx;
+    int start_ty;
+    int goal_tx;
+    int goal_ty;
+    unsigned int map_revision;
+
+    // Options the path was searched with, debug sink cleared
+    PathOptions options;
+
+    // Use stamp for least-recently-used eviction
+    unsigned int last_used;
+    bool valid;
+
+    Path path;
+} PathCacheEntry;
+
+typedef struct
+{
+    // Queries answered from the cache
+    unsigned long hits;
+
+    // Queries that ran a search
+    unsigned long misses;
+
+    // Entries dropped because a tile on their path changed
+    unsigned long invalidations;
+} PathCacheStats;
+
+typedef struct
+{
+    PathCacheEntry entries[PATH_CACHE_CAPACITY];
+    unsigned int use_clock;
+
+    PathCacheStats stats;
+} PathCache;
+
+void PathCache_Init(PathCache *cache);
+
+/*
+Same contract as Pathfinding_FindPath.
+Queries with a debug sink always search so the trace is produced.
+*/
+bool PathCache_FindPath(
+    PathCache *cache,
+    PathContext *ctx,
+    const Map *map,
+    int start_tx,
+    int start_ty,
+    int goal_tx,
+    int goal_ty,
+    const PathOptions *options,
+    Path *out_path
+);
+
+/*
+Lookup and store halves of PathCache_FindPath, for callers that run
+the search themselves. Get counts a hit or a miss. options are the
+ones the search is or was run with, NULL for the defaults.
+*/
+bool PathCache_Get(
+    PathCache *cache,
+    const Map *map,
+    int start_tx,
+    int start_ty,
+    int goal_tx,
+    int goal_ty,
+    const PathOptions *options,
+    Path *out_path
+);
+
+void PathCache_Put(
+    PathCache *cache,
+    const Map *map,
+    int start_tx,
+    int start_ty,
+    int goal_tx,
+    int goal_ty,
+    const PathOptions *options,
+    const Path *path
+);
+
+// Drops every entry whose path crosses the tile.
+void PathCache_InvalidateTile(PathCache *cache, int tx, int ty);
+
+// Drops every entry and keeps the counters.
+void PathCache_Clear(PathCache *cache);
+
+#endif
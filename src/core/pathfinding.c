@@ -6,24 +6,29 @@ Implements A* pathfinding on the grid-based Map.
 This module:
 - Reads Map data
 - Does not modify Map
-- Does not allocate memory dynamically
+- Allocates only inside PathContext_Init, never during a search
 - Is fully deterministic
 */
 
-#include <stdio.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 #include "pathfinding.h"
 #include "map.h"
-
+#include "trace.h"
+#include "pathstats.h"
 
 /*
 Internal node used by A*.
 
 Each tile in the map corresponds to exactly one PathNode.
-Nodes are reused per pathfinding call.
+Nodes live in a PathContext and are reused across calls.
+
+A node whose generation differs from the context generation
+was last touched by an earlier search and counts as unvisited.
 */
-typedef struct
+struct PathNode
 {
 	int tx;
 	int ty;
@@ -34,17 +39,47 @@ typedef struct
 
 	int parent_index;
 
+	// Position inside the binary heap, -1 when not queued
+	int heap_index;
+
+	// Neighbours in the same bucket of the bucket queue, -1 at the ends
+	int bucket_prev;
+	int bucket_next;
+
+	// Search generation that last initialized this node
+	unsigned int generation;
+
 	bool opened;
 	bool closed;
-} PathNode;
+
+	// Backward search from the goal (bidirectional mode only):
+	// cost to the goal and the next tile toward it
+	int back_g_cost;
+	int back_f_cost;
+	int back_next_index;
+	int back_heap_index;
+
+	bool back_opened;
+	bool back_closed;
+};
+
+/*
+Direction a heap operation works on.
+The forward search grows from the start; the backward one from the goal.
+*/
+typedef enum
+{
+	PATH_SIDE_FORWARD = 0,
+	PATH_SIDE_BACKWARD
+} PathSide;
 
 /*
-Converts tile coordinates to linear index.
-Used internally for node array access.
+Converts tile coordinates to linear index on the map being searched.
+Used internally for node array access; matches Map_Index.
 */
-static int Path_Index(int tx, int ty)
+static int Path_Index(const PathContext *ctx, int tx, int ty)
 {
-	return ty * MAP_WIDTH + tx;
+	return ty * ctx->width + tx;
 };
 
 /*
@@ -56,18 +91,99 @@ static int Path_Heuristic(int ax, int ay, int bx, int by)
 	return abs(ax - bx) + abs(ay - by);
 };
 
+/*
+Returns octile distance in PATH_COST_* units: diagonal steps while
+both axes differ, straight steps for the rest.
+Admissible heuristic for 8-directional grid.
+*/
+static int Path_OctileHeuristic(int ax, int ay, int bx, int by)
+{
+	int dx = abs(ax - bx);
+	int dy = abs(ay - by);
+	int diagonal = dx < dy ? dx : dy;
+
+	return PATH_COST_DIAGONAL * diagonal + PATH_COST_STRAIGHT * (dx + dy - 2 * diagonal);
+}
+
+/*
+Estimate toward a target tile: Manhattan or octile, raised to the best
+landmark bound |d(L, target) - d(L, n)| when landmarks are enabled.
+Each bound is consistent, so their maximum is too.
+landmark_target holds d(L, target), -1 where a table is not used.
+
+Landmark tables count 4-connected steps. An 8-connected route of
+cost c has a 4-connected detour of at most c / 7 steps (a diagonal
+costs 14 and becomes two steps), so bounds are scaled by 7 there.
+*/
+static int Path_EstimateTo(
+	const PathContext *ctx,
+	const Map *map,
+	int tx,
+	int ty,
+	int target_tx,
+	int target_ty,
+	const int landmark_target[MAP_LANDMARK_COUNT]
+)
+{
+	bool diagonal = ctx->connectivity == PATH_CONNECTIVITY_8;
+	int h = diagonal
+		? Path_OctileHeuristic(tx, ty, target_tx, target_ty)
+		: Path_Heuristic(tx, ty, target_tx, target_ty);
+
+	if (ctx->heuristic != PATH_HEURISTIC_LANDMARKS)
+		return h;
+
+	int scale = diagonal ? PATH_COST_DIAGONAL / 2 : 1;
+
+	int index = Path_Index(ctx, tx, ty);
+
+	for (int i = 0; i < MAP_LANDMARK_COUNT; ++i)
+	{
+		if (landmark_target[i] < 0 || !map->landmark_usable[i])
+			continue;
+
+		int distance = Map_LandmarkTable(map, i)[index];
+
+		if (distance == MAP_LANDMARK_UNREACHABLE)
+			continue;
+
+		int bound = scale * abs(landmark_target[i] - distance);
+
+		if (bound > h)
+			h = bound;
+	}
+
+	return h;
+}
+
+// Estimate toward the goal for the forward search
+static int Path_Estimate(const PathContext *ctx, const Map *map, int tx, int ty)
+{
+	return Path_EstimateTo(ctx, map, tx, ty, ctx->goal_tx, ctx->goal_ty, ctx->landmark_goal);
+}
+
+// Estimate toward the start for the backward search
+static int Path_EstimateBack(const PathContext *ctx, const Map *map, int tx, int ty)
+{
+	return Path_EstimateTo(ctx, map, tx, ty, ctx->start_tx, ctx->start_ty, ctx->landmark_start);
+}
+
 /*
 Returns index of the opened node with the lowest f_cost.
 If none found, returns -1.
 
 Linear scan — simple and deterministic.
 */
-static int Path_FindLowestCost(PathNode *nodes)
+static int Path_FindLowestCost(const PathContext *ctx)
 {
+    const PathNode *nodes = ctx->nodes;
     int best_index = -1;
 
-    for (int i = 0; i < MAP_WIDTH * MAP_HEIGHT; ++i)
+    for (int i = 0; i < ctx->node_count; ++i)
     {
+        if (nodes[i].generation != ctx->generation)
+            continue;
+
         if (!nodes[i].opened)
             continue;
 
@@ -85,204 +201,1508 @@ static int Path_FindLowestCost(PathNode *nodes)
 }
 
 /*
-Finds a path between start and goal tile coordinates.
+Returns the node for a tile, lazily resetting it if it belongs
+to an earlier search. This keeps per-search setup proportional
+to the area explored instead of the map size.
+*/
+static PathNode *Path_GetNode(PathContext *ctx, int tx, int ty)
+{
+	PathNode *node = &ctx->nodes[Path_Index(ctx, tx, ty)];
 
-Returns:
-    true  -> path found, out_path is filled
-    false -> no path possible
+	if (node->generation != ctx->generation)
+	{
+		node->tx = tx;
+		node->ty = ty;
 
-Rules:
-- Does not allocate memory
-- Does not modify Map
-- Deterministic behavior
+		node->g_cost = 0;
+		node->h_cost = 0;
+		node->f_cost = 0;
+
+		node->parent_index = -1;
+		node->heap_index = -1;
+		node->bucket_prev = -1;
+		node->bucket_next = -1;
+
+		node->opened = false;
+		node->closed = false;
+
+		node->back_g_cost = 0;
+		node->back_f_cost = 0;
+		node->back_next_index = -1;
+		node->back_heap_index = -1;
+
+		node->back_opened = false;
+		node->back_closed = false;
+
+		node->generation = ctx->generation;
+	}
+
+	return node;
+}
+
+/*
+Starts a new search generation.
+On counter wrap-around every node is stamped stale explicitly,
+so a node untouched for 2^32 searches cannot look current.
 */
-bool Pathfinding_FindPath(
-	const Map *map,
-	int start_tx,
-	int start_ty,
-	int goal_tx,
-	int goal_ty,
-	Path *out_path
-)
+static void Path_BeginGeneration(PathContext *ctx)
 {
-	printf("-- Pathfinding start --\n");
-	printf("Start: (%d,%d)\n", start_tx, start_ty);
-	printf("Goal:  (%d,%d)\n", goal_tx, goal_ty);
-	printf("Goal walkable: %d\n", Map_IsWalkable(map, goal_tx, goal_ty));
-	printf("Goal occupied: %d\n", Map_IsOccupied(map, goal_tx, goal_ty));
-	fflush(stdout);
+	ctx->generation++;
 
-	// Initialize debug arrays
-	for (int i = 0; i < MAP_NODE_COUNT; ++i)
+	if (ctx->generation == 0)
 	{
-		out_path->debug_open[i] = false;
-		out_path->debug_closed[i] = false;
-		out_path->debug_in_path[i] = false;
+		for (int i = 0; i < ctx->node_count; ++i)
+			ctx->nodes[i].generation = 0;
+
+		ctx->generation = 1;
 	}
 
-	// Reset output path
-	out_path->length = 0;
+	ctx->open_count = 0;
+	ctx->back_open_count = 0;
 
-	// Basic validation
-	if (!Map_IsInside(map, start_tx, start_ty))
-		return false;
+	for (int i = 0; i < PATH_BUCKET_COUNT; ++i)
+		ctx->buckets[i] = -1;
 
-	if (!Map_IsInside(map, goal_tx, goal_ty))
-		return false;
+	ctx->bucket_cursor = 0;
+}
 
-	if (!Map_IsWalkable(map, goal_tx, goal_ty))
-		return false;
+/*
+Counts a node just pushed onto an open set. Both frontiers of a
+bidirectional search add up to its open set size.
+*/
+static void Path_NoteOpened(PathContext *ctx)
+{
+	int open = ctx->open_count + ctx->back_open_count;
 
-	// special case: already at goal
-	if (start_tx == goal_tx && start_ty == goal_ty)
+	ctx->opened++;
+
+	if (open > ctx->peak_open)
+		ctx->peak_open = open;
+}
+
+/*
+Open set: binary min-heap of node indices ordered by (f_cost, node index).
+
+Every node stores its heap position, so an improved g_cost can be
+sifted up in place (decrease-key) instead of being pushed twice.
+Breaking f_cost ties by node index reproduces exactly the order the
+linear scan picks nodes in, keeping searches deterministic.
+
+The bidirectional search keeps a second heap for its backward side,
+keyed on the backward fields of the same nodes.
+*/
+static int *Path_HeapItems(PathContext *ctx, PathSide side)
+{
+	return side == PATH_SIDE_FORWARD ? ctx->open_heap : ctx->back_heap;
+}
+
+static int *Path_HeapCount(PathContext *ctx, PathSide side)
+{
+	return side == PATH_SIDE_FORWARD ? &ctx->open_count : &ctx->back_open_count;
+}
+
+static int *Path_HeapSlot(PathContext *ctx, PathSide side, int node_index)
+{
+	PathNode *node = &ctx->nodes[node_index];
+
+	return side == PATH_SIDE_FORWARD ? &node->heap_index : &node->back_heap_index;
+}
+
+static int Path_HeapKey(const PathNode *nodes, PathSide side, int node_index)
+{
+	return side == PATH_SIDE_FORWARD ? nodes[node_index].f_cost : nodes[node_index].back_f_cost;
+}
+
+// Heap ordering: lower f_cost first, lower node index on ties.
+static bool Path_HeapLess(const PathNode *nodes, PathSide side, int a, int b)
+{
+	int fa = Path_HeapKey(nodes, side, a);
+	int fb = Path_HeapKey(nodes, side, b);
+
+	if (fa != fb)
+		return fa < fb;
+
+	return a < b;
+}
+
+static void Path_HeapSwap(PathContext *ctx, PathSide side, int i, int j)
+{
+	int *heap = Path_HeapItems(ctx, side);
+	int a = heap[i];
+	int b = heap[j];
+
+	heap[i] = b;
+	heap[j] = a;
+
+	*Path_HeapSlot(ctx, side, b) = i;
+	*Path_HeapSlot(ctx, side, a) = j;
+}
+
+static void Path_HeapSiftUp(PathContext *ctx, PathSide side, int i)
+{
+	int *heap = Path_HeapItems(ctx, side);
+
+	while (i > 0)
 	{
-	    out_path->tiles[0][0] = start_tx;
-	    out_path->tiles[0][1] = start_ty;
-	    out_path->length = 1;
-	    return true;
+		int parent = (i - 1) / 2;
+
+		if (!Path_HeapLess(ctx->nodes, side, heap[i], heap[parent]))
+			break;
+
+		Path_HeapSwap(ctx, side, i, parent);
+		i = parent;
 	}
+}
 
-	// create node grid
-	PathNode nodes[MAP_WIDTH * MAP_HEIGHT];
+static void Path_HeapSiftDown(PathContext *ctx, PathSide side, int i)
+{
+	int *heap = Path_HeapItems(ctx, side);
+	int count = *Path_HeapCount(ctx, side);
 
-	// Initialize all nodes
-	for (int ty= 0; ty< MAP_HEIGHT; ty++)
+	while (1)
 	{
-		for (int tx = 0; tx < MAP_WIDTH; tx++)
-		{
-			int index = Path_Index(tx, ty);
+		int left = 2 * i + 1;
+		int right = left + 1;
+		int smallest = i;
 
-			nodes[index].tx = tx;
-			nodes[index].ty = ty;
+		if (left < count &&
+			Path_HeapLess(ctx->nodes, side, heap[left], heap[smallest]))
+			smallest = left;
 
-			nodes[index].g_cost = 0;
-			nodes[index].h_cost = 0;
-			nodes[index].f_cost = 0;
+		if (right < count &&
+			Path_HeapLess(ctx->nodes, side, heap[right], heap[smallest]))
+			smallest = right;
 
-			nodes[index].parent_index = -1;
+		if (smallest == i)
+			break;
 
-			nodes[index].opened = false;
-			nodes[index].closed = false;
-		}
+		Path_HeapSwap(ctx, side, i, smallest);
+		i = smallest;
 	}
+}
 
-	// Setup start node
-	int start_index = Path_Index(start_tx, start_ty);
+static void Path_HeapPush(PathContext *ctx, PathSide side, int node_index)
+{
+	int i = (*Path_HeapCount(ctx, side))++;
 
-	nodes[start_index].g_cost = 0;
-	nodes[start_index].h_cost = Path_Heuristic(start_tx, start_ty, goal_tx, goal_ty);
-	nodes[start_index].f_cost = nodes[start_index].g_cost + nodes[start_index].h_cost;
+	Path_HeapItems(ctx, side)[i] = node_index;
+	*Path_HeapSlot(ctx, side, node_index) = i;
 
-	nodes[start_index].opened = true;
-	out_path->debug_open[start_index] = true;
+	Path_HeapSiftUp(ctx, side, i);
+	Path_NoteOpened(ctx);
+}
 
-	// --- A* Main Loop ---
-	while(1)
+/*
+Removes and returns the node with the lowest f_cost.
+If the heap is empty, returns -1.
+*/
+static int Path_HeapPop(PathContext *ctx, PathSide side)
+{
+	int *heap = Path_HeapItems(ctx, side);
+	int *count = Path_HeapCount(ctx, side);
+
+	if (*count == 0)
+		return -1;
+
+	int top = heap[0];
+
+	(*count)--;
+
+	if (*count > 0)
 	{
-		int current_index = Path_FindLowestCost(nodes);
+		heap[0] = heap[*count];
+		*Path_HeapSlot(ctx, side, heap[0]) = 0;
+		Path_HeapSiftDown(ctx, side, 0);
+	}
 
-		// no open nodes left - no path
-		if (current_index == -1)
-			return false;
+	*Path_HeapSlot(ctx, side, top) = -1;
 
-		PathNode *current = &nodes[current_index];
+	return top;
+}
 
-		// if goal reached - stop search
-		if (current->tx == goal_tx && current->ty == goal_ty)
-			break;
+/*
+Restores heap order after a node's f_cost decreased.
+*/
+static void Path_HeapDecreaseKey(PathContext *ctx, PathSide side, int node_index)
+{
+	Path_HeapSiftUp(ctx, side, *Path_HeapSlot(ctx, side, node_index));
+}
 
-		current->opened = false;
-		current->closed = true;
-		out_path->debug_closed[current_index] = true;
+/*
+Open set: Dial's bucket queue, one list of nodes per f_cost value.
 
-		// neigbour offsets (Up, right, down, Left)
-		const int offsets[4][2] = 
-		{
-			{ 0, -1 },
-			{ 1,  0 },
-			{ 0,  1 },
-			{ -1, 0 }
-		};
+Integer step costs and a consistent heuristic keep every open f_cost
+within one step's cost plus one heuristic change of the lowest, so
+PATH_BUCKET_COUNT buckets indexed by f_cost modulo the count never
+mix two values. Push, pop and decrease-key are O(1); pop scans
+forward from the last bucket it emptied.
 
-		for (int i = 0; i < 4; ++i)
-		{
-			int nx = current->tx + offsets[i][0];
-			int ny = current->ty + offsets[i][1];
+Nodes within a bucket come out last in, first out, so equal-cost
+paths may differ in shape from the heap's.
 
-			if (!Map_IsInside(map, nx, ny))	
-				continue;
+The span only holds for single-tile steps. JPS successors cost a whole
+jump, so JPS searches always use the heap.
+*/
+_Static_assert(
+	PATH_BUCKET_COUNT > PATH_COST_DIAGONAL * (MAP_TILE_COST_MAX + 1),
+	"bucket queue must span the largest single-tile step cost plus heuristic change");
+_Static_assert(
+	(PATH_BUCKET_COUNT & (PATH_BUCKET_COUNT - 1)) == 0,
+	"bucket count must be a power of two");
 
-			if (!Map_IsWalkable(map, nx, ny))
-				continue;
+static void Path_BucketLink(PathContext *ctx, int node_index)
+{
+	PathNode *node = &ctx->nodes[node_index];
+	int *head = &ctx->buckets[node->f_cost & (PATH_BUCKET_COUNT - 1)];
 
-			/*
-			Design Choice
+	node->bucket_prev = -1;
+	node->bucket_next = *head;
 
-			Currently:
-			* Goal tile may be occupied
-			* But it will never step into it
-			* So A* will fail naturally
-			Should pathfinding itself reject occupied goal early?
-			Or should that remain command-layer policy?
-			*/
-			if (Map_IsOccupied(map, nx, ny))
-			    continue;
+	if (*head != -1)
+		ctx->nodes[*head].bucket_prev = node_index;
 
-			int neigbhour_index = Path_Index(nx, ny);
-			PathNode *neighbour = &nodes[neigbhour_index];
+	*head = node_index;
+}
 
-			if (neighbour->closed)
-				continue;
+static void Path_BucketUnlink(PathContext *ctx, int node_index)
+{
+	PathNode *node = &ctx->nodes[node_index];
 
-			int tentative_g = current->g_cost + 1;
+	if (node->bucket_prev != -1)
+		ctx->nodes[node->bucket_prev].bucket_next = node->bucket_next;
+	else
+		ctx->buckets[node->f_cost & (PATH_BUCKET_COUNT - 1)] = node->bucket_next;
 
-			if (!neighbour->opened || tentative_g < neighbour->g_cost)
-			{
-				neighbour->g_cost = tentative_g;
-				neighbour->h_cost = Path_Heuristic(nx, ny, goal_tx, goal_ty);
-				neighbour->f_cost = neighbour->g_cost + neighbour->h_cost;
+	if (node->bucket_next != -1)
+		ctx->nodes[node->bucket_next].bucket_prev = node->bucket_prev;
 
-				neighbour->parent_index = current_index;
-				neighbour->opened = true;
-			}
-		}
-	}
+	node->bucket_prev = -1;
+	node->bucket_next = -1;
+}
 
-	// --- Path Reconstruction ---
+static void Path_BucketPush(PathContext *ctx, int node_index)
+{
+	int f_cost = ctx->nodes[node_index].f_cost;
 
-	// Goal node index
-	int goal_index = Path_Index(goal_tx, goal_ty);
+	if (ctx->open_count == 0 || f_cost < ctx->bucket_cursor)
+		ctx->bucket_cursor = f_cost;
 
-	int path_indices[MAX_PATH_LENGTH];
-	int path_length = 0;
+	Path_BucketLink(ctx, node_index);
+	ctx->open_count++;
+	Path_NoteOpened(ctx);
+}
 
-	int current_index = goal_index;
+/*
+Removes and returns a node with the lowest f_cost.
+If the queue is empty, returns -1.
+*/
+static int Path_BucketPop(PathContext *ctx)
+{
+	if (ctx->open_count == 0)
+		return -1;
 
-	// Walk backwards from goal to start
-	// goal -> parent -> parent -> ... -> start
-	while (current_index != -1)
-	{
-		if (path_length >= MAX_PATH_LENGTH)
-			// Path too long for buffer
-			return false;
+	while (ctx->buckets[ctx->bucket_cursor & (PATH_BUCKET_COUNT - 1)] == -1)
+		ctx->bucket_cursor++;
 
-		path_indices[path_length++] = current_index;
-		current_index = nodes[current_index].parent_index;
-	}
+	int top = ctx->buckets[ctx->bucket_cursor & (PATH_BUCKET_COUNT - 1)];
 
-	// Reverse order (start -> ... -> goal)
-	for (int i = 0; i < path_length; ++i)
+	Path_BucketUnlink(ctx, top);
+	ctx->open_count--;
+
+	return top;
+}
+
+/*
+Moves a node to its bucket after its f_cost decreased.
+old_f_cost locates the bucket it is still linked into.
+*/
+static void Path_BucketDecreaseKey(PathContext *ctx, int node_index, int old_f_cost)
+{
+	PathNode *node = &ctx->nodes[node_index];
+	int new_f_cost = node->f_cost;
+
+	node->f_cost = old_f_cost;
+	Path_BucketUnlink(ctx, node_index);
+
+	node->f_cost = new_f_cost;
+	Path_BucketLink(ctx, node_index);
+
+	if (new_f_cost < ctx->bucket_cursor)
+		ctx->bucket_cursor = new_f_cost;
+}
+
+/*
+Forward open set operations, dispatched on the configured structure.
+The linear scan keeps no structure: it finds nodes by their flags,
+and only counts them for the statistics.
+*/
+static void Path_OpenPush(PathContext *ctx, int node_index)
+{
+	if (ctx->open_set == PATH_OPEN_SET_BINARY_HEAP)
+		Path_HeapPush(ctx, PATH_SIDE_FORWARD, node_index);
+	else if (ctx->open_set == PATH_OPEN_SET_BUCKET_QUEUE)
+		Path_BucketPush(ctx, node_index);
+	else
 	{
-		int reversed_index = path_indices[path_length - 1 - i];
-		PathNode *node = &nodes[reversed_index];
+		ctx->open_count++;
+		Path_NoteOpened(ctx);
+	}
+}
+
+static int Path_OpenPop(PathContext *ctx)
+{
+	if (ctx->open_set == PATH_OPEN_SET_BINARY_HEAP)
+		return Path_HeapPop(ctx, PATH_SIDE_FORWARD);
+
+	if (ctx->open_set == PATH_OPEN_SET_BUCKET_QUEUE)
+		return Path_BucketPop(ctx);
+
+	int lowest = Path_FindLowestCost(ctx);
+
+	if (lowest != -1)
+		ctx->open_count--;
 
-		out_path->tiles[i][0] = node->tx;
-		out_path->tiles[i][1] = node->ty;
+	return lowest;
+}
+
+static void Path_OpenDecreaseKey(PathContext *ctx, int node_index, int old_f_cost)
+{
+	if (ctx->open_set == PATH_OPEN_SET_BINARY_HEAP)
+		Path_HeapDecreaseKey(ctx, PATH_SIDE_FORWARD, node_index);
+	else if (ctx->open_set == PATH_OPEN_SET_BUCKET_QUEUE)
+		Path_BucketDecreaseKey(ctx, node_index, old_f_cost);
+}
 
-		out_path->debug_in_path[reversed_index] = true;
+bool PathDebug_Init(PathDebug *debug, int node_count)
+{
+	debug->open = calloc((size_t)node_count, sizeof(bool));
+	debug->closed = calloc((size_t)node_count, sizeof(bool));
+	debug->in_path = calloc((size_t)node_count, sizeof(bool));
+	debug->node_count = node_count;
+
+	if (debug->open == NULL || debug->closed == NULL || debug->in_path == NULL)
+	{
+		PathDebug_Free(debug);
+		return false;
 	}
 
-	out_path->length = path_length;
+	return true;
+}
+
+void PathDebug_Free(PathDebug *debug)
+{
+	free(debug->open);
+	free(debug->closed);
+	free(debug->in_path);
+
+	debug->open = NULL;
+	debug->closed = NULL;
+	debug->in_path = NULL;
+	debug->node_count = 0;
+}
+
+void PathDebug_Clear(PathDebug *debug)
+{
+	if (debug->node_count == 0)
+		return;
+
+	memset(debug->open, 0, (size_t)debug->node_count * sizeof(bool));
+	memset(debug->closed, 0, (size_t)debug->node_count * sizeof(bool));
+	memset(debug->in_path, 0, (size_t)debug->node_count * sizeof(bool));
+}
+
+bool PathContext_Init(PathContext *ctx, int node_count)
+{
+	ctx->nodes = calloc((size_t)node_count, sizeof(PathNode));
+	ctx->open_heap = malloc((size_t)node_count * sizeof(int));
+	ctx->back_heap = malloc((size_t)node_count * sizeof(int));
+	ctx->buckets = malloc(PATH_BUCKET_COUNT * sizeof(int));
+	ctx->route = malloc((size_t)node_count * sizeof(int));
+	ctx->open_count = 0;
+	ctx->back_open_count = 0;
+	ctx->node_count = node_count;
+	ctx->width = 0;
+	ctx->generation = 0;
+	ctx->expansions = 0;
+	ctx->opened = 0;
+	ctx->peak_open = 0;
+	ctx->elapsed_ns = 0;
+	ctx->stats = NULL;
+
+	if (ctx->nodes == NULL || ctx->open_heap == NULL || ctx->back_heap == NULL ||
+		ctx->buckets == NULL || ctx->route == NULL)
+	{
+		PathContext_Free(ctx);
+		return false;
+	}
 
 	return true;
 }
+
+void PathContext_Free(PathContext *ctx)
+{
+	free(ctx->nodes);
+	free(ctx->open_heap);
+	free(ctx->back_heap);
+	free(ctx->buckets);
+	free(ctx->route);
+
+	ctx->nodes = NULL;
+	ctx->open_heap = NULL;
+	ctx->back_heap = NULL;
+	ctx->buckets = NULL;
+	ctx->route = NULL;
+	ctx->node_count = 0;
+}
+
+/*
+Returns true if a unit may step onto the tile.
+Shared by every search mode so they agree on what blocks movement.
+
+Design Choice
+
+Currently:
+* Goal tile may be occupied
+* But it will never step into it
+* So the search will fail naturally
+Should pathfinding itself reject occupied goal early?
+Or should that remain command-layer policy?
+*/
+static bool Path_IsPassable(const Map *map, int tx, int ty)
+{
+	if (!Map_IsInside(map, tx, ty))
+		return false;
+
+	if (!Map_IsWalkable(map, tx, ty))
+		return false;
+
+	return !Map_IsOccupied(map, tx, ty);
+}
+
+static int Path_Sign(int value)
+{
+	return (value > 0) - (value < 0);
+}
+
+/*
+Returns true if the move by (dx, dy) out of a tile may be taken,
+leaving the destination itself to the caller.
+Diagonal moves also need the two orthogonal tiles they pass:
+both free, or one with corner cutting enabled.
+*/
+static bool Path_CanStep(const PathContext *ctx, const Map *map, int tx, int ty, int dx, int dy)
+{
+	if (dx == 0 || dy == 0)
+		return true;
+
+	bool horizontal = Path_IsPassable(map, tx + dx, ty);
+	bool vertical = Path_IsPassable(map, tx, ty + dy);
+
+	if (ctx->corner_cutting)
+		return horizontal || vertical;
+
+	return horizontal && vertical;
+}
+
+/*
+Cost of one move by (dx, dy) onto the tile (tx, ty), in the
+context's cost units: the base step scaled by the terrain entered.
+*/
+static int Path_StepCost(const PathContext *ctx, const Map *map, int tx, int ty, int dx, int dy)
+{
+	int terrain = Map_GetCost(map, tx, ty);
+
+	if (ctx->connectivity != PATH_CONNECTIVITY_8)
+		return terrain;
+
+	return terrain * (dx != 0 && dy != 0 ? PATH_COST_DIAGONAL : PATH_COST_STRAIGHT);
+}
+
+// Number of neighbour offsets the search looks at
+static int Path_NeighbourCount(const PathContext *ctx)
+{
+	return ctx->connectivity == PATH_CONNECTIVITY_8 ? 8 : 4;
+}
+
+/*
+Successor of a node: the tile to relax and the step cost to reach it.
+Plain A* yields adjacent tiles with the cost of one step.
+JPS yields jump points further along a straight line.
+*/
+typedef struct
+{
+	int tx;
+	int ty;
+	int cost;
+} PathSuccessor;
+
+// neigbour offsets (Up, right, down, Left, then the diagonals)
+static const int PATH_OFFSETS[8][2] =
+{
+	{ 0, -1 },
+	{ 1,  0 },
+	{ 0,  1 },
+	{ -1, 0 },
+	{ 1, -1 },
+	{ 1,  1 },
+	{ -1, 1 },
+	{ -1, -1 }
+};
+
+/*
+Jump Point Search on a 4-connected grid.
+
+Canonical paths move vertically first and only turn horizontal
+when a row becomes interesting, so:
+- horizontal jumps stop at the goal or at a forced neighbour
+  (a tile above/below that was blocked one step behind)
+- vertical jumps stop at the goal or where a horizontal jump
+  from the current tile would find a jump point
+
+Everything in between is symmetric and never enters the open set.
+Only valid for uniform step costs.
+*/
+static bool Path_JumpHorizontal(
+	const Map *map, int tx, int ty, int dx, int goal_tx, int goal_ty, int *out_tx)
+{
+	/*
+	Scans 64 tiles per step with the map's row words. Bit i of a
+	window stands for tile first + i; rightward jumps take the lowest
+	stopping bit, leftward ones the highest. A tile stops the jump if
+	it is impassable (no jump point), the goal, or has a forced
+	neighbour: passable above or below while the tile behind it
+	on that row is not.
+	*/
+	int first = dx > 0 ? tx + 1 : tx - MAP_BITS_PER_WORD;
+
+	while (1)
+	{
+		uint64_t row = Map_PassableRow(map, first, ty);
+		uint64_t up = Map_PassableRow(map, first, ty - 1);
+		uint64_t down = Map_PassableRow(map, first, ty + 1);
+		uint64_t up_behind = Map_PassableRow(map, first - dx, ty - 1);
+		uint64_t down_behind = Map_PassableRow(map, first - dx, ty + 1);
+
+		uint64_t stop = ~row | (up & ~up_behind) | (down & ~down_behind);
+
+		if (ty == goal_ty && goal_tx >= first && goal_tx < first + MAP_BITS_PER_WORD)
+			stop |= (uint64_t)1 << (goal_tx - first);
+
+		if (stop != 0)
+		{
+			int bit = dx > 0 ? __builtin_ctzll(stop) : MAP_BITS_PER_WORD - 1 - __builtin_clzll(stop);
+
+			if (!((row >> bit) & 1u))
+				return false;
+
+			*out_tx = first + bit;
+			return true;
+		}
+
+		first += dx * MAP_BITS_PER_WORD;
+	}
+}
+
+static bool Path_JumpVertical(
+	const Map *map, int tx, int ty, int dy, int goal_tx, int goal_ty, int *out_ty)
+{
+	int unused_tx;
+
+	while (1)
+	{
+		ty += dy;
+
+		if (!Path_IsPassable(map, tx, ty))
+			return false;
+
+		if (tx == goal_tx && ty == goal_ty)
+			break;
+
+		if (Path_JumpHorizontal(map, tx, ty, 1, goal_tx, goal_ty, &unused_tx) ||
+			Path_JumpHorizontal(map, tx, ty, -1, goal_tx, goal_ty, &unused_tx))
+			break;
+	}
+
+	*out_ty = ty;
+	return true;
+}
+
+/*
+Returns the directions JPS explores from a node, given the
+direction it was reached from (0,0 for the start node).
+*/
+static int Path_JpsDirections(const Map *map, int tx, int ty, int dx, int dy, int out_dirs[4][2])
+{
+	int count = 0;
+
+	if (dx == 0 && dy == 0)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			out_dirs[count][0] = PATH_OFFSETS[i][0];
+			out_dirs[count][1] = PATH_OFFSETS[i][1];
+			count++;
+		}
+	}
+	else if (dx != 0)
+	{
+		out_dirs[count][0] = dx;
+		out_dirs[count][1] = 0;
+		count++;
+
+		for (int side = -1; side <= 1; side += 2)
+		{
+			if (Path_IsPassable(map, tx, ty + side) &&
+				!Path_IsPassable(map, tx - dx, ty + side))
+			{
+				out_dirs[count][0] = 0;
+				out_dirs[count][1] = side;
+				count++;
+			}
+		}
+	}
+	else
+	{
+		out_dirs[count][0] = 0;
+		out_dirs[count][1] = dy;
+		count++;
+
+		out_dirs[count][0] = 1;
+		out_dirs[count][1] = 0;
+		count++;
+
+		out_dirs[count][0] = -1;
+		out_dirs[count][1] = 0;
+		count++;
+	}
+
+	return count;
+}
+
+/*
+Fills out with the successors of the current node.
+Returns the number of successors written (at most 8).
+*/
+static int Path_CollectSuccessors(
+	const PathContext *ctx,
+	const Map *map,
+	const PathNode *current,
+	PathAlgorithm algorithm,
+	int goal_tx,
+	int goal_ty,
+	PathSuccessor out[8]
+)
+{
+	int count = 0;
+
+	if (algorithm == PATH_ALGORITHM_ASTAR)
+	{
+		int neighbour_count = Path_NeighbourCount(ctx);
+
+		for (int i = 0; i < neighbour_count; ++i)
+		{
+			int dx = PATH_OFFSETS[i][0];
+			int dy = PATH_OFFSETS[i][1];
+			int nx = current->tx + dx;
+			int ny = current->ty + dy;
+
+			if (!Path_IsPassable(map, nx, ny))
+				continue;
+
+			if (!Path_CanStep(ctx, map, current->tx, current->ty, dx, dy))
+				continue;
+
+			out[count++] = (PathSuccessor){ nx, ny, Path_StepCost(ctx, map, nx, ny, dx, dy) };
+		}
+
+		return count;
+	}
+
+	// Arrival direction is implied by the parent jump point
+	int dx = 0;
+	int dy = 0;
+
+	if (current->parent_index != -1)
+	{
+		const PathNode *parent = &ctx->nodes[current->parent_index];
+		dx = Path_Sign(current->tx - parent->tx);
+		dy = Path_Sign(current->ty - parent->ty);
+	}
+
+	int dirs[4][2];
+	int dir_count = Path_JpsDirections(map, current->tx, current->ty, dx, dy, dirs);
+
+	for (int i = 0; i < dir_count; ++i)
+	{
+		int jx = current->tx;
+		int jy = current->ty;
+		bool found;
+
+		if (dirs[i][0] != 0)
+			found = Path_JumpHorizontal(map, jx, jy, dirs[i][0], goal_tx, goal_ty, &jx);
+		else
+			found = Path_JumpVertical(map, jx, jy, dirs[i][1], goal_tx, goal_ty, &jy);
+
+		if (!found)
+			continue;
+
+		int cost = abs(jx - current->tx) + abs(jy - current->ty);
+		out[count++] = (PathSuccessor){ jx, jy, cost };
+	}
+
+	return count;
+}
+
+// Distance from landmark i to a tile, -1 where the table cannot be used
+static int Path_LandmarkDistance(const Map *map, int i, int tx, int ty)
+{
+	if (!map->landmark_usable[i])
+		return -1;
+
+	int distance = Map_LandmarkTable(map, i)[Map_Index(map, tx, ty)];
+
+	return distance == MAP_LANDMARK_UNREACHABLE ? -1 : distance;
+}
+
+/*
+Validates the query and seeds the open set with the start node.
+All search state lives in the context, so the search can be
+advanced in slices with Pathfinding_StepSearch.
+*/
+static PathSearchStatus Path_Begin(
+	PathContext *ctx,
+	const Map *map,
+	int start_tx,
+	int start_ty,
+	int goal_tx,
+	int goal_ty,
+	const PathOptions *options
+)
+{
+	TRACE_EVENT(
+		TRACE_EVENT_PATH_BEGIN,
+		(Map_IsWalkable(map, goal_tx, goal_ty) ? TRACE_FLAG_GOAL_WALKABLE : 0) |
+		(Map_IsOccupied(map, goal_tx, goal_ty) ? TRACE_FLAG_GOAL_OCCUPIED : 0),
+		start_tx, start_ty, goal_tx, goal_ty);
+
+	ctx->start_tx = start_tx;
+	ctx->start_ty = start_ty;
+	ctx->goal_tx = goal_tx;
+	ctx->goal_ty = goal_ty;
+
+	ctx->open_set = options ? options->open_set : PATH_OPEN_SET_BINARY_HEAP;
+	ctx->algorithm = options ? options->algorithm : PATH_ALGORITHM_ASTAR;
+	ctx->heuristic = options ? options->heuristic : PATH_HEURISTIC_MANHATTAN;
+	ctx->connectivity = options ? options->connectivity : PATH_CONNECTIVITY_4;
+	ctx->corner_cutting = options ? options->corner_cutting : false;
+	ctx->smooth = options ? options->smooth : false;
+	ctx->debug = options ? options->debug : NULL;
+	ctx->map = map;
+	ctx->width = map->width;
+
+	// A trace too small for this map is not written at all
+	if (ctx->debug && ctx->debug->node_count < Map_TileCount(map))
+		ctx->debug = NULL;
+
+	// Both frontiers of a bidirectional search live in heaps
+	if (ctx->algorithm == PATH_ALGORITHM_BIDIRECTIONAL)
+		ctx->open_set = PATH_OPEN_SET_BINARY_HEAP;
+
+	// Jump rules assume four directions and uniform step costs
+	if (ctx->algorithm == PATH_ALGORITHM_JPS &&
+		(ctx->connectivity == PATH_CONNECTIVITY_8 || !Map_HasUniformCost(map)))
+		ctx->algorithm = PATH_ALGORITHM_ASTAR;
+
+	// A jump costs its whole length, which can exceed the bucket span
+	if (ctx->algorithm == PATH_ALGORITHM_JPS)
+		ctx->open_set = PATH_OPEN_SET_BINARY_HEAP;
+
+	ctx->expansions = 0;
+	ctx->opened = 0;
+	ctx->peak_open = 0;
+	ctx->status = PATH_SEARCH_FAILED;
+
+	// Trace is cleared even on early failure so no stale overlay remains
+	if (ctx->debug)
+		PathDebug_Clear(ctx->debug);
+
+	// Basic validation
+	if (ctx->node_count < Map_TileCount(map))
+		return ctx->status;
+
+	if (!Map_IsInside(map, start_tx, start_ty))
+		return ctx->status;
+
+	if (!Map_IsInside(map, goal_tx, goal_ty))
+		return ctx->status;
+
+	if (!Map_IsWalkable(map, goal_tx, goal_ty))
+		return ctx->status;
+
+	// Walled-off goal: fail now instead of exhausting the start's region
+	if (!Map_AreConnected(map, start_tx, start_ty, goal_tx, goal_ty))
+		return ctx->status;
+
+	bool at_goal = start_tx == goal_tx && start_ty == goal_ty;
+
+	// The backward search starts on the goal, so it must be enterable
+	if (ctx->algorithm == PATH_ALGORITHM_BIDIRECTIONAL && !at_goal &&
+		!Path_IsPassable(map, goal_tx, goal_ty))
+		return ctx->status;
+
+	// Both ends of every landmark bound, looked up once per search
+	for (int i = 0; i < MAP_LANDMARK_COUNT; ++i)
+	{
+		ctx->landmark_goal[i] = Path_LandmarkDistance(map, i, goal_tx, goal_ty);
+		ctx->landmark_start[i] = Path_LandmarkDistance(map, i, start_tx, start_ty);
+	}
+
+	// Every node from previous searches becomes stale at once
+	Path_BeginGeneration(ctx);
+
+	// Setup start node
+	int start_index = Path_Index(ctx, start_tx, start_ty);
+	PathNode *start = Path_GetNode(ctx, start_tx, start_ty);
+
+	start->g_cost = 0;
+	start->h_cost = Path_Estimate(ctx, map, start_tx, start_ty);
+	start->f_cost = start->g_cost + start->h_cost;
+
+	start->opened = true;
+	if (ctx->debug)
+		ctx->debug->open[start_index] = true;
+
+	Path_OpenPush(ctx, start_index);
+
+	ctx->best_cost = INT_MAX;
+	ctx->meet_index = -1;
+
+	if (ctx->algorithm == PATH_ALGORITHM_BIDIRECTIONAL)
+	{
+		int goal_index = Path_Index(ctx, goal_tx, goal_ty);
+		PathNode *goal = Path_GetNode(ctx, goal_tx, goal_ty);
+
+		goal->back_g_cost = 0;
+		goal->back_f_cost = Path_EstimateBack(ctx, map, goal_tx, goal_ty);
+		goal->back_opened = true;
+		if (ctx->debug)
+			ctx->debug->open[goal_index] = true;
+
+		Path_HeapPush(ctx, PATH_SIDE_BACKWARD, goal_index);
+
+		if (at_goal)
+		{
+			ctx->best_cost = 0;
+			ctx->meet_index = start_index;
+		}
+	}
+
+	// special case: already at goal
+	if (at_goal)
+		ctx->status = PATH_SEARCH_FOUND;
+	else
+		ctx->status = PATH_SEARCH_RUNNING;
+
+	return ctx->status;
+}
+
+/*
+Lowest f_cost waiting on one side, INT_MAX once that side ran dry.
+*/
+static int Path_HeapTopKey(PathContext *ctx, PathSide side)
+{
+	if (*Path_HeapCount(ctx, side) == 0)
+		return INT_MAX;
+
+	return Path_HeapKey(ctx->nodes, side, Path_HeapItems(ctx, side)[0]);
+}
+
+/*
+Bidirectional A*: one search from the start toward the goal, one from
+the goal toward the start, over the same nodes.
+
+Every relaxation of a node the other side has already reached is a
+complete route; the cheapest one so far is kept in best_cost. Each
+side's lowest f_cost is a lower bound on any route still undiscovered
+through its frontier, so once best_cost is no greater than the larger
+of the two no cheaper route can exist and the search stops. Meeting
+alone is not enough: the first route found is not always the shortest.
+
+Each step expands the side with fewer open nodes, which keeps the
+two frontiers about the same size.
+*/
+static PathSearchStatus Path_StepBidirectional(PathContext *ctx, const Map *map, int max_expansions)
+{
+	PathDebug *debug = ctx->debug;
+	PathNode *nodes = ctx->nodes;
+
+	int start_index = Path_Index(ctx, ctx->start_tx, ctx->start_ty);
+	int neighbour_count = Path_NeighbourCount(ctx);
+
+	for (int step = 0; step < max_expansions && ctx->status == PATH_SEARCH_RUNNING; ++step)
+	{
+		int forward_bound = Path_HeapTopKey(ctx, PATH_SIDE_FORWARD);
+		int backward_bound = Path_HeapTopKey(ctx, PATH_SIDE_BACKWARD);
+		int bound = forward_bound > backward_bound ? forward_bound : backward_bound;
+
+		// Nothing left on either frontier can beat the best route
+		if (ctx->best_cost <= bound || bound == INT_MAX)
+		{
+			ctx->status = ctx->meet_index != -1 ? PATH_SEARCH_FOUND : PATH_SEARCH_FAILED;
+			break;
+		}
+
+		PathSide side = ctx->open_count <= ctx->back_open_count
+			? PATH_SIDE_FORWARD
+			: PATH_SIDE_BACKWARD;
+		bool forward = side == PATH_SIDE_FORWARD;
+
+		int current_index = Path_HeapPop(ctx, side);
+		PathNode *current = &nodes[current_index];
+
+		ctx->expansions++;
+
+		if (forward)
+		{
+			current->opened = false;
+			current->closed = true;
+		}
+		else
+		{
+			current->back_opened = false;
+			current->back_closed = true;
+		}
+
+		if (debug)
+			debug->closed[current_index] = true;
+
+		int current_g = forward ? current->g_cost : current->back_g_cost;
+
+		for (int i = 0; i < neighbour_count; ++i)
+		{
+			int dx = PATH_OFFSETS[i][0];
+			int dy = PATH_OFFSETS[i][1];
+			int nx = current->tx + dx;
+			int ny = current->ty + dy;
+
+			if (!Map_IsInside(map, nx, ny))
+				continue;
+
+			int neighbour_index = Path_Index(ctx, nx, ny);
+
+			// The backward search may end on the start, which the unit occupies
+			if (!Path_IsPassable(map, nx, ny) && (forward || neighbour_index != start_index))
+				continue;
+
+			// Corner rules look at the same two tiles in either direction
+			if (!Path_CanStep(ctx, map, current->tx, current->ty, dx, dy))
+				continue;
+
+			PathNode *neighbour = Path_GetNode(ctx, nx, ny);
+
+			// Forward moves enter the neighbour, backward ones leave it
+			int tentative_g = forward
+				? current_g + Path_StepCost(ctx, map, nx, ny, dx, dy)
+				: current_g + Path_StepCost(ctx, map, current->tx, current->ty, dx, dy);
+
+			if (forward)
+			{
+				if (neighbour->closed)
+					continue;
+
+				if (neighbour->opened && tentative_g >= neighbour->g_cost)
+					continue;
+
+				bool was_open = neighbour->opened;
+
+				neighbour->g_cost = tentative_g;
+				neighbour->h_cost = Path_Estimate(ctx, map, nx, ny);
+				neighbour->f_cost = neighbour->g_cost + neighbour->h_cost;
+				neighbour->parent_index = current_index;
+				neighbour->opened = true;
+
+				if (was_open)
+					Path_HeapDecreaseKey(ctx, side, neighbour_index);
+				else
+					Path_HeapPush(ctx, side, neighbour_index);
+			}
+			else
+			{
+				if (neighbour->back_closed)
+					continue;
+
+				if (neighbour->back_opened && tentative_g >= neighbour->back_g_cost)
+					continue;
+
+				bool was_open = neighbour->back_opened;
+
+				neighbour->back_g_cost = tentative_g;
+				neighbour->back_f_cost = tentative_g + Path_EstimateBack(ctx, map, nx, ny);
+				neighbour->back_next_index = current_index;
+				neighbour->back_opened = true;
+
+				if (was_open)
+					Path_HeapDecreaseKey(ctx, side, neighbour_index);
+				else
+					Path_HeapPush(ctx, side, neighbour_index);
+			}
+
+			if (debug)
+				debug->open[neighbour_index] = true;
+
+			// Reached from both ends: a complete route through this node
+			bool reached_forward = neighbour->opened || neighbour->closed;
+			bool reached_backward = neighbour->back_opened || neighbour->back_closed;
+
+			if (reached_forward && reached_backward)
+			{
+				int cost = neighbour->g_cost + neighbour->back_g_cost;
+
+				if (cost < ctx->best_cost)
+				{
+					ctx->best_cost = cost;
+					ctx->meet_index = neighbour_index;
+				}
+			}
+		}
+	}
+
+	return ctx->status;
+}
+
+/*
+Expands at most max_expansions nodes. Stepping a slice costs the same
+as the equivalent stretch of an uninterrupted search, and the result
+is identical however the work is split.
+*/
+static PathSearchStatus Path_Step(PathContext *ctx, const Map *map, int max_expansions)
+{
+	if (ctx->algorithm == PATH_ALGORITHM_BIDIRECTIONAL)
+		return Path_StepBidirectional(ctx, map, max_expansions);
+
+	PathDebug *debug = ctx->debug;
+	PathNode *nodes = ctx->nodes;
+
+	int goal_tx = ctx->goal_tx;
+	int goal_ty = ctx->goal_ty;
+
+	// --- A* Main Loop ---
+	for (int step = 0; step < max_expansions && ctx->status == PATH_SEARCH_RUNNING; ++step)
+	{
+		int current_index = Path_OpenPop(ctx);
+
+		// no open nodes left - no path
+		if (current_index == -1)
+		{
+			ctx->status = PATH_SEARCH_FAILED;
+			break;
+		}
+
+		PathNode *current = &nodes[current_index];
+
+		// if goal reached - stop search
+		if (current->tx == goal_tx && current->ty == goal_ty)
+		{
+			ctx->status = PATH_SEARCH_FOUND;
+			break;
+		}
+
+		ctx->expansions++;
+
+		current->opened = false;
+		current->closed = true;
+		if (debug)
+			debug->closed[current_index] = true;
+
+		PathSuccessor successors[8];
+		int successor_count = Path_CollectSuccessors(
+			ctx, map, current, ctx->algorithm, goal_tx, goal_ty, successors);
+
+		for (int i = 0; i < successor_count; ++i)
+		{
+			int nx = successors[i].tx;
+			int ny = successors[i].ty;
+
+			int neigbhour_index = Path_Index(ctx, nx, ny);
+			PathNode *neighbour = Path_GetNode(ctx, nx, ny);
+
+			if (neighbour->closed)
+				continue;
+
+			int tentative_g = current->g_cost + successors[i].cost;
+
+			if (!neighbour->opened || tentative_g < neighbour->g_cost)
+			{
+				bool was_open = neighbour->opened;
+				int old_f_cost = neighbour->f_cost;
+
+				neighbour->g_cost = tentative_g;
+				neighbour->h_cost = Path_Estimate(ctx, map, nx, ny);
+				neighbour->f_cost = neighbour->g_cost + neighbour->h_cost;
+
+				neighbour->parent_index = current_index;
+				neighbour->opened = true;
+
+				if (debug)
+					debug->open[neigbhour_index] = true;
+
+				if (was_open)
+					Path_OpenDecreaseKey(ctx, neigbhour_index, old_f_cost);
+				else
+					Path_OpenPush(ctx, neigbhour_index);
+			}
+		}
+	}
+
+	return ctx->status;
+}
+
+/*
+Joins the two halves of a bidirectional search at the meeting node:
+forward parents lead back to the start, backward links on to the goal.
+Writes tile indices to route and returns how many.
+*/
+static int Path_Stitch(PathContext *ctx, int *route)
+{
+	PathNode *nodes = ctx->nodes;
+
+	int meet_index = ctx->meet_index;
+
+	// Step costs may differ, so count the tiles on each half
+	int forward_length = 0;
+
+	for (int i = meet_index; i != -1; i = nodes[i].parent_index)
+		forward_length++;
+
+	// meet -> parent -> ... -> start, written back to front
+	int write_index = forward_length - 1;
+
+	for (int i = meet_index; i != -1; i = nodes[i].parent_index)
+		route[write_index--] = i;
+
+	// meet -> next -> ... -> goal, written front to back
+	write_index = forward_length;
+
+	for (int i = nodes[meet_index].back_next_index; i != -1; i = nodes[i].back_next_index)
+		route[write_index++] = i;
+
+	return write_index;
+}
+
+/*
+Writes the tile indices of a FOUND search to route, start first, and
+returns how many. A shortest route never visits a tile twice, so it
+always fits in node_count entries.
+*/
+static int Path_Reconstruct(PathContext *ctx, int *route)
+{
+	PathNode *nodes = ctx->nodes;
+
+	if (ctx->algorithm == PATH_ALGORITHM_BIDIRECTIONAL)
+		return Path_Stitch(ctx, route);
+
+	// Goal node index
+	int goal_index = Path_Index(ctx, ctx->goal_tx, ctx->goal_ty);
+
+	// JPS steps all cost 1, so the goal's g_cost is the step count;
+	// other searches count the chain, as step costs differ
+	int path_length = nodes[goal_index].g_cost + 1;
+
+	if (ctx->algorithm != PATH_ALGORITHM_JPS)
+	{
+		path_length = 0;
+
+		for (int i = goal_index; i != -1; i = nodes[i].parent_index)
+			path_length++;
+	}
+
+	// Walk backwards from goal to start
+	// goal -> parent -> parent -> ... -> start
+	// Parents may be several tiles away (JPS), so fill the
+	// straight segment in between one tile at a time.
+	int write_index = path_length - 1;
+	int current_index = goal_index;
+
+	while (current_index != -1)
+	{
+		PathNode *node = &nodes[current_index];
+		int parent_index = node->parent_index;
+
+		int tx = node->tx;
+		int ty = node->ty;
+
+		int end_tx = tx;
+		int end_ty = ty;
+
+		if (parent_index != -1)
+		{
+			end_tx = nodes[parent_index].tx;
+			end_ty = nodes[parent_index].ty;
+		}
+
+		int dx = Path_Sign(end_tx - tx);
+		int dy = Path_Sign(end_ty - ty);
+
+		// Emit this node and the tiles leading back to its parent (exclusive)
+		do
+		{
+			route[write_index--] = Path_Index(ctx, tx, ty);
+
+			tx += dx;
+			ty += dy;
+		} while (tx != end_tx || ty != end_ty);
+
+		current_index = parent_index;
+	}
+
+	return path_length;
+}
+
+/*
+True if a unit can walk straight from the centre of tile a to the
+centre of tile b. Walks every tile the segment touches (supercover);
+where it passes exactly through a corner both tiles beside it count.
+Tiles costlier than max_cost block the line.
+*/
+static bool Path_LineOfSight(const Map *map, int ax, int ay, int bx, int by, int max_cost)
+{
+	int nx = abs(bx - ax);
+	int ny = abs(by - ay);
+	int sx = Path_Sign(bx - ax);
+	int sy = Path_Sign(by - ay);
+
+	int tx = ax;
+	int ty = ay;
+
+	for (int ix = 0, iy = 0; ix < nx || iy < ny;)
+	{
+		// Which edge the segment leaves the tile through, compared in
+		// units of half a tile to stay in integers
+		int decision = (1 + 2 * ix) * ny - (1 + 2 * iy) * nx;
+
+		if (decision == 0)
+		{
+			if (!Map_IsWalkable(map, tx + sx, ty) || Map_GetCost(map, tx + sx, ty) > max_cost ||
+				!Map_IsWalkable(map, tx, ty + sy) || Map_GetCost(map, tx, ty + sy) > max_cost)
+				return false;
+
+			tx += sx;
+			ty += sy;
+			ix++;
+			iy++;
+		}
+		else if (decision < 0)
+		{
+			tx += sx;
+			ix++;
+		}
+		else
+		{
+			ty += sy;
+			iy++;
+		}
+
+		if (!Map_IsWalkable(map, tx, ty) || Map_GetCost(map, tx, ty) > max_cost)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+Greedy string pulling over count tile indices: from each waypoint,
+extend the segment along the route while the straight line stays
+open. Writes the waypoints to out_path; false if they do not fit.
+*/
+static bool Path_PullStrings(const Map *map, const int *route, int count, Path *out_path)
+{
+	int length = 0;
+	int anchor = 0;
+
+	out_path->length = 0;
+
+	while (1)
+	{
+		if (length >= MAX_PATH_LENGTH)
+			return false;
+
+		out_path->tiles[length][0] = route[anchor] % map->width;
+		out_path->tiles[length][1] = route[anchor] / map->width;
+		length++;
+
+		if (anchor >= count - 1)
+			break;
+
+		int ax = route[anchor] % map->width;
+		int ay = route[anchor] / map->width;
+
+		int next = anchor + 1;
+		int max_cost = Map_GetCost(map, route[next] % map->width, route[next] / map->width);
+
+		for (int i = next + 1; i < count; ++i)
+		{
+			int tx = route[i] % map->width;
+			int ty = route[i] / map->width;
+			int cost = Map_GetCost(map, tx, ty);
+
+			if (cost > max_cost)
+				max_cost = cost;
+
+			if (!Path_LineOfSight(map, ax, ay, tx, ty, max_cost))
+				break;
+
+			next = i;
+		}
+
+		anchor = next;
+	}
+
+	out_path->length = length;
+
+	return true;
+}
+
+static bool Path_Finish(PathContext *ctx, Path *out_path)
+{
+	PathDebug *debug = ctx->debug;
+	int *route = ctx->route;
+
+	// Reset output path
+	out_path->length = 0;
+
+	if (ctx->status != PATH_SEARCH_FOUND)
+		return false;
+
+	// --- Path Reconstruction ---
+
+	int path_length = Path_Reconstruct(ctx, route);
+
+	if (debug)
+	{
+		for (int i = 0; i < path_length; ++i)
+			debug->in_path[route[i]] = true;
+	}
+
+	if (ctx->smooth)
+		return Path_PullStrings(ctx->map, route, path_length, out_path);
+
+	if (path_length > MAX_PATH_LENGTH)
+		// Path too long for buffer
+		return false;
+
+	for (int i = 0; i < path_length; ++i)
+	{
+		out_path->tiles[i][0] = route[i] % ctx->width;
+		out_path->tiles[i][1] = route[i] / ctx->width;
+	}
+
+	out_path->length = path_length;
+
+	return true;
+}
+
+/*
+The public entry points time the work they do when a stats sink is
+attached; without one the clock is never read.
+*/
+PathSearchStatus Pathfinding_BeginSearch(
+	PathContext *ctx,
+	const Map *map,
+	int start_tx,
+	int start_ty,
+	int goal_tx,
+	int goal_ty,
+	const PathOptions *options
+)
+{
+	long long begin_ns = ctx->stats ? PathStats_NowNs() : 0;
+
+	Path_Begin(ctx, map, start_tx, start_ty, goal_tx, goal_ty, options);
+
+	ctx->elapsed_ns = ctx->stats ? PathStats_NowNs() - begin_ns : 0;
+
+	return ctx->status;
+}
+
+PathSearchStatus Pathfinding_StepSearch(PathContext *ctx, const Map *map, int max_expansions)
+{
+	long long begin_ns = ctx->stats ? PathStats_NowNs() : 0;
+
+	Path_Step(ctx, map, max_expansions);
+
+	if (ctx->stats)
+		ctx->elapsed_ns += PathStats_NowNs() - begin_ns;
+
+	return ctx->status;
+}
+
+bool Pathfinding_FinishSearch(PathContext *ctx, Path *out_path)
+{
+	long long begin_ns = ctx->stats ? PathStats_NowNs() : 0;
+
+	bool found = Path_Finish(ctx, out_path);
+
+	TRACE_EVENT(
+		TRACE_EVENT_PATH_END, found ? TRACE_FLAG_FOUND : 0,
+		ctx->status, ctx->expansions, out_path->length, ctx->algorithm);
+
+	if (ctx->stats)
+	{
+		ctx->elapsed_ns += PathStats_NowNs() - begin_ns;
+
+		PathSearchReport report = {
+			.found = found,
+			.expansions = ctx->expansions,
+			.opened = ctx->opened,
+			.peak_open = ctx->peak_open,
+			.length = out_path->length,
+			.elapsed_ns = ctx->elapsed_ns
+		};
+
+		PathStats_Record(ctx->stats, &report);
+	}
+
+	return found;
+}
+
+/*
+Finds a path between start and goal tile coordinates.
+
+Returns:
+    true  -> path found, out_path is filled
+    false -> no path possible
+
+Rules:
+- Does not allocate memory
+- Does not modify Map
+- Deterministic behavior
+- Only touches nodes the search actually reaches
+*/
+bool Pathfinding_FindPath(
+	PathContext *ctx,
+	const Map *map,
+	int start_tx,
+	int start_ty,
+	int goal_tx,
+	int goal_ty,
+	const PathOptions *options,
+	Path *out_path
+)
+{
+	Pathfinding_BeginSearch(ctx, map, start_tx, start_ty, goal_tx, goal_ty, options);
+	Pathfinding_StepSearch(ctx, map, INT_MAX);
+
+	return Pathfinding_FinishSearch(ctx, out_path);
+}
+
+void Pathfinding_SmoothPath(const Map *map, Path *path)
+{
+	int route[MAX_PATH_LENGTH];
+
+	for (int i = 0; i < path->length; ++i)
+		route[i] = Map_Index(map, path->tiles[i][0], path->tiles[i][1]);
+
+	// Never more waypoints than tiles, so the result always fits
+	if (path->length > 0)
+		Path_PullStrings(map, route, path->length, path);
+}
@@ -5,12 +5,14 @@
 #include "map.h"
 #include "../game/constants.h"
 
-#define MAP_NODE_COUNT (MAP_WIDTH * MAP_HEIGHT)
-
 /*
 Path represents a sequence of tile coordinates from the start to goal.
 The caller own the memory.
-No dynamic allocation occurs inside pathfinding.
+No dynamic allocation occurs inside a search.
+
+Searches list every tile visited unless asked to smooth, in which
+case only the waypoints where the route turns are kept and each
+straight segment between them is known to be walkable.
 */
 typedef struct
 {
@@ -18,20 +20,273 @@ typedef struct
 	int tiles[MAX_PATH_LENGTH][2];
 
 	int length;
-
-	// Debug visualization data
-	bool debug_open[MAP_NODE_COUNT];
-	bool debug_closed[MAP_NODE_COUNT];
-	bool debug_in_path[MAP_NODE_COUNT];
 } Path;
 
+/*
+Optional search trace for the debug overlay.
+
+Kept out of Path so regular queries only produce the tile list.
+The search writes here only when PathOptions::debug is non-NULL,
+and ignores a trace with fewer entries than the map has tiles.
+Entries are indexed like the map's tiles (Map_Index).
+*/
+typedef struct
+{
+	bool *open;
+	bool *closed;
+	bool *in_path;
+	int node_count;
+} PathDebug;
+
+// Allocates a cleared trace of node_count entries. Returns false on allocation failure.
+bool PathDebug_Init(PathDebug *debug, int node_count);
+void PathDebug_Free(PathDebug *debug);
+void PathDebug_Clear(PathDebug *debug);
+
+/*
+Open set implementation used by the search.
+
+The heap and the linear scan produce identical paths: ties on f_cost
+are always broken by the lower node index, so replays stay stable
+whichever is used. The linear scan is kept as a reference for tests
+and benchmarks.
+
+The bucket queue relies on small integer step costs and returns paths
+of the same cost, but breaks ties differently, so their shape may differ.
+Searches whose steps can cost more than one tile (JPS) ignore it.
+*/
+typedef enum
+{
+	PATH_OPEN_SET_BINARY_HEAP = 0,  // O(log n) push/pop/decrease-key
+	PATH_OPEN_SET_LINEAR_SCAN,      // O(n) scan of the whole grid per expansion
+	PATH_OPEN_SET_BUCKET_QUEUE      // O(1) push/pop/decrease-key, one bucket per f_cost
+} PathOpenSet;
+
+// Buckets of the bucket queue; must exceed the largest f_cost spread
+#define PATH_BUCKET_COUNT 256
+
+/*
+Search algorithm.
+
+All return shortest paths in the same Path format. JPS prunes
+symmetric routes on uniform-cost 4-connected grids, so it opens far
+fewer nodes on large open maps; equal-cost paths may differ in shape.
+
+Bidirectional runs A* from both ends and stitches the two halves
+where they meet, which pays off when the goal sits in a pocket the
+forward search would only find after flooding the start's side.
+Both JPS and bidirectional search always use the binary heap,
+whatever the open set option says.
+*/
+typedef enum
+{
+	PATH_ALGORITHM_ASTAR = 0,
+	PATH_ALGORITHM_JPS,
+	PATH_ALGORITHM_BIDIRECTIONAL
+} PathAlgorithm;
+
+/*
+Distance estimate guiding the search.
+
+Landmarks (ALT) take the best triangle-inequality bound from the
+map's landmark tables, falling back to Manhattan where no table is
+usable. Both are admissible, so path lengths are the same; landmarks
+expand far fewer nodes on maps with long detours.
+*/
+typedef enum
+{
+	PATH_HEURISTIC_MANHATTAN = 0,
+	PATH_HEURISTIC_LANDMARKS
+} PathHeuristic;
+
+/*
+Moves a unit may make from one tile.
+
+Four-connected searches cost 1 per step. Eight-connected searches add
+diagonal steps and cost PATH_COST_STRAIGHT / PATH_COST_DIAGONAL, an
+integer approximation of 1 and sqrt(2). Either way Path lists every
+tile visited, so consecutive tiles are always adjacent.
+
+Every step is also scaled by the cost of the tile it enters
+(Map_GetCost), so routes avoid swamps when a road is cheaper.
+
+Only A* and bidirectional search move diagonally; JPS falls back to
+A* when asked for eight directions or when tile costs are not uniform.
+*/
+typedef enum
+{
+	PATH_CONNECTIVITY_4 = 0,
+	PATH_CONNECTIVITY_8
+} PathConnectivity;
+
+#define PATH_COST_STRAIGHT 10
+#define PATH_COST_DIAGONAL 14
+
+/*
+Per-query search options.
+A zero-initialized struct selects the defaults.
+*/
+typedef struct
+{
+	PathOpenSet open_set;
+	PathAlgorithm algorithm;
+	PathHeuristic heuristic;
+	PathConnectivity connectivity;
+
+	// Diagonal steps may pass one blocked or occupied orthogonal
+	// neighbour. Off by default: both must be free. Never allows
+	// squeezing between two blocked tiles.
+	bool corner_cutting;
+
+	// Reduce the result to waypoints (Pathfinding_SmoothPath). The
+	// route is smoothed before it is cut to MAX_PATH_LENGTH, so routes
+	// longer than that in tiles still fit as long as their waypoints do.
+	bool smooth;
+
+	// Optional trace sink, cleared and filled by the search when set
+	PathDebug *debug;
+} PathOptions;
+
+// State of a search started with Pathfinding_BeginSearch
+typedef enum
+{
+	PATH_SEARCH_RUNNING = 0,
+	PATH_SEARCH_FOUND,
+	PATH_SEARCH_FAILED
+} PathSearchStatus;
+
+// Internal search node, defined in pathfinding.c
+typedef struct PathNode PathNode;
+
+// Search counters and latency histogram, defined in pathstats.h
+typedef struct PathStats PathStats;
+
+/*
+Persistent search scratch space.
+
+Owns one node per tile plus the open-set heaps, so searches do not
+need a large stack frame. A context serves any map with at most
+node_count tiles; searches on larger maps fail at Begin. Nodes are stamped with a search generation
+and lazily reset on first touch: a short query only pays for the
+nodes it explores, not for the whole map.
+
+A context serves one search at a time. The search in progress keeps
+its whole state here, so it can be advanced across several calls.
+*/
+typedef struct
+{
+	PathNode *nodes;
+	int *open_heap;
+	int open_count;
+	int node_count;
+
+	// Width of the map the search in progress runs on, for indexing
+	int width;
+
+	// Backward open set of the bidirectional search; it shares the nodes
+	int *back_heap;
+	int back_open_count;
+
+	// Bucket queue heads, PATH_BUCKET_COUNT of them, and the lowest
+	// f_cost that may still be queued
+	int *buckets;
+	int bucket_cursor;
+	unsigned int generation;
+
+	// Search in progress
+	int start_tx;
+	int start_ty;
+	int goal_tx;
+	int goal_ty;
+	PathOpenSet open_set;
+	PathAlgorithm algorithm;
+	PathHeuristic heuristic;
+	PathConnectivity connectivity;
+	bool corner_cutting;
+	bool smooth;
+	PathDebug *debug;
+	PathSearchStatus status;
+
+	// Map the search runs on, for smoothing the result
+	const Map *map;
+
+	// Tiles of the route being written out, start first; node_count of them
+	int *route;
+
+	// Goal distance per landmark, -1 where the table is not used
+	int landmark_goal[MAP_LANDMARK_COUNT];
+
+	// Bidirectional only: start distance per landmark, and the cheapest
+	// start-goal route seen so far through the node where it meets
+	int landmark_start[MAP_LANDMARK_COUNT];
+	int best_cost;
+	int meet_index;
+
+	// Nodes expanded by the search in progress
+	int expansions;
+
+	// Nodes pushed onto either open set, and the most open at once
+	int opened;
+	int peak_open;
+
+	// Time spent inside Begin, Step and Finish for this search; only
+	// measured while stats is set, so ticks spent waiting do not count
+	long long elapsed_ns;
+
+	// Optional sink every finished search is recorded into, NULL for
+	// none; not shared between contexts used from different threads
+	PathStats *stats;
+} PathContext;
+
+// Allocates storage for node_count nodes. Returns false on allocation failure.
+bool PathContext_Init(PathContext *ctx, int node_count);
+void PathContext_Free(PathContext *ctx);
+
+/*
+Resumable search, for callers that spread one query over several ticks:
+Begin once, Step until the status is no longer RUNNING, then Finish.
+The map must not change walkability between steps; restart if it does.
+Pathfinding_FindPath is the same sequence without a step limit.
+*/
+PathSearchStatus Pathfinding_BeginSearch(
+	PathContext *ctx,
+	const Map *map,
+	int start_tx,
+	int start_ty,
+	int goal_tx,
+	int goal_ty,
+	const PathOptions *options
+);
+
+// Expands at most max_expansions nodes (ctx->expansions counts them)
+PathSearchStatus Pathfinding_StepSearch(PathContext *ctx, const Map *map, int max_expansions);
+
+// Writes the path of a FOUND search. Returns false otherwise,
+// or if the path does not fit in MAX_PATH_LENGTH entries.
+// The search is recorded into ctx->stats if one is set.
+bool Pathfinding_FinishSearch(PathContext *ctx, Path *out_path);
+
+// options may be NULL to use the defaults
 bool Pathfinding_FindPath(
+	PathContext *ctx,
 	const Map *map,
 	int start_tx,
 	int start_ty,
 	int goal_tx,
 	int goal_ty,
+	const PathOptions *options,
 	Path *out_path
 );
 
+/*
+String pulling: drops every tile a unit can skip by walking in a
+straight line from the last kept waypoint, in place.
+
+A segment is kept straight only if every tile its line touches is
+walkable and no costlier than the tiles it replaces; a line through
+a tile corner needs both tiles beside the corner. Occupancy is not
+checked, as units move on by the time the segment is walked.
+*/
+void Pathfinding_SmoothPath(const Map *map, Path *path);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "pathpool.h"
+
+#include <stdlib.h>
+
+/*
+    Path worker pool module.
+
+    It owns:
+    - Worker threads and their search contexts
+    - Handing out queries of the current batch
+
+    It does NOT:
+    - Modify Map
+    - Decide which queries to batch
+*/
+
+// Takes queries until the batch is exhausted
+static void PathWorker_Drain(PathWorker *worker)
+{
+    PathWorkerPool *pool = worker->pool;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&pool->mutex);
+        int index = pool->next_request++;
+        pthread_mutex_unlock(&pool->mutex);
+
+        if (index >= pool->request_count)
+            break;
+
+        const PathRequest *request = &pool->requests[index];
+        PathResult *result = &pool->results[index];
+
+        result->found = Pathfinding_FindPath(
+            &worker->context,
+            pool->map,
+            request->start_tx,
+            request->start_ty,
+            request->goal_tx,
+            request->goal_ty,
+            &request->options,
+            &result->path
+        );
+    }
+}
+
+static void *PathWorker_Run(void *arg)
+{
+    PathWorker *worker = arg;
+    PathWorkerPool *pool = worker->pool;
+    unsigned int seen_batch = 0;
+
+    pthread_mutex_lock(&pool->mutex);
+
+    for (;;)
+    {
+        while (!pool->shutting_down && pool->batch_id == seen_batch)
+            pthread_cond_wait(&pool->batch_ready, &pool->mutex);
+
+        if (pool->shutting_down)
+            break;
+
+        seen_batch = pool->batch_id;
+        pthread_mutex_unlock(&pool->mutex);
+
+        PathWorker_Drain(worker);
+
+        pthread_mutex_lock(&pool->mutex);
+
+        if (--pool->busy_workers == 0)
+            pthread_cond_signal(&pool->batch_done);
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+bool PathWorkerPool_Init(PathWorkerPool *pool, int worker_count, int node_count)
+{
+    *pool = (PathWorkerPool){0};
+
+    if (worker_count < 1)
+        worker_count = 1;
+
+    pool->workers = calloc((size_t)worker_count, sizeof(PathWorker));
+
+    if (pool->workers == NULL)
+        return false;
+
+    pool->worker_count = worker_count;
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->batch_ready, NULL);
+    pthread_cond_init(&pool->batch_done, NULL);
+
+    for (int i = 0; i < worker_count; ++i)
+    {
+        pool->workers[i].pool = pool;
+
+        if (!PathContext_Init(&pool->workers[i].context, node_count))
+        {
+            PathWorkerPool_Free(pool);
+            return false;
+        }
+    }
+
+    // Worker 0 runs on the calling thread
+    for (int i = 1; i < worker_count; ++i)
+    {
+        if (pthread_create(&pool->workers[i].thread, NULL, PathWorker_Run, &pool->workers[i]) != 0)
+        {
+            PathWorkerPool_Free(pool);
+            return false;
+        }
+
+        pool->threads_started++;
+    }
+
+    return true;
+}
+
+void PathWorkerPool_Free(PathWorkerPool *pool)
+{
+    if (pool->workers == NULL)
+        return;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->shutting_down = true;
+    pthread_cond_broadcast(&pool->batch_ready);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 1; i <= pool->threads_started; ++i)
+        pthread_join(pool->workers[i].thread, NULL);
+
+    for (int i = 0; i < pool->worker_count; ++i)
+        PathContext_Free(&pool->workers[i].context);
+
+    pthread_cond_destroy(&pool->batch_done);
+    pthread_cond_destroy(&pool->batch_ready);
+    pthread_mutex_destroy(&pool->mutex);
+
+    free(pool->workers);
+    pool->workers = NULL;
+    pool->worker_count = 0;
+    pool->threads_started = 0;
+}
+
+void Pathfinding_FindPaths(
+    PathWorkerPool *pool,
+    const Map *map,
+    const PathRequest *requests,
+    int request_count,
+    PathResult *results
+)
+{
+    pthread_mutex_lock(&pool->mutex);
+
+    pool->map = map;
+    pool->requests = requests;
+    pool->results = results;
+    pool->request_count = request_count;
+    pool->next_request = 0;
+    pool->busy_workers = pool->threads_started;
+    pool->batch_id++;
+
+    pthread_cond_broadcast(&pool->batch_ready);
+    pthread_mutex_unlock(&pool->mutex);
+
+    PathWorker_Drain(&pool->workers[0]);
+
+    pthread_mutex_lock(&pool->mutex);
+
+    while (pool->busy_workers > 0)
+        pthread_cond_wait(&pool->batch_done, &pool->mutex);
+
+    pthread_mutex_unlock(&pool->mutex);
+}
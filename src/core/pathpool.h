@@ -0,0 +1,91 @@
+#ifndef PATHPOOL_H
+#define PATHPOOL_H
+
+#include <stdbool.h>
+#include <pthread.h>
+#include "map.h"
+#include "pathfinding.h"
+
+/*
+Batched path queries spread over a pool of worker threads.
+
+Each worker owns a PathContext, so searches share nothing but the
+read-only Map. Every query is a plain Pathfinding_FindPath call on a
+context whose earlier searches cannot leak into it, so results are
+identical to running the batch serially, whatever the thread count
+or the order in which workers pick queries up.
+
+The map must not be modified while a batch runs.
+*/
+
+typedef struct
+{
+    int start_tx;
+    int start_ty;
+    int goal_tx;
+    int goal_ty;
+
+    // Same meaning as for Pathfinding_FindPath.
+    // A debug sink, if set, must not be shared with another request.
+    PathOptions options;
+} PathRequest;
+
+typedef struct
+{
+    bool found;
+    Path path;
+} PathResult;
+
+typedef struct PathWorkerPool PathWorkerPool;
+
+typedef struct
+{
+    PathWorkerPool *pool;
+    PathContext context;
+    pthread_t thread;
+} PathWorker;
+
+/*
+Worker 0 is the thread calling Pathfinding_FindPaths;
+the other workers are threads parked between batches.
+*/
+struct PathWorkerPool
+{
+    PathWorker *workers;
+    int worker_count;
+    int threads_started;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t batch_ready;
+    pthread_cond_t batch_done;
+
+    // Current batch, guarded by mutex
+    const Map *map;
+    const PathRequest *requests;
+    PathResult *results;
+    int request_count;
+    int next_request;
+    int busy_workers;
+    unsigned int batch_id;
+    bool shutting_down;
+};
+
+// Starts worker_count - 1 threads (worker_count >= 1), each with search
+// scratch for maps of up to node_count tiles.
+// Returns false on allocation or thread creation failure.
+bool PathWorkerPool_Init(PathWorkerPool *pool, int worker_count, int node_count);
+void PathWorkerPool_Free(PathWorkerPool *pool);
+
+/*
+Runs every request and writes results[i] for requests[i].
+Blocks until the whole batch is done.
+*/
+void Pathfinding_FindPaths(
+    PathWorkerPool *pool,
+    const Map *map,
+    const PathRequest *requests,
+    int request_count,
+    PathResult *results
+);
+
+#endif
@@ -0,0 +1,270 @@
+#include "pathsched.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+
+/*
+    Path scheduler module.
+
+    It owns:
+    - The queue of pending move orders
+    - Spreading their searches over ticks
+
+    It does NOT:
+    - Move units
+    - Modify Map
+*/
+
+void PathScheduler_Init(PathScheduler *scheduler, PathContext *ctx, PathCache *cache, int budget)
+{
+    scheduler->head = 0;
+    scheduler->count = 0;
+    scheduler->ctx = ctx;
+    scheduler->cache = cache;
+    scheduler->budget = budget;
+    scheduler->heuristic = PATH_HEURISTIC_MANHATTAN;
+    scheduler->connectivity = PATH_CONNECTIVITY_4;
+    scheduler->corner_cutting = false;
+    scheduler->smooth = false;
+    scheduler->clusters = NULL;
+    scheduler->cluster_distance = PATH_SCHEDULER_CLUSTER_DISTANCE;
+    scheduler->searching = false;
+    scheduler->map_revision = 0;
+}
+
+static PathSchedulerRequest *PathScheduler_At(PathScheduler *scheduler, int offset)
+{
+    return &scheduler->requests[(scheduler->head + offset) % PATH_SCHEDULER_CAPACITY];
+}
+
+// Whether the unit's route is delivered as waypoints
+static bool PathScheduler_Smooths(const PathScheduler *scheduler, const Unit *unit)
+{
+    return scheduler->smooth && unit->replanner == NULL;
+}
+
+// Options every search for the unit runs with; also the cache key
+static PathOptions PathScheduler_Options(const PathScheduler *scheduler, const Unit *unit, PathDebug *debug)
+{
+    PathOptions options = {
+        .heuristic = scheduler->heuristic,
+        .connectivity = scheduler->connectivity,
+        .corner_cutting = scheduler->corner_cutting,
+        .smooth = PathScheduler_Smooths(scheduler, unit),
+        .debug = debug
+    };
+
+    return options;
+}
+
+static void PathScheduler_PopHead(PathScheduler *scheduler)
+{
+    scheduler->head = (scheduler->head + 1) % PATH_SCHEDULER_CAPACITY;
+    scheduler->count--;
+    scheduler->searching = false;
+}
+
+// Queues a search from the unit's tile, answering from the cache when it can
+static bool PathScheduler_Enqueue(
+    PathScheduler *scheduler,
+    const Map *map,
+    Unit *unit,
+    int goal_tx,
+    int goal_ty,
+    PathDebug *debug
+)
+{
+    // A repeated order needs no search at all; traced orders always search
+    if (scheduler->cache && debug == NULL && !PathScheduler_Smooths(scheduler, unit))
+    {
+        Path path;
+        PathOptions options = PathScheduler_Options(scheduler, unit, NULL);
+
+        if (PathCache_Get(scheduler->cache, map, unit->tx, unit->ty, goal_tx, goal_ty, &options, &path))
+        {
+            Unit_SetPath(unit, &path);
+            return true;
+        }
+    }
+
+    if (scheduler->count >= PATH_SCHEDULER_CAPACITY)
+        return false;
+
+    PathSchedulerRequest *request = PathScheduler_At(scheduler, scheduler->count);
+
+    request->unit = unit;
+    request->goal_tx = goal_tx;
+    request->goal_ty = goal_ty;
+    request->debug = debug;
+
+    scheduler->count++;
+    unit->path_pending = true;
+
+    return true;
+}
+
+// Whether the order is long enough to go through the cluster graph;
+// traced orders search the whole route so the trace shows all of it
+static bool PathScheduler_UsesClusters(
+    const PathScheduler *scheduler,
+    const Unit *unit,
+    int goal_tx,
+    int goal_ty,
+    const PathDebug *debug
+)
+{
+    if (scheduler->clusters == NULL || unit->abstract_path == NULL || debug != NULL)
+        return false;
+
+    int distance = abs(goal_tx - unit->tx) + abs(goal_ty - unit->ty);
+
+    return distance >= scheduler->cluster_distance;
+}
+
+bool PathScheduler_Submit(
+    PathScheduler *scheduler,
+    const Map *map,
+    Unit *unit,
+    int goal_tx,
+    int goal_ty,
+    PathDebug *debug
+)
+{
+    PathScheduler_Cancel(scheduler, unit);
+    unit->abstract_segment = -1;
+
+    // Search only as far as the first sector waypoint; no abstract
+    // route falls back to the plain search, which reports the failure
+    if (PathScheduler_UsesClusters(scheduler, unit, goal_tx, goal_ty, debug) &&
+        ClusterGraph_FindPath(scheduler->clusters, map, unit->tx, unit->ty, goal_tx, goal_ty, unit->abstract_path) &&
+        unit->abstract_path->count > 2)
+    {
+        unit->abstract_segment = 0;
+        goal_tx = unit->abstract_path->waypoints[1][0];
+        goal_ty = unit->abstract_path->waypoints[1][1];
+    }
+
+    return PathScheduler_Enqueue(scheduler, map, unit, goal_tx, goal_ty, debug);
+}
+
+void PathScheduler_Continue(PathScheduler *scheduler, const Map *map, Unit *unit)
+{
+    if (unit->abstract_segment < 0)
+        return;
+
+    // Still searching or walking the current segment
+    if (unit->path_pending || unit->moving || Unit_HasQueuedMove(unit))
+        return;
+
+    const ClusterPath *abstract_path = unit->abstract_path;
+    int next = unit->abstract_segment + 1;
+
+    if (next + 1 >= abstract_path->count)
+    {
+        unit->abstract_segment = -1;
+        return;
+    }
+
+    // A segment that failed to resolve leaves the unit short of its
+    // waypoint; the next search starts from wherever it stopped
+    if (PathScheduler_Enqueue(
+            scheduler, map, unit,
+            abstract_path->waypoints[next + 1][0],
+            abstract_path->waypoints[next + 1][1],
+            NULL))
+    {
+        unit->abstract_segment = next;
+    }
+}
+
+void PathScheduler_Cancel(PathScheduler *scheduler, Unit *unit)
+{
+    unit->path_pending = false;
+
+    for (int i = 0; i < scheduler->count; ++i)
+    {
+        if (PathScheduler_At(scheduler, i)->unit != unit)
+            continue;
+
+        // Abandon the running search along with its request
+        if (i == 0)
+        {
+            PathScheduler_PopHead(scheduler);
+            return;
+        }
+
+        // Close the gap, keeping submission order
+        for (int j = i; j < scheduler->count - 1; ++j)
+            *PathScheduler_At(scheduler, j) = *PathScheduler_At(scheduler, j + 1);
+
+        scheduler->count--;
+        return;
+    }
+}
+
+static void PathScheduler_Complete(PathScheduler *scheduler, const Map *map, PathSchedulerRequest *request)
+{
+    PathContext *ctx = scheduler->ctx;
+    Unit *unit = request->unit;
+    Path path;
+
+    if (Pathfinding_FinishSearch(ctx, &path))
+    {
+        Unit_SetPath(unit, &path);
+
+        if (scheduler->cache && request->debug == NULL && !ctx->smooth)
+        {
+            PathOptions options = PathScheduler_Options(scheduler, unit, NULL);
+
+            PathCache_Put(
+                scheduler->cache, map, ctx->start_tx, ctx->start_ty, ctx->goal_tx, ctx->goal_ty,
+                &options, &path);
+        }
+    }
+
+    unit->path_pending = false;
+    PathScheduler_PopHead(scheduler);
+}
+
+void PathScheduler_Update(PathScheduler *scheduler, const Map *map)
+{
+    PathContext *ctx = scheduler->ctx;
+    int budget = scheduler->budget;
+
+    while (scheduler->count > 0)
+    {
+        PathSchedulerRequest *request = PathScheduler_At(scheduler, 0);
+        unsigned int revision = Map_GetWalkabilityRevision(map);
+
+        // Node state from before a walkability edit cannot be trusted; start over
+        if (!scheduler->searching || scheduler->map_revision != revision)
+        {
+            PathOptions options = PathScheduler_Options(scheduler, request->unit, request->debug);
+
+            Pathfinding_BeginSearch(
+                ctx, map,
+                request->unit->tx, request->unit->ty,
+                request->goal_tx, request->goal_ty,
+                &options);
+
+            scheduler->searching = true;
+            scheduler->map_revision = revision;
+        }
+
+        if (ctx->status == PATH_SEARCH_RUNNING)
+        {
+            if (budget <= 0)
+                break;
+
+            int expanded_before = ctx->expansions;
+            Pathfinding_StepSearch(ctx, map, budget);
+            budget -= ctx->expansions - expanded_before;
+
+            // Out of budget: resume from here next tick
+            if (ctx->status == PATH_SEARCH_RUNNING)
+                break;
+        }
+
+        PathScheduler_Complete(scheduler, map, request);
+    }
+}
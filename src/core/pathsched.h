@@ -0,0 +1,122 @@
+#ifndef PATHSCHED_H
+#define PATHSCHED_H
+
+#include <stdbool.h>
+#include "map.h"
+#include "unit.h"
+#include "pathfinding.h"
+#include "pathcache.h"
+#include "cluster.h"
+
+/*
+Time-sliced path request scheduler.
+
+Move orders are queued instead of searched on the spot. Every tick
+the scheduler advances the search at the head of the queue under a
+budget of node expansions, resuming where the previous tick stopped,
+so a burst of orders is spread over several frames instead of
+spiking one. Units wait with path_pending set until their search
+completes.
+
+The budget counts expansions rather than microseconds so the same
+orders resolve on the same tick on every machine.
+
+With a cluster graph set, a long order first searches the abstract
+graph and then only the segment to the next sector waypoint; each
+further segment is queued by PathScheduler_Continue once the unit
+has walked the previous one. Scheduled searches then stay about a
+sector long however far the goal is.
+*/
+
+// Maximum number of queued move orders
+#define PATH_SCHEDULER_CAPACITY 64
+
+// Node expansions per tick unless configured otherwise
+#define PATH_SCHEDULER_DEFAULT_BUDGET 2000
+
+// Manhattan distance from which orders follow the cluster graph
+#define PATH_SCHEDULER_CLUSTER_DISTANCE (2 * CLUSTER_SIZE)
+
+typedef struct
+{
+    Unit *unit;
+    int goal_tx;
+    int goal_ty;
+
+    // Optional trace sink for this request's search
+    PathDebug *debug;
+} PathSchedulerRequest;
+
+typedef struct
+{
+    // Ring buffer of pending requests; the head is the one being searched
+    PathSchedulerRequest requests[PATH_SCHEDULER_CAPACITY];
+    int head;
+    int count;
+
+    // Borrowed search context and optional cache
+    PathContext *ctx;
+    PathCache *cache;
+
+    // Expansions allowed per PathScheduler_Update call
+    int budget;
+
+    // Heuristic for every scheduled search, Manhattan after Init
+    PathHeuristic heuristic;
+
+    // Movement rules for every scheduled search, 4-connected after Init
+    PathConnectivity connectivity;
+    bool corner_cutting;
+
+    // Deliver waypoints instead of every tile, off after Init. Units
+    // with a replanner still get every tile, as their repairs check
+    // the next tile. Smoothed routes skip the cache, which validates
+    // and invalidates entries by the tiles they list.
+    bool smooth;
+
+    // Optional abstract graph for long orders of units with an
+    // abstract_path, NULL after Init. Not owned by the scheduler.
+    ClusterGraph *clusters;
+
+    // Orders at least this far away go through clusters
+    int cluster_distance;
+
+    // Head request has a search running in ctx
+    bool searching;
+
+    // Walkability revision the running search started from
+    unsigned int map_revision;
+} PathScheduler;
+
+// ctx is used exclusively by the scheduler; cache may be NULL.
+void PathScheduler_Init(PathScheduler *scheduler, PathContext *ctx, PathCache *cache, int budget);
+
+/*
+Queues a path for the unit and marks it pending.
+A unit with a request already queued has it replaced.
+Cache hits complete immediately. Returns false if the queue is full.
+*/
+bool PathScheduler_Submit(
+    PathScheduler *scheduler,
+    const Map *map,
+    Unit *unit,
+    int goal_tx,
+    int goal_ty,
+    PathDebug *debug
+);
+
+/*
+Queues the next segment of the unit's abstract route once the unit
+has walked the previous one; the last segment ends the route. Call
+once per tick per unit, before PathScheduler_Update. A full queue
+leaves the segment for the next call.
+*/
+void PathScheduler_Continue(PathScheduler *scheduler, const Map *map, Unit *unit);
+
+// Drops the unit's request, if any, and clears its pending state.
+void PathScheduler_Cancel(PathScheduler *scheduler, Unit *unit);
+
+// Advances queued searches by up to the budget; call once per tick.
+void PathScheduler_Update(PathScheduler *scheduler, const Map *map);
+
+#endif
@@ -0,0 +1,148 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "pathstats.h"
+
+#include <string.h>
+#include <time.h>
+
+/*
+    Path statistics module.
+
+    It owns:
+    - Counters and the latency histogram of finished searches
+    - The clock searches are timed with
+
+    It does NOT:
+    - Run searches
+    - Draw anything
+*/
+
+_Static_assert((PATH_STATS_SUB_BUCKETS & (PATH_STATS_SUB_BUCKETS - 1)) == 0, "sub-bucket count must be a power of two");
+
+/*
+    Times below PATH_STATS_SUB_BUCKETS get a bucket each. Above, the
+    shift keeps the top bits of the time in [SUB_BUCKETS, 2 * SUB_BUCKETS),
+    which picks the sub-bucket within that power of two.
+*/
+static int PathStats_Bucket(long long ns)
+{
+    if (ns < PATH_STATS_SUB_BUCKETS)
+        return ns < 0 ? 0 : (int)ns;
+
+    int shift = 0;
+
+    while ((ns >> shift) >= 2 * PATH_STATS_SUB_BUCKETS)
+        shift++;
+
+    if (shift >= PATH_STATS_MAGNITUDES)
+        return PATH_STATS_BUCKETS - 1;
+
+    return (shift + 1) * PATH_STATS_SUB_BUCKETS + (int)(ns >> shift) - PATH_STATS_SUB_BUCKETS;
+}
+
+// Highest time that falls into a bucket
+static long long PathStats_BucketHigh(int bucket)
+{
+    if (bucket < PATH_STATS_SUB_BUCKETS)
+        return bucket;
+
+    int shift = bucket / PATH_STATS_SUB_BUCKETS - 1;
+    long long low = (long long)(PATH_STATS_SUB_BUCKETS + bucket % PATH_STATS_SUB_BUCKETS) << shift;
+
+    return low + (1LL << shift) - 1;
+}
+
+void PathStats_Init(PathStats *stats)
+{
+    PathStats_Reset(stats);
+}
+
+void PathStats_Reset(PathStats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+static void PathStats_Add(PathStatsCounters *counters, const PathSearchReport *report)
+{
+    counters->searches++;
+
+    if (report->found)
+        counters->found++;
+    else
+        counters->failed++;
+
+    counters->expansions += report->expansions;
+    counters->opened += report->opened;
+    counters->path_length += report->length;
+    counters->elapsed_ns += report->elapsed_ns;
+}
+
+void PathStats_Record(PathStats *stats, const PathSearchReport *report)
+{
+    PathStats_Add(&stats->total, report);
+    PathStats_Add(&stats->current, report);
+
+    if (report->peak_open > stats->peak_open)
+        stats->peak_open = report->peak_open;
+
+    stats->histogram[PathStats_Bucket(report->elapsed_ns)]++;
+
+    if (report->elapsed_ns > stats->max_ns)
+        stats->max_ns = report->elapsed_ns;
+}
+
+void PathStats_Update(PathStats *stats, float dt)
+{
+    stats->window_time += dt;
+
+    if (stats->window_time < 1.0f)
+        return;
+
+    stats->last_second = stats->current;
+    memset(&stats->current, 0, sizeof(stats->current));
+
+    // A long frame closes one window only; the rest is dropped
+    stats->window_time = 0.0f;
+}
+
+long long PathStats_Percentile(const PathStats *stats, double p)
+{
+    long long count = stats->total.searches;
+
+    if (count == 0)
+        return 0;
+
+    // Rank of the sample at the percentile, from 1
+    long long rank = (long long)(p / 100.0 * (double)count + 0.999999);
+
+    if (rank < 1)
+        rank = 1;
+
+    if (rank > count)
+        rank = count;
+
+    long long seen = 0;
+
+    for (int bucket = 0; bucket < PATH_STATS_BUCKETS; ++bucket)
+    {
+        seen += stats->histogram[bucket];
+
+        if (seen >= rank)
+        {
+            long long high = PathStats_BucketHigh(bucket);
+
+            return high < stats->max_ns ? high : stats->max_ns;
+        }
+    }
+
+    return stats->max_ns;
+}
+
+long long PathStats_NowNs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
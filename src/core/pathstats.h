@@ -0,0 +1,96 @@
+#ifndef PATHSTATS_H
+#define PATHSTATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pathfinding.h"
+
+/*
+Running statistics of path searches, for the game to query and the
+debug overlay to show.
+
+Every finished search is folded into totals, into counters for the
+second in progress and into a latency histogram. Recording is a few
+additions and one bucket increment, so it stays on in release builds.
+
+The histogram is log-linear, like HDR histograms: each power of two
+of nanoseconds is split into PATH_STATS_SUB_BUCKETS equal buckets, so
+a reported percentile is within 1/PATH_STATS_SUB_BUCKETS of the
+recorded time however short or long the searches are.
+
+Not thread-safe: record from one thread only.
+*/
+
+// Buckets per power of two; sets the histogram precision
+#define PATH_STATS_SUB_BUCKETS 16
+
+// Powers of two covered above the first PATH_STATS_SUB_BUCKETS
+// nanoseconds; times beyond about two minutes land in the last bucket
+#define PATH_STATS_MAGNITUDES 33
+
+#define PATH_STATS_BUCKETS (PATH_STATS_SUB_BUCKETS * (PATH_STATS_MAGNITUDES + 1))
+
+// What one search did, as recorded by Pathfinding_FinishSearch
+typedef struct
+{
+    bool found;
+    int expansions;
+    int opened;
+    int peak_open;
+
+    // Tiles or waypoints in the path written out, 0 if none
+    int length;
+
+    long long elapsed_ns;
+} PathSearchReport;
+
+typedef struct
+{
+    int searches;
+    int found;
+    int failed;
+    long long expansions;
+    long long opened;
+    long long path_length;
+    long long elapsed_ns;
+} PathStatsCounters;
+
+struct PathStats
+{
+    // Since the last reset
+    PathStatsCounters total;
+
+    // The second in progress, and the last complete one
+    PathStatsCounters current;
+    PathStatsCounters last_second;
+    float window_time;
+
+    // Largest open set of any search since the last reset
+    int peak_open;
+
+    // Search times since the last reset
+    uint32_t histogram[PATH_STATS_BUCKETS];
+    long long max_ns;
+};
+
+void PathStats_Init(PathStats *stats);
+
+// Clears everything, including the histogram
+void PathStats_Reset(PathStats *stats);
+
+void PathStats_Record(PathStats *stats, const PathSearchReport *report);
+
+// Advances the window clock; a full second moves current to last_second
+void PathStats_Update(PathStats *stats, float dt);
+
+/*
+Search time at percentile p (0 to 100) in nanoseconds: the highest
+time that falls into the same bucket. Returns 0 if nothing was
+recorded.
+*/
+long long PathStats_Percentile(const PathStats *stats, double p);
+
+// Monotonic clock reading in nanoseconds
+long long PathStats_NowNs(void);
+
+#endif
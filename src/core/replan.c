@@ -0,0 +1,621 @@
+#include "replan.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Replanner module (D* Lite, Koenig & Likhachev).
+
+    It owns:
+    - Per-unit search state kept between repairs
+    - A snapshot of blocked tiles the plan was built against
+
+    It does NOT:
+    - Move units
+    - Modify Map
+*/
+
+#define REPLAN_INFINITY (INT_MAX / 2)
+
+// Change log entries read per Map_ReadChanges call
+#define REPLAN_CHANGE_BATCH 16
+
+// Reasons a tile is blocked in the snapshot
+#define REPLAN_BLOCKED_TERRAIN  1
+#define REPLAN_BLOCKED_OCCUPIED 2
+
+// neighbour offsets (Up, Right, Down, Left)
+static const int REPLAN_OFFSETS[4][2] =
+{
+    { 0, -1 },
+    { 1,  0 },
+    { 0,  1 },
+    { -1, 0 }
+};
+
+static int Replanner_Heuristic(const Replanner *planner, int a, int b)
+{
+    int dx = a % planner->width - b % planner->width;
+    int dy = a / planner->width - b / planner->width;
+
+    return (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy);
+}
+
+// Writes in-bounds neighbours, returns how many
+static int Replanner_Neighbours(const Replanner *planner, int index, int out[4])
+{
+    int tx = index % planner->width;
+    int ty = index / planner->width;
+    int count = 0;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        int nx = tx + REPLAN_OFFSETS[i][0];
+        int ny = ty + REPLAN_OFFSETS[i][1];
+
+        if (nx < 0 || ny < 0 || nx >= planner->width || ny >= planner->height)
+            continue;
+
+        out[count++] = ny * planner->width + nx;
+    }
+
+    return count;
+}
+
+// Terrain cost of entering to, infinite if either end is blocked
+static int Replanner_Cost(const Replanner *planner, int from, int to)
+{
+    if (planner->blocked[from] || planner->blocked[to])
+        return REPLAN_INFINITY;
+
+    return planner->cost[to];
+}
+
+static void Replanner_CalculateKey(const Replanner *planner, int index, int *out_k1, int *out_k2)
+{
+    int g = planner->g[index];
+    int rhs = planner->rhs[index];
+    int m = g < rhs ? g : rhs;
+
+    *out_k2 = m;
+
+    if (m >= REPLAN_INFINITY)
+        *out_k1 = REPLAN_INFINITY;
+    else
+        *out_k1 = m + Replanner_Heuristic(planner, planner->start, index) + planner->key_modifier;
+}
+
+/*
+    Indexed binary heap ordered by (key1, key2, node index).
+    The index tie-break keeps expansion order, and so paths, deterministic.
+*/
+static bool Replanner_KeyLess(int a1, int a2, int b1, int b2)
+{
+    if (a1 != b1)
+        return a1 < b1;
+
+    return a2 < b2;
+}
+
+static bool Replanner_HeapLess(const Replanner *planner, int a, int b)
+{
+    if (planner->key1[a] != planner->key1[b] || planner->key2[a] != planner->key2[b])
+        return Replanner_KeyLess(planner->key1[a], planner->key2[a], planner->key1[b], planner->key2[b]);
+
+    return a < b;
+}
+
+static void Replanner_HeapSwap(Replanner *planner, int i, int j)
+{
+    int a = planner->open_heap[i];
+    int b = planner->open_heap[j];
+
+    planner->open_heap[i] = b;
+    planner->open_heap[j] = a;
+    planner->heap_index[b] = i;
+    planner->heap_index[a] = j;
+}
+
+static void Replanner_HeapSiftUp(Replanner *planner, int i)
+{
+    while (i > 0)
+    {
+        int parent = (i - 1) / 2;
+
+        if (!Replanner_HeapLess(planner, planner->open_heap[i], planner->open_heap[parent]))
+            break;
+
+        Replanner_HeapSwap(planner, i, parent);
+        i = parent;
+    }
+}
+
+static void Replanner_HeapSiftDown(Replanner *planner, int i)
+{
+    for (;;)
+    {
+        int left = 2 * i + 1;
+        int right = left + 1;
+        int smallest = i;
+
+        if (left < planner->open_count &&
+            Replanner_HeapLess(planner, planner->open_heap[left], planner->open_heap[smallest]))
+            smallest = left;
+
+        if (right < planner->open_count &&
+            Replanner_HeapLess(planner, planner->open_heap[right], planner->open_heap[smallest]))
+            smallest = right;
+
+        if (smallest == i)
+            break;
+
+        Replanner_HeapSwap(planner, i, smallest);
+        i = smallest;
+    }
+}
+
+static void Replanner_HeapPush(Replanner *planner, int index)
+{
+    int slot = planner->open_count++;
+
+    planner->open_heap[slot] = index;
+    planner->heap_index[index] = slot;
+    Replanner_HeapSiftUp(planner, slot);
+}
+
+static void Replanner_HeapRemove(Replanner *planner, int index)
+{
+    int slot = planner->heap_index[index];
+    int last = --planner->open_count;
+
+    planner->heap_index[index] = -1;
+
+    if (slot == last)
+        return;
+
+    int moved = planner->open_heap[last];
+    planner->open_heap[slot] = moved;
+    planner->heap_index[moved] = slot;
+
+    Replanner_HeapSiftUp(planner, slot);
+    Replanner_HeapSiftDown(planner, planner->heap_index[moved]);
+}
+
+/*
+    Recomputes rhs from the successors and re-queues the node
+    if it became locally inconsistent (g != rhs).
+*/
+static void Replanner_UpdateVertex(Replanner *planner, int index)
+{
+    if (index != planner->goal)
+    {
+        int neighbours[4];
+        int count = Replanner_Neighbours(planner, index, neighbours);
+        int best = REPLAN_INFINITY;
+
+        for (int i = 0; i < count; ++i)
+        {
+            int next = neighbours[i];
+            int cost = Replanner_Cost(planner, index, next);
+
+            if (cost >= REPLAN_INFINITY || planner->g[next] >= REPLAN_INFINITY)
+                continue;
+
+            if (cost + planner->g[next] < best)
+                best = cost + planner->g[next];
+        }
+
+        planner->rhs[index] = best;
+    }
+
+    if (planner->heap_index[index] >= 0)
+        Replanner_HeapRemove(planner, index);
+
+    if (planner->g[index] != planner->rhs[index])
+    {
+        Replanner_CalculateKey(planner, index, &planner->key1[index], &planner->key2[index]);
+        Replanner_HeapPush(planner, index);
+    }
+}
+
+// A tile changed blocked state or cost: every edge touching it changed cost
+static void Replanner_UpdateTile(Replanner *planner, int index)
+{
+    int neighbours[4];
+    int count = Replanner_Neighbours(planner, index, neighbours);
+
+    Replanner_UpdateVertex(planner, index);
+
+    for (int i = 0; i < count; ++i)
+        Replanner_UpdateVertex(planner, neighbours[i]);
+}
+
+static void Replanner_SetBlocked(Replanner *planner, int index, unsigned char reason, bool value)
+{
+    bool was_blocked = planner->blocked[index] != 0;
+
+    if (value)
+        planner->blocked[index] |= reason;
+    else
+        planner->blocked[index] &= (unsigned char)~reason;
+
+    if (was_blocked != (planner->blocked[index] != 0))
+        Replanner_UpdateTile(planner, index);
+}
+
+// Brings the snapshot of the tiles in the rectangle (inclusive) in line with the map
+static void Replanner_SyncTerrain(Replanner *planner, const Map *map, int min_tx, int min_ty, int max_tx, int max_ty)
+{
+    for (int ty = min_ty; ty <= max_ty; ++ty)
+    {
+        for (int tx = min_tx; tx <= max_tx; ++tx)
+        {
+            int index = ty * planner->width + tx;
+            int cost = Map_GetCost(map, tx, ty);
+
+            if (planner->cost[index] != cost)
+            {
+                planner->cost[index] = (unsigned char)cost;
+                Replanner_UpdateTile(planner, index);
+            }
+
+            Replanner_SetBlocked(planner, index, REPLAN_BLOCKED_TERRAIN, !Map_IsWalkable(map, tx, ty));
+        }
+    }
+}
+
+/*
+    Resyncs only the rectangles of terrain edits published since the
+    last repair. A reader that fell behind the log gets a single
+    whole-map change, which resyncs everything.
+*/
+static void Replanner_ReadTerrainChanges(Replanner *planner, const Map *map)
+{
+    MapChange changes[REPLAN_CHANGE_BATCH];
+    int count;
+
+    while ((count = Map_ReadChanges(map, &planner->changes, changes, REPLAN_CHANGE_BATCH)) > 0)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            const MapChange *change = &changes[i];
+
+            if ((change->flags & (MAP_CHANGE_WALKABLE | MAP_CHANGE_COST)) == 0)
+                continue;
+
+            Replanner_SyncTerrain(planner, map, change->min_tx, change->min_ty, change->max_tx, change->max_ty);
+        }
+    }
+}
+
+static bool Replanner_InSenseRange(const Replanner *planner, int index)
+{
+    int dx = index % planner->width - planner->start % planner->width;
+    int dy = index / planner->width - planner->start / planner->width;
+
+    return dx >= -REPLAN_SENSE_RADIUS && dx <= REPLAN_SENSE_RADIUS &&
+           dy >= -REPLAN_SENSE_RADIUS && dy <= REPLAN_SENSE_RADIUS;
+}
+
+/*
+    Marks occupied tiles around the unit as blocked and releases
+    earlier marks that cleared or fell out of range.
+    The unit's own tile is never marked: it is occupied by the unit.
+*/
+static void Replanner_SenseOccupancy(Replanner *planner, const Map *map)
+{
+    int kept = 0;
+
+    for (int i = 0; i < planner->sensed_count; ++i)
+    {
+        int index = planner->sensed[i];
+
+        if (index != planner->start &&
+            Replanner_InSenseRange(planner, index) &&
+            Map_IsOccupied(map, index % planner->width, index / planner->width))
+        {
+            planner->sensed[kept++] = index;
+        }
+        else
+        {
+            Replanner_SetBlocked(planner, index, REPLAN_BLOCKED_OCCUPIED, false);
+        }
+    }
+
+    int start_tx = planner->start % planner->width;
+    int start_ty = planner->start / planner->width;
+
+    for (int ty = start_ty - REPLAN_SENSE_RADIUS; ty <= start_ty + REPLAN_SENSE_RADIUS; ++ty)
+    {
+        for (int tx = start_tx - REPLAN_SENSE_RADIUS; tx <= start_tx + REPLAN_SENSE_RADIUS; ++tx)
+        {
+            if (!Map_IsInside(map, tx, ty) || !Map_IsOccupied(map, tx, ty))
+                continue;
+
+            int index = ty * planner->width + tx;
+
+            if (index == planner->start || (planner->blocked[index] & REPLAN_BLOCKED_OCCUPIED))
+                continue;
+
+            Replanner_SetBlocked(planner, index, REPLAN_BLOCKED_OCCUPIED, true);
+            planner->sensed[kept++] = index;
+        }
+    }
+
+    planner->sensed_count = kept;
+}
+
+static void Replanner_ComputeShortestPath(Replanner *planner)
+{
+    int start = planner->start;
+
+    while (planner->open_count > 0)
+    {
+        int start_k1;
+        int start_k2;
+        Replanner_CalculateKey(planner, start, &start_k1, &start_k2);
+
+        int top = planner->open_heap[0];
+
+        if (!Replanner_KeyLess(planner->key1[top], planner->key2[top], start_k1, start_k2) &&
+            planner->rhs[start] == planner->g[start])
+            break;
+
+        planner->last_expansions++;
+
+        int new_k1;
+        int new_k2;
+        Replanner_CalculateKey(planner, top, &new_k1, &new_k2);
+
+        int neighbours[4];
+        int count = Replanner_Neighbours(planner, top, neighbours);
+
+        if (Replanner_KeyLess(planner->key1[top], planner->key2[top], new_k1, new_k2))
+        {
+            // Key went stale as the start moved; requeue with the current one
+            planner->key1[top] = new_k1;
+            planner->key2[top] = new_k2;
+            Replanner_HeapSiftDown(planner, 0);
+        }
+        else if (planner->g[top] > planner->rhs[top])
+        {
+            // Overconsistent: settle it and propagate the improvement
+            planner->g[top] = planner->rhs[top];
+            Replanner_HeapRemove(planner, top);
+
+            for (int i = 0; i < count; ++i)
+                Replanner_UpdateVertex(planner, neighbours[i]);
+        }
+        else
+        {
+            // Underconsistent: its cost rose, so everything routed through it is redone
+            planner->g[top] = REPLAN_INFINITY;
+            Replanner_UpdateVertex(planner, top);
+
+            for (int i = 0; i < count; ++i)
+                Replanner_UpdateVertex(planner, neighbours[i]);
+        }
+    }
+}
+
+/*
+    Follows the lowest cost + g neighbour from the start to the goal,
+    first in Up/Right/Down/Left order on ties. A route longer than
+    MAX_PATH_LENGTH tiles is cut to its first MAX_PATH_LENGTH, as much
+    as a Path holds; repairing from its last tile continues it.
+*/
+static bool Replanner_ExtractPath(const Replanner *planner, Path *out_path)
+{
+    int current = planner->start;
+    int length = 0;
+
+    if (planner->g[current] >= REPLAN_INFINITY)
+        return false;
+
+    while (length < MAX_PATH_LENGTH)
+    {
+        out_path->tiles[length][0] = current % planner->width;
+        out_path->tiles[length][1] = current / planner->width;
+        length++;
+
+        if (current == planner->goal)
+            break;
+
+        int neighbours[4];
+        int count = Replanner_Neighbours(planner, current, neighbours);
+        int best = REPLAN_INFINITY;
+        int best_next = -1;
+
+        for (int i = 0; i < count; ++i)
+        {
+            int next = neighbours[i];
+            int cost = Replanner_Cost(planner, current, next);
+
+            if (cost >= REPLAN_INFINITY || planner->g[next] >= REPLAN_INFINITY)
+                continue;
+
+            if (cost + planner->g[next] < best)
+            {
+                best = cost + planner->g[next];
+                best_next = next;
+            }
+        }
+
+        if (best_next < 0)
+            return false;
+
+        current = best_next;
+    }
+
+    out_path->length = length;
+
+    return true;
+}
+
+bool Replanner_Init(Replanner *planner, int width, int height)
+{
+    memset(planner, 0, sizeof(*planner));
+
+    planner->width = width;
+    planner->height = height;
+    planner->node_count = width * height;
+
+    planner->g = malloc((size_t)planner->node_count * sizeof(int));
+    planner->rhs = malloc((size_t)planner->node_count * sizeof(int));
+    planner->key1 = malloc((size_t)planner->node_count * sizeof(int));
+    planner->key2 = malloc((size_t)planner->node_count * sizeof(int));
+    planner->heap_index = malloc((size_t)planner->node_count * sizeof(int));
+    planner->open_heap = malloc((size_t)planner->node_count * sizeof(int));
+    planner->blocked = malloc((size_t)planner->node_count);
+    planner->cost = malloc((size_t)planner->node_count);
+
+    if (planner->g == NULL || planner->rhs == NULL || planner->key1 == NULL ||
+        planner->key2 == NULL || planner->heap_index == NULL ||
+        planner->open_heap == NULL || planner->blocked == NULL ||
+        planner->cost == NULL)
+    {
+        Replanner_Free(planner);
+        return false;
+    }
+
+    return true;
+}
+
+void Replanner_Free(Replanner *planner)
+{
+    free(planner->g);
+    free(planner->rhs);
+    free(planner->key1);
+    free(planner->key2);
+    free(planner->heap_index);
+    free(planner->open_heap);
+    free(planner->blocked);
+    free(planner->cost);
+
+    planner->g = NULL;
+    planner->rhs = NULL;
+    planner->key1 = NULL;
+    planner->key2 = NULL;
+    planner->heap_index = NULL;
+    planner->open_heap = NULL;
+    planner->blocked = NULL;
+    planner->cost = NULL;
+    planner->node_count = 0;
+}
+
+bool Replanner_Plan(
+    Replanner *planner,
+    const Map *map,
+    int start_tx,
+    int start_ty,
+    int goal_tx,
+    int goal_ty,
+    Path *out_path
+)
+{
+    out_path->length = 0;
+
+    if (map->width != planner->width || map->height != planner->height)
+        return false;
+
+    if (!Map_IsInside(map, start_tx, start_ty) || !Map_IsWalkable(map, goal_tx, goal_ty))
+        return false;
+
+    if (!Map_AreConnected(map, start_tx, start_ty, goal_tx, goal_ty))
+        return false;
+
+    for (int index = 0; index < planner->node_count; ++index)
+    {
+        planner->g[index] = REPLAN_INFINITY;
+        planner->rhs[index] = REPLAN_INFINITY;
+        planner->heap_index[index] = -1;
+        planner->blocked[index] = 0;
+        planner->cost[index] = MAP_TILE_COST_MIN;
+    }
+
+    planner->open_count = 0;
+    planner->sensed_count = 0;
+    planner->key_modifier = 0;
+    planner->last_expansions = 0;
+
+    planner->start = start_ty * planner->width + start_tx;
+    planner->goal = goal_ty * planner->width + goal_tx;
+    planner->last_start = planner->start;
+
+    // Seed the goal before the snapshot so tile updates around it see rhs = 0
+    planner->rhs[planner->goal] = 0;
+    Replanner_UpdateVertex(planner, planner->goal);
+
+    // Edits still unpublished are already in the snapshot; reading
+    // them again once published is harmless
+    Replanner_SyncTerrain(planner, map, 0, 0, planner->width - 1, planner->height - 1);
+    Map_ChangeReaderInit(map, &planner->changes);
+
+    Replanner_SenseOccupancy(planner, map);
+    Replanner_ComputeShortestPath(planner);
+
+    planner->planned = true;
+
+    return Replanner_ExtractPath(planner, out_path);
+}
+
+void Replanner_SetGoal(Replanner *planner, int goal_tx, int goal_ty)
+{
+    planner->goal = goal_ty * planner->width + goal_tx;
+    planner->planned = false;
+}
+
+bool Replanner_Replan(Replanner *planner, const Map *map, int start_tx, int start_ty, Path *out_path)
+{
+    out_path->length = 0;
+
+    if (map->width != planner->width || map->height != planner->height)
+        return false;
+
+    if (!Map_IsInside(map, start_tx, start_ty))
+        return false;
+
+    int goal_tx = planner->goal % planner->width;
+    int goal_ty = planner->goal / planner->width;
+
+    if (!planner->planned)
+        return Replanner_Plan(planner, map, start_tx, start_ty, goal_tx, goal_ty, out_path);
+
+    if (!Map_AreConnected(map, start_tx, start_ty, goal_tx, goal_ty))
+        return false;
+
+    planner->last_expansions = 0;
+
+    planner->start = start_ty * planner->width + start_tx;
+    planner->key_modifier += Replanner_Heuristic(planner, planner->last_start, planner->start);
+    planner->last_start = planner->start;
+
+    Replanner_ReadTerrainChanges(planner, map);
+
+    Replanner_SenseOccupancy(planner, map);
+    Replanner_ComputeShortestPath(planner);
+
+    return Replanner_ExtractPath(planner, out_path);
+}
+
+void Replanner_WriteDebug(const Replanner *planner, const Path *path, PathDebug *debug)
+{
+    // A trace too small for the planner's map is left alone
+    if (debug->node_count < planner->node_count)
+        return;
+
+    PathDebug_Clear(debug);
+
+    for (int index = 0; index < planner->node_count; ++index)
+    {
+        debug->open[index] = planner->heap_index[index] >= 0;
+        debug->closed[index] = !debug->open[index] && planner->g[index] < REPLAN_INFINITY;
+    }
+
+    if (path == NULL)
+        return;
+
+    for (int i = 0; i < path->length; ++i)
+        debug->in_path[path->tiles[i][1] * planner->width + path->tiles[i][0]] = true;
+}
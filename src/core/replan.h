@@ -0,0 +1,116 @@
+#ifndef REPLAN_H
+#define REPLAN_H
+
+#include <stdbool.h>
+#include "map.h"
+#include "pathfinding.h"
+
+/*
+Incremental replanning (D* Lite) for a single unit.
+
+The search runs backwards from the goal and keeps its g/rhs values
+between calls. When the unit finds its route blocked, only the tiles
+whose cost changed are re-queued, and the repair touches the region
+around them instead of repeating the whole search.
+
+The planner works from its own snapshot of what is blocked:
+- terrain walkability and costs, taken on Plan and then kept up with
+  the rectangles of published edits (Map_PublishChanges) on every repair
+- occupancy sensed within REPLAN_SENSE_RADIUS of the unit
+
+Occupancy further away is ignored: it will have moved by the time
+the unit gets there, and is picked up when the unit comes close.
+*/
+
+// Tiles around the unit whose occupancy is fed into the plan
+#define REPLAN_SENSE_RADIUS 3
+
+#define REPLAN_SENSE_TILES ((2 * REPLAN_SENSE_RADIUS + 1) * (2 * REPLAN_SENSE_RADIUS + 1))
+
+/*
+Search state persisted between repairs.
+One per unit that replans; reset by every Replanner_Plan.
+*/
+typedef struct
+{
+    // Size of the map the planner is allocated for
+    int width;
+    int height;
+    int node_count;
+
+    // Per-node D* Lite values, indexed ty * width + tx
+    int *g;
+    int *rhs;
+    int *key1;
+    int *key2;
+    int *heap_index;
+    unsigned char *blocked;
+
+    // Terrain cost of entering each tile, as of the changes read
+    unsigned char *cost;
+
+    // Priority queue of inconsistent nodes
+    int *open_heap;
+    int open_count;
+
+    int start;
+    int goal;
+
+    // Heuristic offset accumulated as the start moves (D* Lite k_m)
+    int key_modifier;
+    int last_start;
+
+    // Position in the map's change log the terrain snapshot has caught up to
+    MapChangeReader changes;
+
+    // Occupied tiles currently marked blocked from sensing
+    int sensed[REPLAN_SENSE_TILES];
+    int sensed_count;
+
+    // Nodes expanded by the last Plan/Replan call
+    int last_expansions;
+
+    // Search state belongs to the current goal; cleared by SetGoal
+    bool planned;
+} Replanner;
+
+// Allocates per-node storage for a width x height map; planning
+// fails on maps of any other size. Returns false on allocation failure.
+bool Replanner_Init(Replanner *planner, int width, int height);
+void Replanner_Free(Replanner *planner);
+
+/*
+Starts a new plan toward the goal with a full search.
+Same start/goal rules as Pathfinding_FindPath. A route longer than
+MAX_PATH_LENGTH tiles comes back cut to its first MAX_PATH_LENGTH;
+Replanner_Replan from its last tile continues it.
+*/
+bool Replanner_Plan(
+    Replanner *planner,
+    const Map *map,
+    int start_tx,
+    int start_ty,
+    int goal_tx,
+    int goal_ty,
+    Path *out_path
+);
+
+/*
+Retargets the planner without searching. The first Replanner_Replan
+afterwards runs the full plan, so orders that are never blocked
+never pay for one.
+*/
+void Replanner_SetGoal(Replanner *planner, int goal_tx, int goal_ty);
+
+/*
+Repairs the current plan from the unit's new tile after the map changed.
+Returns false if the goal is currently unreachable; the plan is kept
+and can be repaired again later.
+*/
+bool Replanner_Replan(Replanner *planner, const Map *map, int start_tx, int start_ty, Path *out_path);
+
+// Writes the planner state into the debug overlay.
+// path may be NULL when planning failed.
+void Replanner_WriteDebug(const Replanner *planner, const Path *path, PathDebug *debug);
+
+#endif
@@ -0,0 +1,641 @@
+#include "reservation.h"
+
+#include <limits.h>
+#include <stdlib.h>
+
+/*
+    Reservation module.
+
+    It owns:
+    - The (tile, step) claims of cooperating units
+    - Space-time search around those claims
+
+    It does NOT:
+    - Move units
+    - Modify Map
+*/
+
+#define RESERVATION_INFINITY INT_MAX
+
+_Static_assert(
+    RESERVATION_DEPTH > RESERVATION_LAYERS,
+    "reservation ring must cover every step a search can claim");
+
+// neighbour offsets (Up, Right, Down, Left)
+static const int RESERVATION_OFFSETS[4][2] =
+{
+    { 0, -1 },
+    { 1,  0 },
+    { 0,  1 },
+    { -1, 0 }
+};
+
+static bool ReservationTable_IsInside(const ReservationTable *table, int tx, int ty)
+{
+    return tx >= 0 && tx < table->width && ty >= 0 && ty < table->height;
+}
+
+bool ReservationTable_Init(ReservationTable *table, int width, int height, float step_seconds)
+{
+    table->width = width;
+    table->height = height;
+    table->node_count = width * height;
+    table->slots = malloc((size_t)RESERVATION_DEPTH * (size_t)table->node_count * sizeof(ReservationSlot));
+
+    table->now = 0;
+    table->elapsed = 0.0f;
+    table->step_seconds = step_seconds;
+
+    if (table->slots == NULL)
+    {
+        ReservationTable_Free(table);
+        return false;
+    }
+
+    for (int i = 0; i < RESERVATION_DEPTH * table->node_count; ++i)
+    {
+        table->slots[i].time = -1;
+        table->slots[i].owner = -1;
+    }
+
+    return true;
+}
+
+void ReservationTable_Free(ReservationTable *table)
+{
+    free(table->slots);
+
+    table->slots = NULL;
+    table->width = 0;
+    table->height = 0;
+    table->node_count = 0;
+}
+
+void ReservationTable_Advance(ReservationTable *table, float dt)
+{
+    table->elapsed += dt;
+
+    while (table->elapsed >= table->step_seconds)
+    {
+        table->elapsed -= table->step_seconds;
+        table->now++;
+    }
+}
+
+static ReservationSlot *ReservationTable_Slot(ReservationTable *table, int index, int time)
+{
+    return &table->slots[(time % RESERVATION_DEPTH) * table->node_count + index];
+}
+
+static int ReservationTable_OwnerAt(const ReservationTable *table, int index, int time)
+{
+    // Past steps and steps beyond the ring are never claimed
+    if (time < table->now || time >= table->now + RESERVATION_DEPTH)
+        return -1;
+
+    const ReservationSlot *slot = &table->slots[(time % RESERVATION_DEPTH) * table->node_count + index];
+
+    return slot->time == time ? slot->owner : -1;
+}
+
+int ReservationTable_GetOwner(const ReservationTable *table, int tx, int ty, int time)
+{
+    if (!ReservationTable_IsInside(table, tx, ty))
+        return -1;
+
+    return ReservationTable_OwnerAt(table, ty * table->width + tx, time);
+}
+
+bool ReservationTable_IsFree(const ReservationTable *table, int tx, int ty, int time, int owner)
+{
+    int current = ReservationTable_GetOwner(table, tx, ty, time);
+
+    return current == -1 || current == owner;
+}
+
+bool ReservationTable_Reserve(ReservationTable *table, int tx, int ty, int time, int owner)
+{
+    if (!ReservationTable_IsInside(table, tx, ty))
+        return false;
+
+    if (time < table->now || time >= table->now + RESERVATION_DEPTH)
+        return false;
+
+    if (!ReservationTable_IsFree(table, tx, ty, time, owner))
+        return false;
+
+    ReservationSlot *slot = ReservationTable_Slot(table, ty * table->width + tx, time);
+
+    slot->time = time;
+    slot->owner = owner;
+
+    return true;
+}
+
+void ReservationTable_Hold(ReservationTable *table, int tx, int ty, int owner)
+{
+    for (int t = table->now; t <= table->now + RESERVATION_WINDOW; ++t)
+        ReservationTable_Reserve(table, tx, ty, t, owner);
+}
+
+void ReservationTable_Release(ReservationTable *table, int owner)
+{
+    for (int t = table->now; t < table->now + RESERVATION_DEPTH; ++t)
+    {
+        ReservationSlot *row = ReservationTable_Slot(table, 0, t);
+
+        for (int i = 0; i < table->node_count; ++i)
+        {
+            if (row[i].time == t && row[i].owner == owner)
+                row[i].time = -1;
+        }
+    }
+}
+
+bool CooperativeSearch_Init(CooperativeSearch *search, ReservationTable *table)
+{
+    int tiles = table->node_count;
+    int node_count = RESERVATION_LAYERS * tiles;
+
+    // Space-time nodes are pushed once; distances at most once per edge
+    int heap_capacity = node_count > 4 * tiles ? node_count : 4 * tiles;
+
+    search->table = table;
+    search->distance = malloc((size_t)tiles * sizeof(int));
+    search->distance_goal = -1;
+    search->distance_revision = 0;
+    search->parent = malloc((size_t)node_count * sizeof(int));
+    search->stamp = calloc((size_t)node_count, sizeof(unsigned int));
+    search->generation = 0;
+    search->heap_f = malloc((size_t)(heap_capacity + 1) * sizeof(int));
+    search->heap_node = malloc((size_t)(heap_capacity + 1) * sizeof(int));
+    search->heap_count = 0;
+    search->last_expansions = 0;
+
+    if (search->distance == NULL || search->parent == NULL || search->stamp == NULL ||
+        search->heap_f == NULL || search->heap_node == NULL)
+    {
+        CooperativeSearch_Free(search);
+        return false;
+    }
+
+    return true;
+}
+
+void CooperativeSearch_Free(CooperativeSearch *search)
+{
+    free(search->distance);
+    free(search->parent);
+    free(search->stamp);
+    free(search->heap_f);
+    free(search->heap_node);
+
+    search->distance = NULL;
+    search->parent = NULL;
+    search->stamp = NULL;
+    search->heap_f = NULL;
+    search->heap_node = NULL;
+}
+
+/*
+    Min-heap of (f, node) pairs without decrease-key: terrain distances
+    push a tile again when it improves and skip stale entries on pop.
+
+    Ties on f go to the later step, then the lower node index, so
+    searches push toward the goal and stay deterministic.
+*/
+static bool Cooperative_HeapLess(const CooperativeSearch *search, int a, int b)
+{
+    if (search->heap_f[a] != search->heap_f[b])
+        return search->heap_f[a] < search->heap_f[b];
+
+    int layer_a = search->heap_node[a] / search->table->node_count;
+    int layer_b = search->heap_node[b] / search->table->node_count;
+
+    if (layer_a != layer_b)
+        return layer_a > layer_b;
+
+    return search->heap_node[a] < search->heap_node[b];
+}
+
+static void Cooperative_HeapSwap(CooperativeSearch *search, int a, int b)
+{
+    int f = search->heap_f[a];
+    int node = search->heap_node[a];
+
+    search->heap_f[a] = search->heap_f[b];
+    search->heap_node[a] = search->heap_node[b];
+    search->heap_f[b] = f;
+    search->heap_node[b] = node;
+}
+
+static void Cooperative_HeapPush(CooperativeSearch *search, int f, int node)
+{
+    int i = search->heap_count++;
+
+    search->heap_f[i] = f;
+    search->heap_node[i] = node;
+
+    while (i > 0)
+    {
+        int parent = (i - 1) / 2;
+
+        if (!Cooperative_HeapLess(search, i, parent))
+            break;
+
+        Cooperative_HeapSwap(search, i, parent);
+        i = parent;
+    }
+}
+
+static int Cooperative_HeapPop(CooperativeSearch *search, int *out_f)
+{
+    int node = search->heap_node[0];
+    *out_f = search->heap_f[0];
+
+    search->heap_count--;
+    search->heap_f[0] = search->heap_f[search->heap_count];
+    search->heap_node[0] = search->heap_node[search->heap_count];
+
+    int i = 0;
+
+    while (1)
+    {
+        int left = 2 * i + 1;
+        int right = left + 1;
+        int smallest = i;
+
+        if (left < search->heap_count && Cooperative_HeapLess(search, left, smallest))
+            smallest = left;
+
+        if (right < search->heap_count && Cooperative_HeapLess(search, right, smallest))
+            smallest = right;
+
+        if (smallest == i)
+            break;
+
+        Cooperative_HeapSwap(search, i, smallest);
+        i = smallest;
+    }
+
+    return node;
+}
+
+/*
+    Exact terrain cost from every tile to the goal (Dijkstra run
+    backwards from the goal; entering a tile costs its terrain).
+    Units are ignored: this is the abstract layer of the search, and
+    the route followed past the window.
+*/
+static void Cooperative_BuildDistances(CooperativeSearch *search, const Map *map, int goal)
+{
+    unsigned int revision = Map_GetWalkabilityRevision(map);
+
+    if (search->distance_goal == goal && search->distance_revision == revision)
+        return;
+
+    for (int i = 0; i < Map_TileCount(map); ++i)
+        search->distance[i] = RESERVATION_INFINITY;
+
+    search->distance[goal] = 0;
+    search->heap_count = 0;
+    Cooperative_HeapPush(search, 0, goal);
+
+    while (search->heap_count > 0)
+    {
+        int d;
+        int index = Cooperative_HeapPop(search, &d);
+
+        if (d != search->distance[index])
+            continue;
+
+        int tx = index % map->width;
+        int ty = index / map->width;
+        int step = d + Map_GetCost(map, tx, ty);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            int nx = tx + RESERVATION_OFFSETS[i][0];
+            int ny = ty + RESERVATION_OFFSETS[i][1];
+
+            if (!Map_IsWalkable(map, nx, ny))
+                continue;
+
+            int next = Map_Index(map, nx, ny);
+
+            if (step < search->distance[next])
+            {
+                search->distance[next] = step;
+                Cooperative_HeapPush(search, step, next);
+            }
+        }
+    }
+
+    search->distance_goal = goal;
+    search->distance_revision = revision;
+}
+
+/*
+    Tiles held by units outside the table block the whole window, as
+    in a plain search. A unit that holds a claim at the current step
+    cooperates, and its tile frees up when its schedule says so.
+*/
+static bool Cooperative_IsStaticBlocked(const CooperativeSearch *search, const Map *map, int index, int start)
+{
+    int tx = index % map->width;
+    int ty = index / map->width;
+
+    if (!Map_IsWalkable(map, tx, ty))
+        return true;
+
+    if (index == start || !Map_IsOccupied(map, tx, ty))
+        return false;
+
+    return ReservationTable_OwnerAt(search->table, index, search->table->now) == -1;
+}
+
+/*
+    Moving from `from` at step t onto `to` of cost c keeps the unit on
+    `from` until t + c - 1 and puts it on `to` at t + c. The move is
+    refused if any of those claims belongs to someone else, or if the
+    unit on `to` is heading onto `from` at the same time (a swap).
+*/
+static bool Cooperative_CanMove(const ReservationTable *table, int owner, int from, int to, int time, int cost)
+{
+    for (int k = 1; k < cost; ++k)
+    {
+        int other = ReservationTable_OwnerAt(table, from, time + k);
+
+        if (other != -1 && other != owner)
+            return false;
+    }
+
+    int arrival = time + cost;
+    int other = ReservationTable_OwnerAt(table, to, arrival);
+
+    if (other != -1 && other != owner)
+        return false;
+
+    int leaving = ReservationTable_OwnerAt(table, to, arrival - 1);
+
+    return leaving == -1 || leaving == owner ||
+           ReservationTable_OwnerAt(table, from, arrival) != leaving;
+}
+
+// True if the goal can be kept from step time to the end of the window
+static bool Cooperative_CanRest(const ReservationTable *table, int owner, int index, int time)
+{
+    for (int t = time; t <= table->now + RESERVATION_WINDOW; ++t)
+    {
+        int other = ReservationTable_OwnerAt(table, index, t);
+
+        if (other != -1 && other != owner)
+            return false;
+    }
+
+    return true;
+}
+
+// Claims a route's (tile, step) pairs, given its states from the start
+static void Cooperative_ReserveRoute(
+    ReservationTable *table, int owner, const int *states, int state_count, bool rests)
+{
+    int now = table->now;
+    int tiles = table->node_count;
+    int width = table->width;
+
+    for (int i = 0; i < state_count; ++i)
+    {
+        int index = states[i] % tiles;
+        int layer = states[i] / tiles;
+        int until = i + 1 < state_count ? states[i + 1] / tiles : layer + 1;
+
+        for (int t = layer; t < until; ++t)
+            ReservationTable_Reserve(table, index % width, index / width, now + t, owner);
+    }
+
+    if (rests)
+    {
+        int last = states[state_count - 1];
+        int index = last % tiles;
+
+        for (int t = now + last / tiles; t <= now + RESERVATION_WINDOW; ++t)
+            ReservationTable_Reserve(table, index % width, index / width, t, owner);
+    }
+}
+
+// Appends a tile to the route; false once the buffer is full
+static bool Cooperative_Append(CooperativePath *out_path, int width, int index, int depart)
+{
+    Path *path = &out_path->path;
+
+    if (path->length >= MAX_PATH_LENGTH)
+        return false;
+
+    path->tiles[path->length][0] = index % width;
+    path->tiles[path->length][1] = index / width;
+    out_path->depart[path->length] = depart;
+    path->length++;
+
+    return true;
+}
+
+bool Cooperative_FindPath(
+    CooperativeSearch *search,
+    const Map *map,
+    int owner,
+    int start_tx,
+    int start_ty,
+    int goal_tx,
+    int goal_ty,
+    CooperativePath *out_path
+)
+{
+    ReservationTable *table = search->table;
+    int now = table->now;
+    int tiles = table->node_count;
+    int width = table->width;
+
+    out_path->path.length = 0;
+    search->last_expansions = 0;
+
+    ReservationTable_Release(table, owner);
+
+    // The table and the search scratch are sized for one map
+    bool fits = map->width == table->width && map->height == table->height;
+
+    if (!fits || !Map_IsInside(map, start_tx, start_ty) || !Map_IsWalkable(map, goal_tx, goal_ty) ||
+        !Map_AreConnected(map, start_tx, start_ty, goal_tx, goal_ty))
+    {
+        ReservationTable_Hold(table, start_tx, start_ty, owner);
+        return false;
+    }
+
+    int start = start_ty * width + start_tx;
+    int goal = goal_ty * width + goal_tx;
+
+    Cooperative_BuildDistances(search, map, goal);
+
+    if (search->distance[start] == RESERVATION_INFINITY)
+    {
+        ReservationTable_Hold(table, start_tx, start_ty, owner);
+        return false;
+    }
+
+    // Every node from previous searches becomes stale at once
+    search->generation++;
+
+    if (search->generation == 0)
+    {
+        for (int i = 0; i < RESERVATION_LAYERS * tiles; ++i)
+            search->stamp[i] = 0;
+
+        search->generation = 1;
+    }
+
+    // The step a node is reached at is its cost, so the first time a
+    // node is reached is already the cheapest and nodes never reopen
+    search->heap_count = 0;
+    search->stamp[start] = search->generation;
+    search->parent[start] = -1;
+    Cooperative_HeapPush(search, search->distance[start], start);
+
+    int found = -1;
+    bool rests = false;
+
+    while (search->heap_count > 0)
+    {
+        int f;
+        int node = Cooperative_HeapPop(search, &f);
+        int index = node % tiles;
+        int layer = node / tiles;
+        int time = now + layer;
+
+        search->last_expansions++;
+
+        if (index == goal && Cooperative_CanRest(table, owner, index, time))
+        {
+            found = node;
+            rests = true;
+            break;
+        }
+
+        // End of the window: the rest follows the plain route
+        if (layer >= RESERVATION_WINDOW)
+        {
+            found = node;
+            break;
+        }
+
+        int tx = index % width;
+        int ty = index / width;
+
+        // Wait in place for one step
+        int wait = node + tiles;
+
+        if (search->stamp[wait] != search->generation &&
+            ReservationTable_IsFree(table, tx, ty, time + 1, owner))
+        {
+            search->stamp[wait] = search->generation;
+            search->parent[wait] = node;
+            Cooperative_HeapPush(search, layer + 1 + search->distance[index], wait);
+        }
+
+        for (int i = 0; i < 4; ++i)
+        {
+            int nx = tx + RESERVATION_OFFSETS[i][0];
+            int ny = ty + RESERVATION_OFFSETS[i][1];
+
+            if (!Map_IsInside(map, nx, ny))
+                continue;
+
+            int next_index = ny * width + nx;
+
+            if (search->distance[next_index] == RESERVATION_INFINITY)
+                continue;
+
+            if (Cooperative_IsStaticBlocked(search, map, next_index, start))
+                continue;
+
+            int cost = Map_GetCost(map, nx, ny);
+            int next = (layer + cost) * tiles + next_index;
+
+            if (search->stamp[next] == search->generation)
+                continue;
+
+            if (!Cooperative_CanMove(table, owner, index, next_index, time, cost))
+                continue;
+
+            search->stamp[next] = search->generation;
+            search->parent[next] = node;
+            Cooperative_HeapPush(search, layer + cost + search->distance[next_index], next);
+        }
+    }
+
+    if (found == -1)
+    {
+        ReservationTable_Hold(table, start_tx, start_ty, owner);
+        return false;
+    }
+
+    // Every state is at least one step later than its parent
+    int *states = search->route;
+    int state_count = 0;
+
+    for (int node = found; node != -1; node = search->parent[node])
+        state_count++;
+
+    int write = state_count;
+
+    for (int node = found; node != -1; node = search->parent[node])
+        states[--write] = node;
+
+    Cooperative_ReserveRoute(table, owner, states, state_count, rests);
+
+    // Waits only delay the next move; the tiles list holds moves
+    Cooperative_Append(out_path, width, start, -1);
+
+    for (int i = 1; i < state_count; ++i)
+    {
+        if (states[i] % tiles == states[i - 1] % tiles)
+            continue;
+
+        Cooperative_Append(out_path, width, states[i] % tiles, now + states[i - 1] / tiles);
+    }
+
+    // Past the window: descend the terrain distances to the goal
+    int current = found % tiles;
+
+    while (current != goal)
+    {
+        int tx = current % width;
+        int ty = current / width;
+        int best = -1;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            int nx = tx + RESERVATION_OFFSETS[i][0];
+            int ny = ty + RESERVATION_OFFSETS[i][1];
+
+            if (!Map_IsWalkable(map, nx, ny))
+                continue;
+
+            int next = ny * width + nx;
+
+            if (search->distance[next] != RESERVATION_INFINITY &&
+                search->distance[next] + Map_GetCost(map, nx, ny) == search->distance[current])
+            {
+                best = next;
+                break;
+            }
+        }
+
+        // The route continues in the next window's plan
+        if (best == -1 || !Cooperative_Append(out_path, width, best, -1))
+            break;
+
+        current = best;
+    }
+
+    return true;
+}
@@ -0,0 +1,157 @@
+#ifndef RESERVATION_H
+#define RESERVATION_H
+
+#include <stdbool.h>
+#include "map.h"
+#include "pathfinding.h"
+
+/*
+Cooperative pathfinding (windowed hierarchical cooperative A*).
+
+Units sharing a ReservationTable plan in space and time: a route
+claims (tile, step) pairs, and later searches plan around them by
+waiting or stepping aside instead of treating other units as walls.
+Only the next RESERVATION_WINDOW steps are planned cooperatively;
+past the window a unit follows the plain shortest route, and plans
+the next window before it gets there.
+
+Time is counted in steps of the table clock. Entering a tile of cost
+c takes c steps, which matches how long a unit at UNIT_DEFAULT_SPEED
+takes to cross it when the clock runs at one step per TILE_SIZE / speed
+seconds.
+
+The abstract layer guiding the search is the exact terrain distance
+to the goal, built once per goal by a backward search that ignores
+units.
+*/
+
+// Steps planned around other units before falling back to the plain route
+#define RESERVATION_WINDOW 16
+
+// Steps of the future the table can hold; covers a window plus one step
+// onto the costliest tile
+#define RESERVATION_DEPTH 32
+
+// Space-time layers searched: a window plus one step onto the costliest tile
+#define RESERVATION_LAYERS (RESERVATION_WINDOW + MAP_TILE_COST_MAX)
+
+// Steps a unit may fall behind its schedule before it replans
+#define RESERVATION_SLACK 1
+
+/*
+One (tile, step) claim. A slot holds the claim for the step it was
+written for, so claims expire by themselves as the clock moves on.
+*/
+typedef struct
+{
+    int time;
+    int owner;
+} ReservationSlot;
+
+typedef struct
+{
+    // Size of the map the table covers
+    int width;
+    int height;
+    int node_count;
+
+    // Ring over time: slot [(t % DEPTH) * node_count + tile] is valid
+    // while its time is t
+    ReservationSlot *slots;
+
+    // Current step, and seconds accumulated toward the next one
+    int now;
+    float elapsed;
+    float step_seconds;
+} ReservationTable;
+
+// Allocates claims for a width x height map. Returns false on allocation failure.
+bool ReservationTable_Init(ReservationTable *table, int width, int height, float step_seconds);
+void ReservationTable_Free(ReservationTable *table);
+
+// Advances the clock by dt seconds, one step per step_seconds
+void ReservationTable_Advance(ReservationTable *table, float dt);
+
+// Owner of the tile at step t, -1 if unclaimed
+int ReservationTable_GetOwner(const ReservationTable *table, int tx, int ty, int time);
+
+// True if nobody but owner claims the tile at step t
+bool ReservationTable_IsFree(const ReservationTable *table, int tx, int ty, int time, int owner);
+
+// Claims the tile at step t. Returns false if another owner has it.
+bool ReservationTable_Reserve(ReservationTable *table, int tx, int ty, int time, int owner);
+
+// Claims the tile for every free step of the coming window (a unit at rest)
+void ReservationTable_Hold(ReservationTable *table, int tx, int ty, int owner);
+
+// Drops every current and future claim of owner
+void ReservationTable_Release(ReservationTable *table, int owner);
+
+/*
+Path with a schedule: depart[i] is the step at which the move onto
+tiles[i] may start, or -1 for moves past the window that are not
+reserved yet. depart[0] is unused.
+*/
+typedef struct
+{
+    Path path;
+    int depart[MAX_PATH_LENGTH];
+} CooperativePath;
+
+/*
+Search scratch space for cooperative planning, shared by every unit
+planning against the same table. One search at a time.
+*/
+typedef struct
+{
+    ReservationTable *table;
+
+    // Terrain cost from each tile to distance_goal, ignoring units;
+    // rebuilt when the goal or the map revision changes
+    int *distance;
+    int distance_goal;
+    unsigned int distance_revision;
+
+    // Space-time nodes, indexed layer * table->node_count + tile where
+    // layer is the step relative to the clock at search time
+    int *parent;
+    unsigned int *stamp;
+    unsigned int generation;
+
+    // States of the route found, start first
+    int route[RESERVATION_LAYERS + 1];
+
+    // Min-heap of (f, node) pairs shared by both searches
+    int *heap_f;
+    int *heap_node;
+    int heap_count;
+
+    // Space-time nodes expanded by the last search
+    int last_expansions;
+} CooperativeSearch;
+
+// Allocates storage for the table's map size. Returns false on allocation failure.
+bool CooperativeSearch_Init(CooperativeSearch *search, ReservationTable *table);
+void CooperativeSearch_Free(CooperativeSearch *search);
+
+/*
+Replaces owner's claims with a new route from start toward the goal:
+the first window planned around other claims and reserved, the rest
+along the plain shortest route. A unit reaching its goal inside the
+window keeps it claimed to the end of the window.
+
+Returns false if no route exists or the map is not the size of the
+table; owner then holds the start tile.
+*/
+bool Cooperative_FindPath(
+    CooperativeSearch *search,
+    const Map *map,
+    int owner,
+    int start_tx,
+    int start_ty,
+    int goal_tx,
+    int goal_ty,
+    CooperativePath *out_path
+);
+
+#endif
@@ -0,0 +1,242 @@
+#include "route.h"
+
+#include <stdlib.h>
+
+/*
+    Route module.
+
+    It owns:
+    - The chunk pool shared by every stored route
+    - Encoding paths into segments and walking them back out
+
+    It does NOT:
+    - Move units
+    - Check walkability
+*/
+
+static int Route_Abs(int value)
+{
+    return value < 0 ? -value : value;
+}
+
+static int Route_Sign(int value)
+{
+    return (value > 0) - (value < 0);
+}
+
+// Straight or diagonal offsets are runs of single moves
+static bool Route_IsRun(int dx, int dy)
+{
+    return dx == 0 || dy == 0 || Route_Abs(dx) == Route_Abs(dy);
+}
+
+// Moves a segment stands for: the run length, or 1 for a waypoint
+static int Route_Moves(const RouteSegment *segment)
+{
+    if (!Route_IsRun(segment->dx, segment->dy))
+        return 1;
+
+    int length_x = Route_Abs(segment->dx);
+    int length_y = Route_Abs(segment->dy);
+
+    return length_x > length_y ? length_x : length_y;
+}
+
+bool RoutePool_Init(RoutePool *pool, int chunk_count)
+{
+    pool->chunks = malloc((size_t)chunk_count * sizeof(RouteChunk));
+    pool->capacity = chunk_count;
+
+    if (pool->chunks == NULL)
+    {
+        RoutePool_Free(pool);
+        return false;
+    }
+
+    for (int i = 0; i < chunk_count; ++i)
+    {
+        pool->chunks[i].count = 0;
+        pool->chunks[i].next = i + 1 < chunk_count ? i + 1 : -1;
+    }
+
+    pool->free_head = chunk_count > 0 ? 0 : -1;
+    pool->free_count = chunk_count;
+
+    return true;
+}
+
+void RoutePool_Free(RoutePool *pool)
+{
+    free(pool->chunks);
+
+    pool->chunks = NULL;
+    pool->capacity = 0;
+    pool->free_head = -1;
+    pool->free_count = 0;
+}
+
+static int RoutePool_Alloc(RoutePool *pool)
+{
+    int chunk = pool->free_head;
+
+    if (chunk == -1)
+        return -1;
+
+    pool->free_head = pool->chunks[chunk].next;
+    pool->free_count--;
+
+    pool->chunks[chunk].count = 0;
+    pool->chunks[chunk].next = -1;
+
+    return chunk;
+}
+
+void RoutePool_Release(RoutePool *pool, int first_chunk)
+{
+    int chunk = first_chunk;
+
+    while (chunk != -1)
+    {
+        int next = pool->chunks[chunk].next;
+
+        pool->chunks[chunk].next = pool->free_head;
+        pool->free_head = chunk;
+        pool->free_count++;
+
+        chunk = next;
+    }
+}
+
+/*
+    Folds one move into the last segment when both are unscheduled
+    runs in the same direction, else starts a new segment.
+    Returns false if a new chunk was needed and the pool is empty.
+*/
+static bool RoutePool_Append(RoutePool *pool, int *first_chunk, int *last_chunk, int dx, int dy, int depart)
+{
+    if (*last_chunk != -1 && depart == -1 && Route_IsRun(dx, dy))
+    {
+        RouteChunk *chunk = &pool->chunks[*last_chunk];
+        RouteSegment *last = &chunk->segments[chunk->count - 1];
+
+        bool same_direction =
+            Route_IsRun(last->dx, last->dy) &&
+            Route_Sign(last->dx) == Route_Sign(dx) &&
+            Route_Sign(last->dy) == Route_Sign(dy);
+
+        int merged_dx = last->dx + dx;
+        int merged_dy = last->dy + dy;
+
+        if (last->depart == -1 && same_direction &&
+            Route_Abs(merged_dx) <= INT16_MAX && Route_Abs(merged_dy) <= INT16_MAX)
+        {
+            last->dx = (int16_t)merged_dx;
+            last->dy = (int16_t)merged_dy;
+            return true;
+        }
+    }
+
+    if (*last_chunk == -1 || pool->chunks[*last_chunk].count == ROUTE_CHUNK_SEGMENTS)
+    {
+        int chunk = RoutePool_Alloc(pool);
+
+        if (chunk == -1)
+            return false;
+
+        if (*last_chunk == -1)
+            *first_chunk = chunk;
+        else
+            pool->chunks[*last_chunk].next = chunk;
+
+        *last_chunk = chunk;
+    }
+
+    RouteChunk *chunk = &pool->chunks[*last_chunk];
+    RouteSegment *segment = &chunk->segments[chunk->count++];
+
+    segment->dx = (int16_t)dx;
+    segment->dy = (int16_t)dy;
+    segment->depart = depart;
+
+    return true;
+}
+
+int RoutePool_Store(RoutePool *pool, const Path *path, const int *depart)
+{
+    int first_chunk = -1;
+    int last_chunk = -1;
+
+    for (int i = 1; i < path->length; ++i)
+    {
+        int dx = path->tiles[i][0] - path->tiles[i - 1][0];
+        int dy = path->tiles[i][1] - path->tiles[i - 1][1];
+
+        if (!RoutePool_Append(pool, &first_chunk, &last_chunk, dx, dy, depart ? depart[i] : -1))
+            break;
+    }
+
+    return first_chunk;
+}
+
+int RoutePool_CountSegments(const RoutePool *pool, int first_chunk)
+{
+    int count = 0;
+
+    for (int chunk = first_chunk; chunk != -1; chunk = pool->chunks[chunk].next)
+        count += pool->chunks[chunk].count;
+
+    return count;
+}
+
+RouteCursor Route_Begin(int first_chunk, int tx, int ty)
+{
+    RouteCursor cursor = { first_chunk, 0, 0, tx, ty };
+
+    return cursor;
+}
+
+bool Route_Peek(const RoutePool *pool, const RouteCursor *cursor, int *out_tx, int *out_ty, int *out_depart)
+{
+    if (cursor->chunk == -1)
+        return false;
+
+    const RouteSegment *segment = &pool->chunks[cursor->chunk].segments[cursor->segment];
+
+    if (Route_IsRun(segment->dx, segment->dy))
+    {
+        *out_tx = cursor->tx + Route_Sign(segment->dx) * (cursor->step + 1);
+        *out_ty = cursor->ty + Route_Sign(segment->dy) * (cursor->step + 1);
+    }
+    else
+    {
+        *out_tx = cursor->tx + segment->dx;
+        *out_ty = cursor->ty + segment->dy;
+    }
+
+    // Only the first move of a segment can be scheduled
+    *out_depart = cursor->step == 0 ? segment->depart : -1;
+
+    return true;
+}
+
+void Route_Advance(const RoutePool *pool, RouteCursor *cursor)
+{
+    if (cursor->chunk == -1)
+        return;
+
+    const RouteChunk *chunk = &pool->chunks[cursor->chunk];
+    const RouteSegment *segment = &chunk->segments[cursor->segment];
+
+    if (++cursor->step < Route_Moves(segment))
+        return;
+
+    cursor->tx += segment->dx;
+    cursor->ty += segment->dy;
+    cursor->step = 0;
+
+    if (++cursor->segment < chunk->count)
+        return;
+
+    cursor->chunk = chunk->next;
+    cursor->segment = 0;
+}
@@ -0,0 +1,107 @@
+#ifndef ROUTE_H
+#define ROUTE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pathfinding.h"
+
+/*
+Compact storage for the routes units follow.
+
+A route is a start tile plus a list of segments, each an offset from
+where the previous one ended. Offsets along one of the eight grid
+directions are runs, walked one tile at a time; consecutive steps in
+the same direction share one segment. Any other offset is a waypoint
+of a smoothed path, walked in a single straight move.
+
+Segments live in fixed-size chunks of a shared pool, linked into a
+chain per route, so a unit only carries a cursor into its chain and
+idle units hold no route storage at all.
+*/
+
+// Segments per chunk; with the link and count a chunk fills 64 bytes
+#define ROUTE_CHUNK_SEGMENTS 7
+
+// Chunks in a pool unless configured otherwise
+#define ROUTE_POOL_DEFAULT_CHUNKS 4096
+
+typedef struct
+{
+    // Offset from the end of the previous segment
+    int16_t dx;
+    int16_t dy;
+
+    // Cooperative schedule: step at which the segment's first move
+    // may start, -1 if not reserved. Scheduled segments are never merged.
+    int32_t depart;
+} RouteSegment;
+
+typedef struct
+{
+    RouteSegment segments[ROUTE_CHUNK_SEGMENTS];
+
+    // Segments in use, and the next chunk of the route (-1 at the end)
+    int count;
+    int next;
+} RouteChunk;
+
+typedef struct
+{
+    RouteChunk *chunks;
+    int capacity;
+
+    // Chain of unused chunks, linked through next
+    int free_head;
+    int free_count;
+} RoutePool;
+
+/*
+Position along a route. Copies are cheap, so callers look ahead by
+advancing a copy.
+*/
+typedef struct
+{
+    // Chunk and segment of the next move, chunk -1 once the route is done
+    int chunk;
+    int segment;
+
+    // Moves already taken along a run segment
+    int step;
+
+    // Tile the current segment starts from
+    int tx;
+    int ty;
+} RouteCursor;
+
+// Allocates chunk_count chunks. Returns false on allocation failure.
+bool RoutePool_Init(RoutePool *pool, int chunk_count);
+void RoutePool_Free(RoutePool *pool);
+
+/*
+Encodes the moves of path after its first tile into a new chain.
+depart is optional: depart[i] is the step at which the move onto
+tiles[i] may start, or -1.
+Returns the first chunk, or -1 for an empty route. If the pool runs
+out the route is cut short where it did.
+*/
+int RoutePool_Store(RoutePool *pool, const Path *path, const int *depart);
+
+// Returns every chunk of the chain to the pool; -1 is ignored
+void RoutePool_Release(RoutePool *pool, int first_chunk);
+
+// Segments in a chain
+int RoutePool_CountSegments(const RoutePool *pool, int first_chunk);
+
+// Cursor at the start of a chain stored from a path beginning at (tx, ty)
+RouteCursor Route_Begin(int first_chunk, int tx, int ty);
+
+/*
+Reads the next move without taking it: its target tile and reserved
+departure. Returns false once the route is done.
+*/
+bool Route_Peek(const RoutePool *pool, const RouteCursor *cursor, int *out_tx, int *out_ty, int *out_depart);
+
+// Takes the next move
+void Route_Advance(const RoutePool *pool, RouteCursor *cursor);
+
+#endif
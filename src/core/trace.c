@@ -0,0 +1,148 @@
+#include "trace.h"
+
+#include <stdatomic.h>
+
+/*
+    Trace module.
+
+    It owns:
+    - The event ring shared by every thread
+    - Decoding events to text
+
+    It does NOT:
+    - Write anything until asked to dump
+*/
+
+_Static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0, "trace ring size must be a power of two");
+
+/*
+    Each slot carries a stamp: 0 while being written, else the slot's
+    sequence + 1 once complete. Readers check the stamp before and after
+    copying a slot, so a slot overwritten mid-copy is skipped rather than
+    returned torn.
+*/
+typedef struct
+{
+    _Atomic uint32_t stamp;
+    TraceEvent event;
+} TraceSlot;
+
+static TraceSlot trace_ring[TRACE_RING_SIZE];
+static _Atomic uint32_t trace_next;
+
+void Trace_Record(TraceEventType type, unsigned int flags, int a, int b, int c, int d)
+{
+    uint32_t sequence = atomic_fetch_add_explicit(&trace_next, 1, memory_order_relaxed);
+    TraceSlot *slot = &trace_ring[sequence & (TRACE_RING_SIZE - 1)];
+
+    atomic_store_explicit(&slot->stamp, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    slot->event.sequence = sequence;
+    slot->event.type = (uint16_t)type;
+    slot->event.flags = (uint16_t)flags;
+    slot->event.args[0] = a;
+    slot->event.args[1] = b;
+    slot->event.args[2] = c;
+    slot->event.args[3] = d;
+
+    atomic_store_explicit(&slot->stamp, sequence + 1, memory_order_release);
+}
+
+uint32_t Trace_Count(void)
+{
+    return atomic_load_explicit(&trace_next, memory_order_acquire);
+}
+
+int Trace_Snapshot(TraceEvent *out, int capacity)
+{
+    uint32_t end = Trace_Count();
+    uint32_t available = end < TRACE_RING_SIZE ? end : TRACE_RING_SIZE;
+
+    if ((uint32_t)capacity < available)
+        available = (uint32_t)capacity;
+
+    int count = 0;
+
+    for (uint32_t sequence = end - available; sequence != end; ++sequence)
+    {
+        const TraceSlot *slot = &trace_ring[sequence & (TRACE_RING_SIZE - 1)];
+
+        if (atomic_load_explicit(&slot->stamp, memory_order_acquire) != sequence + 1)
+            continue;
+
+        TraceEvent event = slot->event;
+
+        atomic_thread_fence(memory_order_acquire);
+
+        if (atomic_load_explicit(&slot->stamp, memory_order_relaxed) != sequence + 1)
+            continue;
+
+        out[count++] = event;
+    }
+
+    return count;
+}
+
+static const char *Trace_TypeName(uint16_t type)
+{
+    switch (type)
+    {
+        case TRACE_EVENT_PATH_BEGIN:        return "path-begin";
+        case TRACE_EVENT_PATH_END:          return "path-end";
+        case TRACE_EVENT_MOVE_ORDER:        return "move-order";
+        case TRACE_EVENT_COOPERATIVE_ORDER: return "cooperative-order";
+        case TRACE_EVENT_ORDER_DROPPED:     return "order-dropped";
+        default:                            return "unknown";
+    }
+}
+
+void Trace_Dump(FILE *out)
+{
+    static TraceEvent events[TRACE_RING_SIZE];
+    int count = Trace_Snapshot(events, TRACE_RING_SIZE);
+
+    fprintf(out, "-- Trace: %d of %u events --\n", count, (unsigned int)Trace_Count());
+
+    for (int i = 0; i < count; ++i)
+    {
+        const TraceEvent *event = &events[i];
+        const int32_t *args = event->args;
+
+        fprintf(out, "%8u %-18s ", (unsigned int)event->sequence, Trace_TypeName(event->type));
+
+        switch (event->type)
+        {
+            case TRACE_EVENT_PATH_BEGIN:
+                fprintf(out, "(%d,%d) -> (%d,%d) goal walkable %d occupied %d\n",
+                    args[0], args[1], args[2], args[3],
+                    (event->flags & TRACE_FLAG_GOAL_WALKABLE) != 0,
+                    (event->flags & TRACE_FLAG_GOAL_OCCUPIED) != 0);
+                break;
+
+            case TRACE_EVENT_PATH_END:
+                fprintf(out, "%s status %d expansions %d length %d algorithm %d\n",
+                    (event->flags & TRACE_FLAG_FOUND) ? "found" : "failed",
+                    args[0], args[1], args[2], args[3]);
+                break;
+
+            case TRACE_EVENT_MOVE_ORDER:
+            case TRACE_EVENT_COOPERATIVE_ORDER:
+            case TRACE_EVENT_ORDER_DROPPED:
+                fprintf(out, "unit %d -> (%d,%d)\n", args[0], args[1], args[2]);
+                break;
+
+            default:
+                fprintf(out, "%d %d %d %d\n", args[0], args[1], args[2], args[3]);
+                break;
+        }
+    }
+}
+
+void Trace_Clear(void)
+{
+    for (int i = 0; i < TRACE_RING_SIZE; ++i)
+        atomic_store_explicit(&trace_ring[i].stamp, 0, memory_order_relaxed);
+
+    atomic_store_explicit(&trace_next, 0, memory_order_release);
+}
@@ -0,0 +1,89 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+In-memory trace of structured events, replacing per-query logging.
+
+Events are fixed-size binary records written to a ring that keeps
+the most recent TRACE_RING_SIZE of them. Recording is lock-free and
+never blocks: each writer claims a slot with one atomic increment,
+so worker threads can record while a search runs. Nothing is
+formatted until the ring is dumped.
+
+TRACE_LEVEL selects what is compiled in:
+    0 - nothing; TRACE_EVENT expands to no code at all
+    1 - path queries and move orders (default)
+*/
+
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL 1
+#endif
+
+// Events kept; a power of two
+#define TRACE_RING_SIZE 4096
+
+typedef enum
+{
+    TRACE_EVENT_NONE = 0,
+
+    // Search started: start tx, ty, goal tx, ty.
+    // Flags: TRACE_FLAG_GOAL_WALKABLE, TRACE_FLAG_GOAL_OCCUPIED
+    TRACE_EVENT_PATH_BEGIN,
+
+    // Search finished: status, expansions, path length, algorithm.
+    // Flags: TRACE_FLAG_FOUND
+    TRACE_EVENT_PATH_END,
+
+    // Move order issued: unit id, goal tx, ty
+    TRACE_EVENT_MOVE_ORDER,
+
+    // Move order for a cooperative unit: unit id, goal tx, ty
+    TRACE_EVENT_COOPERATIVE_ORDER,
+
+    // Move order dropped, request queue full: unit id, goal tx, ty
+    TRACE_EVENT_ORDER_DROPPED
+} TraceEventType;
+
+#define TRACE_FLAG_GOAL_WALKABLE 0x1
+#define TRACE_FLAG_GOAL_OCCUPIED 0x2
+#define TRACE_FLAG_FOUND         0x1
+
+typedef struct
+{
+    // Position in the stream of every event recorded, from 0
+    uint32_t sequence;
+
+    uint16_t type;
+    uint16_t flags;
+    int32_t args[4];
+} TraceEvent;
+
+// Records one event; arguments the type does not use are ignored
+void Trace_Record(TraceEventType type, unsigned int flags, int a, int b, int c, int d);
+
+/*
+Copies up to capacity of the most recent events, oldest first.
+Slots being written during the copy are skipped.
+Returns the number of events copied.
+*/
+int Trace_Snapshot(TraceEvent *out, int capacity);
+
+// Events recorded so far, including those overwritten since
+uint32_t Trace_Count(void);
+
+// Decodes every event still in the ring as text, oldest first
+void Trace_Dump(FILE *out);
+
+// Drops every event; not safe while other threads record
+void Trace_Clear(void);
+
+#if TRACE_LEVEL >= 1
+#define TRACE_EVENT(type, flags, a, b, c, d) Trace_Record((type), (flags), (a), (b), (c), (d))
+#else
+#define TRACE_EVENT(type, flags, a, b, c, d) ((void)0)
+#endif
+
+#endif
@@ -9,19 +9,43 @@
 */
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
 #include <math.h>
 #include "unit.h"
 #include "map.h"
 
-static bool Unit_StartNextStep(Unit *unit);
+static bool Unit_StartNextStep(Unit *unit, Map *map, float dt);
 
+/*
+    Occupancy bits carry no owner, so a unit only sets the bit of a
+    tile it found free, and only clears the bit it set. A unit passing
+    over someone standing still, as smoothed segments can, leaves that
+    unit's tile occupied.
+*/
+static void Unit_ReleaseTile(Unit *unit, Map *map)
+{
+    if (unit->holds_tile)
+        Map_SetOccupied(map, unit->tx, unit->ty, false);
+
+    unit->holds_tile = false;
+}
 
-void Unit_Init(Unit *unit, Map *map, int tx, int ty)
+// claimed: the unit set the tile's bit already, on departure
+static void Unit_EnterTile(Unit *unit, Map *map, int tx, int ty, bool claimed)
 {
     unit->tx = tx;
     unit->ty = ty;
+    unit->holds_tile = claimed || !Map_IsOccupied(map, tx, ty);
 
-    Map_SetOccupied(map, tx, ty, true);
+    if (unit->holds_tile)
+        Map_SetOccupied(map, tx, ty, true);
+}
+
+void Unit_Init(Unit *unit, Map *map, RoutePool *routes, int tx, int ty)
+{
+    unit->target_claimed = false;
+    Unit_EnterTile(unit, map, tx, ty, false);
 
     // Start world position aligned with tile
     unit->wx = tx * TILE_SIZE;
@@ -31,17 +55,96 @@ void Unit_Init(Unit *unit, Map *map, int tx, int ty)
     unit->target_tx = tx;
     unit->target_ty = ty;
 
-    unit->speed = 150.0f;   // Pixels per second
+    unit->speed = UNIT_DEFAULT_SPEED;
     unit->moving = false;
 
-    unit->movement.count = 0;
-    unit->movement.current_index = 0;
+    unit->movement.pool = routes;
+    unit->movement.first_chunk = -1;
+    unit->movement.cursor = Route_Begin(-1, tx, ty);
+
+    unit->flow = NULL;
+    unit->flow_arrive_distance = 0;
+    unit->flow_wait_time = 0.0f;
+
+    unit->path_pending = false;
+    unit->replanner = NULL;
+    unit->abstract_path = NULL;
+    unit->abstract_segment = -1;
+
+    unit->cooperative = NULL;
+    unit->goal_tx = -1;
+    unit->goal_ty = -1;
+    unit->schedule_stale = false;
+    unit->planned_at = -1;
+}
+
+void Unit_ClearPath(Unit *unit)
+{
+    MovementQueue *queue = &unit->movement;
+
+    RoutePool_Release(queue->pool, queue->first_chunk);
+
+    queue->first_chunk = -1;
+    queue->cursor = Route_Begin(-1, unit->tx, unit->ty);
+}
+
+// Stores the moves after the path's first tile, the unit's own
+static void Unit_StoreRoute(Unit *unit, const Path *path, const int *depart)
+{
+    MovementQueue *queue = &unit->movement;
+
+    Unit_ClearPath(unit);
+
+    if (path->length == 0)
+        return;
+
+    queue->first_chunk = RoutePool_Store(queue->pool, path, depart);
+    queue->cursor = Route_Begin(queue->first_chunk, path->tiles[0][0], path->tiles[0][1]);
+}
+
+void Unit_SetPath(Unit *unit, const Path *path)
+{
+    Unit_StoreRoute(unit, path, NULL);
+}
+
+bool Unit_HasQueuedMove(const Unit *unit)
+{
+    return unit->movement.cursor.chunk != -1;
+}
+
+void Unit_SetCooperativeGoal(Unit *unit, int goal_tx, int goal_ty)
+{
+    Unit_ClearPath(unit);
+
+    unit->goal_tx = goal_tx;
+    unit->goal_ty = goal_ty;
+    unit->schedule_stale = true;
+    unit->planned_at = -1;
+}
+
+// Smoothed routes move several tiles at once toward a waypoint
+static bool Unit_OnSegment(const Unit *unit)
+{
+    return abs(unit->target_tx - unit->tx) > 1 || abs(unit->target_ty - unit->ty) > 1;
+}
+
+// Crossing a waypoint segment: hold the tile the unit is over
+static void Unit_TrackTile(Unit *unit, Map *map)
+{
+    int tx = (int)floorf(unit->wx / TILE_SIZE + 0.5f);
+    int ty = (int)floorf(unit->wy / TILE_SIZE + 0.5f);
+
+    if (tx == unit->tx && ty == unit->ty)
+        return;
+
+    Unit_ReleaseTile(unit, map);
+    Unit_EnterTile(unit, map, tx, ty, false);
 }
 
 void Unit_Update(Unit *unit, Map *map, float dt)
 {
     if (!unit->moving)
-        Unit_StartNextStep(unit);
+        Unit_StartNextStep(unit, map, dt);
 
     // if moving, interpolate toward target tile
     float target_wx = unit->target_tx * TILE_SIZE;
@@ -56,7 +159,15 @@ void Unit_Update(Unit *unit, Map *map, float dt)
 
     if (dist > 0.0f)
     {
-        float step = unit->speed * dt;
+        // Crossing into costly terrain is proportionally slower,
+        // matching what the search charged for the step; on a segment,
+        // the terrain under the unit
+        bool segment = Unit_OnSegment(unit);
+        int cost = segment ?
+            Map_GetCost(map, unit->tx, unit->ty) :
+            Map_GetCost(map, unit->target_tx, unit->target_ty);
+        float speed = unit->speed / (float)cost;
+        float step = speed * dt;
 
         if (step >= dist)
         {
@@ -64,16 +175,23 @@ void Unit_Update(Unit *unit, Map *map, float dt)
             unit->wx = target_wx;
             unit->wy = target_wy;
 
-            Map_SetOccupied(map, unit->tx, unit->ty, false);
+            // Cooperative units gave up their tile when they left it
+            Unit_ReleaseTile(unit, map);
+
             // Commit tile position
-            unit->tx = unit->target_tx;
-            unit->ty = unit->target_ty;
-            Map_SetOccupied(map, unit->tx, unit->ty, true);
+            Unit_EnterTile(unit, map, unit->target_tx, unit->target_ty, unit->target_claimed);
+            unit->target_claimed = false;
 
             unit->moving = false;
 
-            // Advance movement queue
-            unit->movement.current_index++;
+            // Advance movement queue (flow fields carry no queue)
+            if (unit->flow == NULL)
+            {
+                Route_Advance(unit->movement.pool, &unit->movement.cursor);
+
+                if (!Unit_HasQueuedMove(unit))
+                    Unit_ClearPath(unit);
+            }
         }
         else
         {
@@ -84,19 +202,258 @@ void Unit_Update(Unit *unit, Map *map, float dt)
             // Move toward target using frame time
             unit->wx += dir_x * step;
             unit->wy += dir_y * step;
+
+            if (segment)
+                Unit_TrackTile(unit, map);
+        }
+    }
+}
+
+static void Unit_StopFollowingFlow(Unit *unit)
+{
+    FlowField_Release(unit->flow);
+    unit->flow = NULL;
+}
+
+// When the field's preferred tile is taken, any other free neighbour
+// that is also closer to the goal works just as well and lets a group
+// spread around the goal instead of queueing in single file.
+static bool Unit_FindFreeFlowStep(const Unit *unit, const Map *map, int *out_tx, int *out_ty)
+{
+    const int offsets[4][2] = { { 0, -1 }, { 1, 0 }, { 0, 1 }, { -1, 0 } };
+    int current = FlowField_GetDistance(unit->flow, unit->tx, unit->ty);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        int nx = unit->tx + offsets[i][0];
+        int ny = unit->ty + offsets[i][1];
+        int distance = FlowField_GetDistance(unit->flow, nx, ny);
+
+        if (distance == FLOW_FIELD_UNREACHABLE || distance >= current)
+            continue;
+
+        if (Map_IsOccupied(map, nx, ny))
+            continue;
+
+        *out_tx = nx;
+        *out_ty = ny;
+        return true;
+    }
+
+    return false;
+}
+
+// Starts movement toward the next tile of the flow field if it is free.
+// Groups share one field, so the target tile is claimed immediately
+// to keep two units from stepping into it during the same move.
+static bool Unit_StartNextFlowStep(Unit *unit, Map *map, float dt)
+{
+    int next_tx;
+    int next_ty;
+
+    if (!FlowField_NextTile(unit->flow, unit->tx, unit->ty, &next_tx, &next_ty))
+    {
+        // At the goal, or the goal became unreachable
+        Unit_StopFollowingFlow(unit);
+        return false;
+    }
+
+    if (Map_IsOccupied(map, next_tx, next_ty) &&
+        !Unit_FindFreeFlowStep(unit, map, &next_tx, &next_ty))
+    {
+        unit->flow_wait_time += dt;
+
+        // Close enough: the rest of the group is packed around the goal.
+        // A long wait means the blocker has settled, so stop there too.
+        if (FlowField_GetDistance(unit->flow, unit->tx, unit->ty) <= unit->flow_arrive_distance ||
+            unit->flow_wait_time >= UNIT_FLOW_GIVE_UP_SECONDS)
+        {
+            Unit_StopFollowingFlow(unit);
+        }
+
+        return false;
+    }
+
+    unit->flow_wait_time = 0.0f;
+
+    Map_SetOccupied(map, next_tx, next_ty, true);
+    unit->target_claimed = true;
+
+    unit->target_tx = next_tx;
+    unit->target_ty = next_ty;
+
+    unit->moving = true;
+
+    return true;
+}
+
+// Repairs the plan from the current tile and reloads the queue.
+// Returns false if no route is open right now; the unit waits and
+// tries again on the next update.
+static bool Unit_RepairPath(Unit *unit, Map *map)
+{
+    Path path;
+
+    if (!Replanner_Replan(unit->replanner, map, unit->tx, unit->ty, &path))
+        return false;
+
+    // The plan leads to the final goal; the abstract route is done with
+    Unit_SetPath(unit, &path);
+    unit->abstract_segment = -1;
+
+    return Unit_HasQueuedMove(unit);
+}
+
+// The reserved part of the queue ends within half a window:
+// time to plan the next one while the unit still has a schedule
+static bool Unit_ScheduleRunningOut(const Unit *unit, int now)
+{
+    const MovementQueue *queue = &unit->movement;
+    RouteCursor cursor = queue->cursor;
+    int last_depart = -1;
+    int tx;
+    int ty;
+    int depart;
+
+    while (Route_Peek(queue->pool, &cursor, &tx, &ty, &depart))
+    {
+        // Everything from here on is past the window
+        if (depart < 0)
+            return last_depart < now + RESERVATION_WINDOW / 2;
+
+        last_depart = depart;
+        Route_Advance(queue->pool, &cursor);
+    }
+
+    return false;
+}
+
+// Plans the next window and reloads the queue with its schedule.
+// Returns false if no route is open right now; the unit holds its
+// tile and tries again on the next clock step.
+static bool Unit_PlanCooperative(Unit *unit, Map *map)
+{
+    ReservationTable *table = unit->cooperative->table;
+    CooperativePath route;
+
+    unit->planned_at = table->now;
+    unit->schedule_stale = false;
+
+    Unit_ClearPath(unit);
+
+    if (!Cooperative_FindPath(
+            unit->cooperative, map, unit->id,
+            unit->tx, unit->ty, unit->goal_tx, unit->goal_ty, &route))
+    {
+        unit->schedule_stale = true;
+        return false;
+    }
+
+    Unit_StoreRoute(unit, &route.path, route.depart);
+
+    return true;
+}
+
+/*
+    Cooperative units move on the reservation clock: a step starts no
+    earlier than its reserved departure, and a unit that falls more
+    than RESERVATION_SLACK steps behind drops its claims and plans
+    again instead of walking into someone else's slot.
+    Claims behind the unit simply expire as the clock passes them.
+
+    Like flow steps, the target tile is occupied from departure; the
+    tile left behind is freed at the same time.
+*/
+static bool Unit_StartNextCooperativeStep(Unit *unit, Map *map)
+{
+    ReservationTable *table = unit->cooperative->table;
+    int now = table->now;
+    bool at_goal = unit->tx == unit->goal_tx && unit->ty == unit->goal_ty;
+
+    if (unit->goal_tx >= 0 && !at_goal && unit->planned_at != now &&
+        (unit->schedule_stale || Unit_ScheduleRunningOut(unit, now)))
+    {
+        Unit_PlanCooperative(unit, map);
+    }
+
+    MovementQueue *queue = &unit->movement;
+    int next_tx;
+    int next_ty;
+    int depart;
+
+    if (!Route_Peek(queue->pool, &queue->cursor, &next_tx, &next_ty, &depart))
+    {
+        // At rest: keep the tile claimed so others plan around it
+        if (at_goal)
+        {
+            unit->goal_tx = -1;
+            unit->goal_ty = -1;
         }
+
+        ReservationTable_Hold(table, unit->tx, unit->ty, unit->id);
+        return false;
+    }
+
+    // Past the window, or early: wait for the schedule
+    if (depart < 0 || now < depart)
+        return false;
+
+    // Too far behind: the reserved slots have passed, plan again
+    if (now > depart + RESERVATION_SLACK ||
+        !Map_IsWalkable(map, next_tx, next_ty))
+    {
+        unit->schedule_stale = true;
+        return false;
     }
+
+    // Someone outside the schedule is there; wait within slack
+    if (Map_IsOccupied(map, next_tx, next_ty))
+        return false;
+
+    // Hand the tile over on departure so a unit following one tile
+    // behind can keep to the same schedule
+    Unit_ReleaseTile(unit, map);
+    Map_SetOccupied(map, next_tx, next_ty, true);
+    unit->target_claimed = true;
+
+    unit->target_tx = next_tx;
+    unit->target_ty = next_ty;
+
+    unit->moving = true;
+
+    return true;
 }
 
 // Starts movement toward the next tile in the queue if available
 // Returns true if movement started, false otherwise
-static bool Unit_StartNextStep(Unit *unit)
+static bool Unit_StartNextStep(Unit *unit, Map *map, float dt)
 {
-    if (unit->movement.current_index >= unit->movement.count)
+    if (unit->flow)
+        return Unit_StartNextFlowStep(unit, map, dt);
+
+    if (unit->cooperative)
+        return Unit_StartNextCooperativeStep(unit, map);
+
+    // Nothing to follow until the scheduler delivers the path
+    if (unit->path_pending)
         return false;
 
-    int next_tx = unit->movement.tiles[unit->movement.current_index][0];
-    int next_ty = unit->movement.tiles[unit->movement.current_index][1];
+    MovementQueue *queue = &unit->movement;
+    int next_tx;
+    int next_ty;
+    int depart;
+
+    if (!Route_Peek(queue->pool, &queue->cursor, &next_tx, &next_ty, &depart))
+        return false;
+
+    if (unit->replanner &&
+        (!Map_IsWalkable(map, next_tx, next_ty) || Map_IsOccupied(map, next_tx, next_ty)))
+    {
+        if (!Unit_RepairPath(unit, map))
+            return false;
+
+        Route_Peek(queue->pool, &queue->cursor, &next_tx, &next_ty, &depart);
+    }
 
     unit->target_tx = next_tx;
     unit->target_ty = next_ty;
@@ -2,19 +2,36 @@
 #define UNIT_H
 
 #include "map.h"
+#include "cluster.h"
+#include "flowfield.h"
+#include "pathfinding.h"
+#include "replan.h"
+#include "reservation.h"
+#include "route.h"
 #include "../game/constants.h"
 
+// A flow-following unit blocked this long stops where it is
+#define UNIT_FLOW_GIVE_UP_SECONDS 1.0f
 
+// Pixels per second set by Unit_Init
+#define UNIT_DEFAULT_SPEED 150.0f
+
+/*
+Route the unit follows, stored in a shared RoutePool: steps along
+adjacent tiles, or waypoints of a smoothed route the unit walks to in
+a straight line. Cooperative routes carry the reserved step at which
+each move may start.
+*/
 typedef struct
 {
-	// Array of tile coordinates [tx, ty]
-	int tiles[MAX_PATH_LENGTH][2];
+	// Pool holding the route; not owned by the unit
+	RoutePool *pool;
 
-	// Number of valid tiles stored in the queue
-	int count;
+	// First chunk of the route, -1 when the queue is empty
+	int first_chunk;
 
-	// Index of the next tile unit should move toward
-	int current_index;
+	// Next move along the route
+	RouteCursor cursor;
 } MovementQueue;
 
 
@@ -33,7 +50,14 @@ typedef struct {
 	int target_tx;
 	int target_ty;
 
+	// The unit set the occupancy bit of its tile, and of the target
+	// tile when claimed on departure. A tile someone else already
+	// held is crossed without touching its bit.
+	bool holds_tile;
+	bool target_claimed;
+
 	// Movement properties
+	// Pixels per second on cost-1 terrain, divided by the cost of the tile entered
 	float speed;
 	// Indicates wheter the unit is currently interpolating toward a tile
 	bool moving;
@@ -41,9 +65,66 @@ typedef struct {
 	// MovementQueue containing future tile steps
 	MovementQueue movement;
 
+	// Shared flow field followed instead of the queue, NULL if none.
+	// The unit holds one reference and releases it on arrival.
+	FlowField *flow;
+
+	// Flow field cost from the goal at which a blocked unit counts as
+	// arrived, so a group settles around the goal instead of queueing for it
+	int flow_arrive_distance;
+
+	// Seconds spent blocked while following the flow field
+	float flow_wait_time;
+
+	// A move order is waiting for its search to complete
+	bool path_pending;
+
+	// Incremental planner repairing the queue when its next tile is
+	// blocked. NULL keeps the plain queue. Not owned by the unit.
+	Replanner *replanner;
+
+	// Room for an abstract route through the scheduler's cluster graph;
+	// long orders then search one sector segment at a time. NULL keeps
+	// whole-route searches. Not owned by the unit.
+	ClusterPath *abstract_path;
+
+	// Segment of abstract_path being walked, -1 when there is none
+	int abstract_segment;
+
+	// Windowed cooperative planner shared with other units: the unit
+	// reserves its route and keeps to the schedule. NULL keeps the
+	// plain queue. Not owned by the unit; id must be unique among the
+	// units sharing it.
+	CooperativeSearch *cooperative;
+
+	// Final tile of the cooperative order, -1 when there is none
+	int goal_tx;
+	int goal_ty;
+
+	// The reserved schedule no longer holds; plan again before moving
+	bool schedule_stale;
+
+	// Clock step of the last cooperative plan, to retry failures once per step
+	int planned_at;
+
 } Unit;
 
-void Unit_Init(Unit *unit, Map *map, int tx, int ty);
+// routes stores the unit's movement queue; it is shared by every unit
+void Unit_Init(Unit *unit, Map *map, RoutePool *routes, int tx, int ty);
 void Unit_Update(Unit *unit, Map *map, float dt);
 
+// Replaces the movement queue with a path starting at the unit's tile.
+// A path the pool has no room for is cut short.
+void Unit_SetPath(Unit *unit, const Path *path);
+
+// Empties the movement queue and returns its storage to the pool
+void Unit_ClearPath(Unit *unit);
+
+// True while the queue holds a move not yet started
+bool Unit_HasQueuedMove(const Unit *unit);
+
+// Gives a cooperative unit a new goal; the route is planned, in unit
+// update order, on its next Unit_Update
+void Unit_SetCooperativeGoal(Unit *unit, int goal_tx, int goal_ty);
+
 #endif
@@ -1,8 +1,14 @@
 // Maximum number of tiles a unit can have in its movement queue
 // Fixed-size to avoid dynamic allocation at this stage
+#ifndef MAX_PATH_LENGTH
 #define MAX_PATH_LENGTH 128
+#endif
 
-// Map properties
+// Size of the map the game creates; Map_Init takes any size at runtime
+#ifndef MAP_WIDTH
 #define MAP_WIDTH 20
+#endif
+#ifndef MAP_HEIGHT
 #define MAP_HEIGHT 15
+#endif
 #define TILE_SIZE 32
@@ -1,3 +1,5 @@
+#include <stddef.h>
+#include "raylib.h"
 #include "../core/gamestate.h"
 #include "../input/input.h"
 #include "../render/render.h"
@@ -18,10 +20,73 @@
 
 void Game_Init(GameState *game)
 {
-    Map_Init(&game->map);
+    if (!Map_Init(&game->map, MAP_WIDTH, MAP_HEIGHT))
+    {
+        TraceLog(LOG_FATAL, "Failed to allocate map");
+    }
+
+    // Every search structure is sized for the map it serves
+    int tile_count = Map_TileCount(&game->map);
+
+    if (!PathContext_Init(&game->path_context, tile_count))
+    {
+        TraceLog(LOG_FATAL, "Failed to allocate pathfinding context");
+    }
+
+    PathStats_Init(&game->path_stats);
+    game->path_context.stats = &game->path_stats;
+
+    if (!ClusterGraph_Init(&game->clusters, &game->map))
+    {
+        TraceLog(LOG_FATAL, "Failed to allocate cluster graph");
+    }
+
+    Map_ChangeReaderInit(&game->map, &game->cluster_changes);
+
+    PathCache_Init(&game->path_cache);
+    PathScheduler_Init(
+        &game->path_scheduler,
+        &game->path_context,
+        &game->path_cache,
+        PATH_SCHEDULER_DEFAULT_BUDGET
+    );
+    game->path_scheduler.heuristic = PATH_HEURISTIC_LANDMARKS;
+    game->path_scheduler.connectivity = PATH_CONNECTIVITY_8;
+    game->path_scheduler.smooth = true;
+    game->path_scheduler.clusters = &game->clusters;
+
+    if (!FlowFieldCache_Init(&game->flow_cache, tile_count))
+    {
+        TraceLog(LOG_FATAL, "Failed to allocate flow field cache");
+    }
+
+    if (!Replanner_Init(&game->player_replanner, game->map.width, game->map.height))
+    {
+        TraceLog(LOG_FATAL, "Failed to allocate replanner");
+    }
+
+    // One reservation step is one tile crossed at the default speed
+    if (!ReservationTable_Init(&game->reservations, game->map.width, game->map.height,
+            TILE_SIZE / UNIT_DEFAULT_SPEED))
+    {
+        TraceLog(LOG_FATAL, "Failed to allocate reservation table");
+    }
+
+    if (!CooperativeSearch_Init(&game->cooperative_search, &game->reservations))
+    {
+        TraceLog(LOG_FATAL, "Failed to allocate cooperative search");
+    }
+
+    if (!RoutePool_Init(&game->routes, ROUTE_POOL_DEFAULT_CHUNKS))
+    {
+        TraceLog(LOG_FATAL, "Failed to allocate route pool");
+    }
 
     // Create single test unit in middle of map
-    Unit_Init(&game->player_unit, &game->map, 5, 5);
+    Unit_Init(&game->player_unit, &game->map, &game->routes, 5, 5);
+    game->player_unit.id = 1;
+    game->player_unit.replanner = &game->player_replanner;
+    game->player_unit.abstract_path = &game->player_abstract_path;
 
     // Just for testing, injecting path manually
     // game->player_unit.movement.tiles[0][0] = 5;
@@ -37,7 +102,11 @@ void Game_Init(GameState *game)
     game->time = 0.0f;
 
     game->debug_draw_pathfinding = false;
-    game->debug_last_path = (Path){0};
+
+    if (!PathDebug_Init(&game->debug_last_search, tile_count))
+    {
+        TraceLog(LOG_FATAL, "Failed to allocate pathfinding trace");
+    }
 }
 
 void Game_ProcessInput(GameState *game)
@@ -51,18 +120,46 @@ void Game_Update(GameState *game, float dt)
     // Advance global time
     game->time += dt;
 
+    // Per-second search counters roll over on the game clock
+    PathStats_Update(&game->path_stats, dt);
+
+    // Last tick's edits become readable in the map's change log
+    Map_PublishChanges(&game->map);
+
+    // Sectors touched by terrain edits are rebuilt on the next long order
+    ClusterGraph_ApplyMapChanges(&game->clusters, &game->map, &game->cluster_changes);
+
+    // Fields units are following catch up with terrain edits
+    FlowFieldCache_Invalidate(&game->flow_cache, &game->map);
+
+    // Region labels must be current before any search this tick
+    Map_UpdateComponents(&game->map);
+
+    // Landmark tables catch up a slice at a time after terrain edits
+    Map_UpdateLandmarks(&game->map, MAP_LANDMARK_BUDGET);
+
     if (game->input.has_move_order)
     {
         Command_MoveUnit(
             &game->player_unit,
             &game->map,
+            &game->path_scheduler,
             game->input.move_tx,
             game->input.move_ty,
-            &game->debug_last_path
+            game->debug_draw_pathfinding ? &game->debug_last_search : NULL
         );
         game->input.has_move_order = false;
     }
 
+    // A unit done with one segment of a long order queues the next
+    PathScheduler_Continue(&game->path_scheduler, &game->map, &game->player_unit);
+
+    // Searches run under a per-tick budget; units wait until theirs completes
+    PathScheduler_Update(&game->path_scheduler, &game->map);
+
+    // Claims for steps that have passed expire as the clock moves on
+    ReservationTable_Advance(&game->reservations, dt);
+
     // Update simulation objects
     Unit_Update(&game->player_unit, &game->map, dt);
 }
@@ -74,3 +171,16 @@ void Game_Render(GameState *game)
 
     Render_DrawPathDebug(game);
 }
+
+void Game_Shutdown(GameState *game)
+{
+    PathContext_Free(&game->path_context);
+    FlowFieldCache_Free(&game->flow_cache);
+    ClusterGraph_Free(&game->clusters);
+    Replanner_Free(&game->player_replanner);
+    CooperativeSearch_Free(&game->cooperative_search);
+    ReservationTable_Free(&game->reservations);
+    RoutePool_Free(&game->routes);
+    PathDebug_Free(&game->debug_last_search);
+    Map_Free(&game->map);
+}
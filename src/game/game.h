@@ -7,5 +7,6 @@ void Game_Init(GameState *game);
 void Game_ProcessInput(GameState *game);
 void Game_Update(GameState *game, float dt);
 void Game_Render(GameState *game);
+void Game_Shutdown(GameState *game);
 
 #endif
@@ -3,6 +3,7 @@
 #include "../core/command.h"
 #include "../core/gamestate.h"
 #include "../core/coords.h"
+#include "../core/trace.h"
 
 
 /*
@@ -30,5 +31,12 @@ void Input_Process(GameState *game)
     if (IsKeyPressed(KEY_F1))
     {
         game->debug_draw_pathfinding = !game->debug_draw_pathfinding;
+
+        // Trace is not recorded while hidden, drop whatever is left
+        PathDebug_Clear(&game->debug_last_search);
     }
+
+    // Recent path queries and orders, decoded on demand
+    if (IsKeyPressed(KEY_F2))
+        Trace_Dump(stdout);
 }
@@ -20,9 +20,13 @@
 
 int main(void)
 {
+    // Entire simulation state lives here.
+    GameState game;
+    Game_Init(&game);
+
     // Window size derived from map dimensions.
-    const int screenWidth  = MAP_WIDTH * TILE_SIZE;
-    const int screenHeight = MAP_HEIGHT * TILE_SIZE;
+    const int screenWidth  = game.map.width * TILE_SIZE;
+    const int screenHeight = game.map.height * TILE_SIZE;
 
     SetConfigFlags(FLAG_WINDOW_HIGHDPI | FLAG_VSYNC_HINT);
 
@@ -31,10 +35,6 @@ int main(void)
     // printf("Render: %d x %d\n", GetRenderWidth(), GetRenderHeight());
     // printf("Monitor: %d x %d\n", GetMonitorWidth(0), GetMonitorHeight(0));
 
-    // Entire simulation state lives here.
-    GameState game;
-    Game_Init(&game);
-
     SetTargetFPS(60);
 
     while (!WindowShouldClose())
@@ -52,6 +52,8 @@ int main(void)
         EndDrawing();
     }
 
+    Game_Shutdown(&game);
+
     CloseWindow();
     return 0;
 }
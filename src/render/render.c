@@ -13,6 +13,7 @@
 #include "../core/coords.h"
 
 static void RenderTileCoordinates(int tx, int ty, int wx, int wy, int tile_size);
+static void RenderPathStats(const PathStats *stats);
 
 
 void Render_Draw(GameState *game)
@@ -20,9 +21,9 @@ void Render_Draw(GameState *game)
     bool render_debug_show_coordinates = true;
 
     // Draw tile grid
-    for (int y = 0; y < MAP_HEIGHT; y++)
+    for (int y = 0; y < game->map.height; y++)
     {
-        for (int x = 0; x < MAP_WIDTH; x++)
+        for (int x = 0; x < game->map.width; x++)
         {
             int world_x = x * TILE_SIZE;
             int world_y = y * TILE_SIZE;
@@ -74,17 +75,17 @@ void Render_DrawPathDebug(const GameState *game)
     if (!game->debug_draw_pathfinding)
         return;
 
-    const Path *path = &game->debug_last_path;
+    const PathDebug *debug = &game->debug_last_search;
 
-    for (int ty = 0; ty < MAP_HEIGHT; ++ty)
+    for (int ty = 0; ty < game->map.height; ++ty)
     {
-        for (int tx = 0; tx < MAP_WIDTH; ++tx)
+        for (int tx = 0; tx < game->map.width; ++tx)
         {
-            int index = ty * MAP_WIDTH + tx;
+            int index = Map_Index(&game->map, tx, ty);
 
             Vector2 pos = Map_TileToWorld(tx, ty);
 
-            if (path->debug_closed[index])
+            if (debug->closed[index])
             {
                 DrawRectangle(
                     pos.x,
@@ -95,7 +96,7 @@ void Render_DrawPathDebug(const GameState *game)
                 );
             }
 
-            if (path->debug_open[index])
+            if (debug->open[index])
             {
                 DrawRectangle(
                     pos.x,
@@ -106,7 +107,7 @@ void Render_DrawPathDebug(const GameState *game)
                 );
             }
 
-            if (path->debug_in_path[index])
+            if (debug->in_path[index])
             {
                 DrawRectangle(
                     pos.x,
@@ -118,4 +119,24 @@ void Render_DrawPathDebug(const GameState *game)
             }
         }
     }
+
+    RenderPathStats(&game->path_stats);
+}
+
+// Search counters of the last full second and latency percentiles
+static void RenderPathStats(const PathStats *stats)
+{
+    char buffer[128];
+    const PathStatsCounters *second = &stats->last_second;
+
+    snprintf(buffer, sizeof(buffer), "paths/s %d (failed %d)  expanded/s %lld  opened/s %lld",
+        second->searches, second->failed, second->expansions, second->opened);
+    DrawText(buffer, 8, 8, 16, PALETTE_SELECTION);
+
+    snprintf(buffer, sizeof(buffer), "search p50 %.1f us  p99 %.1f us  max %.1f us  peak open %d",
+        PathStats_Percentile(stats, 50.0) / 1000.0,
+        PathStats_Percentile(stats, 99.0) / 1000.0,
+        stats->max_ns / 1000.0,
+        stats->peak_open);
+    DrawText(buffer, 8, 28, 16, PALETTE_SELECTION);
 }
@@ -7,25 +7,66 @@
 
 #include <stdio.h>
 #include <assert.h>
+#include <limits.h>
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
 
 #include "../src/core/map.h"
+#include "../src/core/mapfile.h"
 #include "../src/core/pathfinding.h"
+#include "../src/core/cluster.h"
+#include "../src/core/flowfield.h"
+#include "../src/core/pathcache.h"
+#include "../src/core/replan.h"
+#include "../src/core/pathpool.h"
+#include "../src/core/pathsched.h"
+#include "../src/core/reservation.h"
+#include "../src/core/trace.h"
+#include "../src/core/pathstats.h"
+#include "../src/core/unit.h"
+
+// Tiles of the default-size maps most tests run on
+#define TEST_NODE_COUNT (MAP_WIDTH * MAP_HEIGHT)
+
+// Shared search scratch, reused by every test like the game does
+static PathContext test_ctx;
+static RoutePool test_routes;
 
 /*
-    Helper: make entire map walkable and empty.
+    Helper: make entire map walkable and empty, at the default size.
+    Maps are static, so the previous storage is released first.
 */
 static void make_empty_map(Map *map)
 {
-    Map_Init(map);
+    Map_Free(map);
 
-    for (int y = 0; y < MAP_HEIGHT; y++)
+    bool map_ready = Map_Init(map, MAP_WIDTH, MAP_HEIGHT);
+    assert(map_ready);
+}
+
+/*
+    Helper: decode the moves left in a unit's queue into out.
+    Returns how many.
+*/
+static int queued_tiles(const Unit *unit, int out[][2])
+{
+    RouteCursor cursor = unit->movement.cursor;
+    int count = 0;
+    int tx;
+    int ty;
+    int depart;
+
+    while (Route_Peek(unit->movement.pool, &cursor, &tx, &ty, &depart))
     {
-        for (int x = 0; x < MAP_WIDTH; x++)
-        {
-            map->tiles[y][x].walkable = 1;
-            map->tiles[y][x].occupied = 0;
-        }
+        out[count][0] = tx;
+        out[count][1] = ty;
+        count++;
+
+        Route_Advance(unit->movement.pool, &cursor);
     }
+
+    return count;
 }
 
 /*
@@ -33,15 +74,17 @@ static void make_empty_map(Map *map)
 */
 static void test_straight_path(void)
 {
-    Map map;
+    static Map map;
     make_empty_map(&map);
 
     Path path;
 
     bool found = Pathfinding_FindPath(
+        &test_ctx,
         &map,
         0, 0,
         3, 0,
+        NULL,
         &path
     );
 
@@ -63,17 +106,19 @@ static void test_straight_path(void)
 */
 static void test_blocked_goal(void)
 {
-    Map map;
+    static Map map;
     make_empty_map(&map);
 
-    map.tiles[0][3].walkable = 0;
+    Map_SetWalkable(&map, 3, 0, false);
 
     Path path;
 
     bool found = Pathfinding_FindPath(
+        &test_ctx,
         &map,
         0, 0,
         3, 0,
+        NULL,
         &path
     );
 
@@ -85,15 +130,17 @@ static void test_blocked_goal(void)
 */
 static void test_same_tile(void)
 {
-    Map map;
+    static Map map;
     make_empty_map(&map);
 
     Path path;
 
     bool found = Pathfinding_FindPath(
+        &test_ctx,
         &map,
         5, 5,
         5, 5,
+        NULL,
         &path
     );
 
@@ -103,13 +150,3068 @@ static void test_same_tile(void)
     assert(path.tiles[0][1] == 5);
 }
 
-int main(void)
+/*
+    Helper: deterministic pseudo-random obstacle map.
+    Uses a fixed LCG so every run sees the same layout.
+*/
+static void make_random_map(Map *map, unsigned int seed, int blocked_percent)
 {
-    printf("Running pathfinding tests...\n");
+    make_empty_map(map);
 
-    test_straight_path();
-    test_blocked_goal();
-    test_same_tile();
+    unsigned int state = seed;
+
+    for (int y = 0; y < MAP_HEIGHT; y++)
+    {
+        for (int x = 0; x < MAP_WIDTH; x++)
+        {
+            state = state * 1103515245u + 12345u;
+
+            if ((int)((state >> 16) % 100) < blocked_percent)
+                Map_SetWalkable(map, x, y, false);
+        }
+    }
+}
+
+/*
+    Test 4: heap and linear-scan open sets produce identical paths
+*/
+static void test_open_sets_match(void)
+{
+    PathOptions heap_options = { .open_set = PATH_OPEN_SET_BINARY_HEAP };
+    PathOptions scan_options = { .open_set = PATH_OPEN_SET_LINEAR_SCAN };
+
+    for (unsigned int seed = 1; seed <= 20; ++seed)
+    {
+        static Map map;
+        make_random_map(&map, seed, 25);
+        Map_SetWalkable(&map, 0, 0, true);
+
+        int goal_tx = MAP_WIDTH - 1;
+        int goal_ty = MAP_HEIGHT - 1;
+
+        static Path heap_path;
+        static Path scan_path;
+
+        bool heap_found = Pathfinding_FindPath(
+            &test_ctx, &map, 0, 0, goal_tx, goal_ty, &heap_options, &heap_path);
+        bool scan_found = Pathfinding_FindPath(
+            &test_ctx, &map, 0, 0, goal_tx, goal_ty, &scan_options, &scan_path);
+
+        assert(heap_found == scan_found);
+        assert(heap_path.length == scan_path.length);
+
+        for (int i = 0; i < heap_path.length; ++i)
+        {
+            assert(heap_path.tiles[i][0] == scan_path.tiles[i][0]);
+            assert(heap_path.tiles[i][1] == scan_path.tiles[i][1]);
+        }
+    }
+}
+
+/*
+    Test 5: stale nodes from an earlier search do not leak into the next one,
+    including across a generation counter wrap-around
+*/
+static void test_context_reuse(void)
+{
+    static Map map;
+    make_empty_map(&map);
+
+    // Wall with a single gap forces a detour in the first search
+    for (int y = 0; y < MAP_HEIGHT - 1; y++)
+        Map_SetWalkable(&map, 4, y, false);
+
+    Path path;
+
+    bool found = Pathfinding_FindPath(&test_ctx, &map, 0, 0, 8, 0, NULL, &path);
+    assert(found == true);
+    assert(path.length == 2 * (MAP_HEIGHT - 1) + 9);
+
+    test_ctx.generation = UINT_MAX;
+
+    for (int round = 0; round < 2; ++round)
+    {
+        make_empty_map(&map);
+
+        found = Pathfinding_FindPath(&test_ctx, &map, 0, 0, 8, 0, NULL, &path);
+        assert(found == true);
+        assert(path.length == 9);
+    }
+}
+
+/*
+    Test 6: debug sink receives the search trace only when supplied
+*/
+static void test_debug_sink(void)
+{
+    static Map map;
+    make_empty_map(&map);
+
+    static PathDebug debug;
+    bool debug_ready = PathDebug_Init(&debug, TEST_NODE_COUNT);
+    assert(debug_ready);
+
+    PathOptions options = { .debug = &debug };
+    Path path;
+
+    bool found = Pathfinding_FindPath(&test_ctx, &map, 0, 0, 3, 2, &options, &path);
+    assert(found == true);
+
+    int in_path_count = 0;
+    for (int i = 0; i < TEST_NODE_COUNT; ++i)
+        in_path_count += debug.in_path[i];
+
+    assert(in_path_count == path.length);
+    assert(debug.closed[0] == true);
+
+    // Failed query clears the previous trace
+    Map_SetWalkable(&map, 3, 2, false);
+    found = Pathfinding_FindPath(&test_ctx, &map, 0, 0, 3, 2, &options, &path);
+    assert(found == false);
+    assert(debug.in_path[0] == false);
+    assert(debug.closed[0] == false);
+
+    PathDebug_Free(&debug);
+}
+
+/*
+    Helper: path is a contiguous chain of passable 4-neighbour steps.
+*/
+static void assert_path_valid(const Map *map, const Path *path)
+{
+    for (int i = 1; i < path->length; ++i)
+    {
+        int dx = path->tiles[i][0] - path->tiles[i - 1][0];
+        int dy = path->tiles[i][1] - path->tiles[i - 1][1];
+
+        assert((dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy) == 1);
+        assert(Map_IsWalkable(map, path->tiles[i][0], path->tiles[i][1]));
+        assert(!Map_IsOccupied(map, path->tiles[i][0], path->tiles[i][1]));
+    }
+}
+
+/*
+    Helper: cost of a 4-connected path, charging each tile entered
+*/
+static int terrain_path_cost(const Map *map, const Path *path)
+{
+    int cost = 0;
+
+    for (int i = 1; i < path->length; ++i)
+        cost += Map_GetCost(map, path->tiles[i][0], path->tiles[i][1]);
+
+    return cost;
+}
+
+/*
+    Test 7: JPS finds paths of the same length as A*
+*/
+static void test_jps_matches_astar(void)
+{
+    PathOptions astar_options = { .algorithm = PATH_ALGORITHM_ASTAR };
+    PathOptions jps_options = { .algorithm = PATH_ALGORITHM_JPS };
+
+    for (unsigned int seed = 1; seed <= 60; ++seed)
+    {
+        static Map map;
+        make_random_map(&map, seed, (int)(seed % 4) * 10);
+        Map_SetOccupied(&map, 2, 1, true);
+
+        int start_tx = (int)(seed % MAP_WIDTH);
+        int start_ty = (int)(seed % MAP_HEIGHT);
+        int goal_tx = MAP_WIDTH - 1 - start_tx;
+        int goal_ty = MAP_HEIGHT - 1 - (int)((seed * 7) % MAP_HEIGHT);
+
+        static Path astar_path;
+        static Path jps_path;
+
+        bool astar_found = Pathfinding_FindPath(
+            &test_ctx, &map, start_tx, start_ty, goal_tx, goal_ty, &astar_options, &astar_path);
+        bool jps_found = Pathfinding_FindPath(
+            &test_ctx, &map, start_tx, start_ty, goal_tx, goal_ty, &jps_options, &jps_path);
+
+        assert(astar_found == jps_found);
+        assert(astar_path.length == jps_path.length);
+
+        if (!jps_found)
+            continue;
+
+        assert_path_valid(&map, &jps_path);
+        assert(jps_path.tiles[0][0] == start_tx);
+        assert(jps_path.tiles[0][1] == start_ty);
+        assert(jps_path.tiles[jps_path.length - 1][0] == goal_tx);
+        assert(jps_path.tiles[jps_path.length - 1][1] == goal_ty);
+    }
+}
+
+/*
+    Test 8: hierarchical search agrees with A* on reachability,
+    and refined segments chain into a valid route; a segment units
+    have walled off fails within its expansion budget
+*/
+static void test_cluster_matches_astar(void)
+{
+    for (unsigned int seed = 1; seed <= 40; ++seed)
+    {
+        static Map map;
+        make_random_map(&map, seed, (int)(seed % 4) * 10);
+
+        int start_tx = (int)(seed % MAP_WIDTH);
+        int start_ty = (int)(seed % MAP_HEIGHT);
+        int goal_tx = MAP_WIDTH - 1 - start_tx;
+        int goal_ty = MAP_HEIGHT - 1 - (int)((seed * 7) % MAP_HEIGHT);
+        Map_SetWalkable(&map, start_tx, start_ty, true);
+
+        static ClusterGraph graph;
+        static ClusterPath abstract_path;
+        static Path astar_path;
+        static Path segment_path;
+
+        bool graph_ready = ClusterGraph_Init(&graph, &map);
+        assert(graph_ready);
+
+        bool astar_found = Pathfinding_FindPath(
+            &test_ctx, &map, start_tx, start_ty, goal_tx, goal_ty, NULL, &astar_path);
+        bool hpa_found = ClusterGraph_FindPath(
+            &graph, &map, start_tx, start_ty, goal_tx, goal_ty, &abstract_path);
+
+        assert(astar_found == hpa_found);
+
+        if (hpa_found)
+        {
+            int steps = 0;
+
+            assert(abstract_path.waypoints[0][0] == start_tx);
+            assert(abstract_path.waypoints[0][1] == start_ty);
+
+            for (int i = 0; i + 1 < abstract_path.count; ++i)
+            {
+                bool refined = ClusterGraph_RefineSegment(
+                    &test_ctx, &map, &abstract_path, i, &segment_path);
+
+                assert(refined);
+                assert_path_valid(&map, &segment_path);
+                steps += segment_path.length - 1;
+            }
+
+            assert(abstract_path.waypoints[abstract_path.count - 1][0] == goal_tx);
+            assert(abstract_path.waypoints[abstract_path.count - 1][1] == goal_ty);
+            assert(steps >= astar_path.length - 1);
+        }
+
+        ClusterGraph_Free(&graph);
+    }
+
+    // Units walling in a waypoint fail the segment within its budget
+    // instead of flooding the map
+    static Map big_map;
+    static PathContext big_ctx;
+    static ClusterPath walled;
+    static Path segment_path;
+
+    bool map_ready = Map_Init(&big_map, 64, 64);
+    assert(map_ready);
+    bool ctx_ready = PathContext_Init(&big_ctx, 64 * 64);
+    assert(ctx_ready);
+
+    walled.count = 2;
+    walled.waypoints[0][0] = 0;
+    walled.waypoints[0][1] = 0;
+    walled.waypoints[1][0] = CLUSTER_SIZE - 1;
+    walled.waypoints[1][1] = CLUSTER_SIZE - 1;
+
+    bool refined = ClusterGraph_RefineSegment(&big_ctx, &big_map, &walled, 0, &segment_path);
+    assert(refined);
+
+    Map_SetOccupied(&big_map, CLUSTER_SIZE - 2, CLUSTER_SIZE - 1, true);
+    Map_SetOccupied(&big_map, CLUSTER_SIZE, CLUSTER_SIZE - 1, true);
+    Map_SetOccupied(&big_map, CLUSTER_SIZE - 1, CLUSTER_SIZE - 2, true);
+    Map_SetOccupied(&big_map, CLUSTER_SIZE - 1, CLUSTER_SIZE, true);
+
+    refined = ClusterGraph_RefineSegment(&big_ctx, &big_map, &walled, 0, &segment_path);
+    assert(!refined);
+    assert(big_ctx.expansions <= CLUSTER_REFINE_BUDGET);
+
+    PathContext_Free(&big_ctx);
+    Map_Free(&big_map);
+}
+
+/*
+    Test 9: walkability edits are picked up after marking tiles dirty;
+    abstract routes price terrain like the tile search, and cost edits
+    read from the change log re-price the sectors
+*/
+static void test_cluster_incremental_update(void)
+{
+    static Map map;
+    make_empty_map(&map);
+
+    static ClusterGraph graph;
+    static ClusterPath abstract_path;
+
+    bool graph_ready = ClusterGraph_Init(&graph, &map);
+    assert(graph_ready);
+
+    bool found = ClusterGraph_FindPath(&graph, &map, 0, 0, MAP_WIDTH - 1, 0, &abstract_path);
+    assert(found == true);
+
+    // Full-height wall on a sector border cuts the map in two
+    for (int y = 0; y < MAP_HEIGHT; y++)
+    {
+        Map_SetWalkable(&map, CLUSTER_SIZE, y, false);
+        ClusterGraph_MarkTileDirty(&graph, CLUSTER_SIZE, y);
+    }
+
+    found = ClusterGraph_FindPath(&graph, &map, 0, 0, MAP_WIDTH - 1, 0, &abstract_path);
+    assert(found == false);
+
+    Map_SetWalkable(&map, CLUSTER_SIZE, 3, true);
+    ClusterGraph_MarkTileDirty(&graph, CLUSTER_SIZE, 3);
+
+    found = ClusterGraph_FindPath(&graph, &map, 0, 0, MAP_WIDTH - 1, 0, &abstract_path);
+    assert(found == true);
+
+    ClusterGraph_Free(&graph);
+
+    // Swamp across the middle, road along the bottom rows: the road
+    // is longer in tiles and cheaper
+    make_empty_map(&map);
+
+    for (int y = 0; y < MAP_HEIGHT - 2; y++)
+        for (int x = 6; x <= 13; x++)
+            Map_SetCost(&map, x, y, MAP_COST_SWAMP);
+
+    graph_ready = ClusterGraph_Init(&graph, &map);
+    assert(graph_ready);
+
+    MapChangeReader reader;
+    Map_ChangeReaderInit(&map, &reader);
+
+    static Path segment_path;
+    int lowest_row = 0;
+
+    found = ClusterGraph_FindPath(&graph, &map, 0, 4, MAP_WIDTH - 1, 4, &abstract_path);
+    assert(found);
+
+    for (int i = 0; i + 1 < abstract_path.count; ++i)
+    {
+        bool refined = ClusterGraph_RefineSegment(&test_ctx, &map, &abstract_path, i, &segment_path);
+        assert(refined);
+
+        for (int t = 0; t < segment_path.length; ++t)
+        {
+            assert(Map_GetCost(&map, segment_path.tiles[t][0], segment_path.tiles[t][1]) == MAP_TILE_COST_MIN);
+
+            if (segment_path.tiles[t][1] > lowest_row)
+                lowest_row = segment_path.tiles[t][1];
+        }
+    }
+
+    assert(lowest_row >= MAP_HEIGHT - 2);
+
+    // Turning the road to swamp too makes the straight route cheapest;
+    // the graph hears of it through the change log
+    for (int y = MAP_HEIGHT - 2; y < MAP_HEIGHT; y++)
+        for (int x = 6; x <= 13; x++)
+            Map_SetCost(&map, x, y, MAP_COST_SWAMP);
+
+    Map_PublishChanges(&map);
+    ClusterGraph_ApplyMapChanges(&graph, &map, &reader);
+    assert(graph.dirty_count > 0);
+
+    found = ClusterGraph_FindPath(&graph, &map, 0, 4, MAP_WIDTH - 1, 4, &abstract_path);
+    assert(found);
+
+    lowest_row = 0;
+
+    for (int i = 0; i + 1 < abstract_path.count; ++i)
+    {
+        bool refined = ClusterGraph_RefineSegment(&test_ctx, &map, &abstract_path, i, &segment_path);
+        assert(refined);
+
+        for (int t = 0; t < segment_path.length; ++t)
+        {
+            if (segment_path.tiles[t][1] > lowest_row)
+                lowest_row = segment_path.tiles[t][1];
+        }
+    }
+
+    assert(lowest_row < MAP_HEIGHT - 2);
+
+    ClusterGraph_Free(&graph);
+}
+
+/*
+    Test 10: identical goals share one reference-counted field, fields
+    price routes by terrain cost like the path search, and a field
+    built before a terrain edit is never handed out
+*/
+static void test_flow_field_sharing(void)
+{
+    static Map map;
+    make_empty_map(&map);
+
+    FlowFieldCache cache;
+    bool cache_ready = FlowFieldCache_Init(&cache, TEST_NODE_COUNT);
+    assert(cache_ready);
+
+    FlowField *a = FlowFieldCache_Acquire(&cache, &map, 10, 7);
+    FlowField *b = FlowFieldCache_Acquire(&cache, &map, 10, 7);
+    FlowField *c = FlowFieldCache_Acquire(&cache, &map, 3, 3);
+
+    assert(a != NULL && a == b);
+    assert(c != NULL && c != a);
+    assert(a->ref_count == 2);
+
+    // Following the directions from any tile takes exactly its distance
+    int tx = 0;
+    int ty = 0;
+    int steps = 0;
+
+    while (FlowField_NextTile(a, tx, ty, &tx, &ty))
+        steps++;
+
+    assert(tx == 10 && ty == 7);
+    assert(steps == FlowField_GetDistance(a, 0, 0));
+
+    FlowField_Release(a);
+    FlowField_Release(b);
+    FlowField_Release(c);
+    assert(a->ref_count == 0);
+
+    // Every slot referenced: the cache refuses instead of evicting
+    FlowField *held[FLOW_FIELD_CACHE_SIZE];
+
+    for (int i = 0; i < FLOW_FIELD_CACHE_SIZE; ++i)
+    {
+        held[i] = FlowFieldCache_Acquire(&cache, &map, i, 0);
+        assert(held[i] != NULL);
+    }
+
+    assert(FlowFieldCache_Acquire(&cache, &map, 0, 5) == NULL);
+
+    for (int i = 0; i < FLOW_FIELD_CACHE_SIZE; ++i)
+        FlowField_Release(held[i]);
+
+    // A swamp band with a road around its bottom end: the road is
+    // longer in tiles but cheaper, and both agree with the search
+    for (int y = 0; y < MAP_HEIGHT - 1; ++y)
+        for (int x = 3; x <= 8; ++x)
+            Map_SetCost(&map, x, y, MAP_COST_SWAMP);
+
+    FlowField *field = FlowFieldCache_Acquire(&cache, &map, 10, 7);
+    assert(field != NULL);
+
+    Path path;
+    bool found = Pathfinding_FindPath(&test_ctx, &map, 0, 7, 10, 7, NULL, &path);
+    assert(found);
+
+    int path_cost = 0;
+
+    for (int i = 1; i < path.length; ++i)
+        path_cost += Map_GetCost(&map, path.tiles[i][0], path.tiles[i][1]);
+
+    assert(FlowField_GetDistance(field, 0, 7) == path_cost);
+
+    tx = 0;
+    ty = 7;
+    int walked_cost = 0;
+
+    while (FlowField_NextTile(field, tx, ty, &tx, &ty))
+    {
+        assert(Map_GetCost(&map, tx, ty) == MAP_TILE_COST_MIN);
+        walked_cost += Map_GetCost(&map, tx, ty);
+    }
+
+    assert(tx == 10 && ty == 7);
+    assert(walked_cost == path_cost);
+    FlowField_Release(field);
+
+    // Closing the road: the cached field is rebuilt on the next order
+    Map_SetWalkable(&map, 5, MAP_HEIGHT - 1, false);
+
+    field = FlowFieldCache_Acquire(&cache, &map, 10, 7);
+    assert(field != NULL);
+    assert(field->map_revision == Map_GetWalkabilityRevision(&map));
+    assert(FlowField_GetDistance(field, 0, 7) > path_cost);
+    assert(FlowField_GetDistance(field, 5, MAP_HEIGHT - 1) == FLOW_FIELD_UNREACHABLE);
+
+    // Invalidate rebuilds the referenced field, drops the rest
+    FlowField *idle = FlowFieldCache_Acquire(&cache, &map, 3, 3);
+    assert(idle != NULL);
+    FlowField_Release(idle);
+
+    Map_SetCost(&map, 9, 7, MAP_COST_SWAMP);
+    FlowFieldCache_Invalidate(&cache, &map);
+
+    assert(!idle->valid);
+    assert(field->valid && field->map_revision == Map_GetWalkabilityRevision(&map));
+    assert(FlowField_GetDistance(field, 9, 7) == MAP_TILE_COST_MIN);
+    assert(FlowField_GetDistance(field, 8, 7) == MAP_COST_SWAMP + MAP_TILE_COST_MIN);
+    FlowField_Release(field);
+
+    FlowFieldCache_Free(&cache);
+}
+
+/*
+    Test 11: a group following one field settles without overlapping
+    and releases every reference
+*/
+static void test_flow_field_group(void)
+{
+    static Map map;
+    make_empty_map(&map);
+
+    FlowFieldCache cache;
+    bool cache_ready = FlowFieldCache_Init(&cache, TEST_NODE_COUNT);
+    assert(cache_ready);
+
+    enum { GROUP_SIZE = 6 };
+    Unit units[GROUP_SIZE];
+
+    for (int i = 0; i < GROUP_SIZE; ++i)
+    {
+        Unit_Init(&units[i], &map, &test_routes, 1, 2 + i);
+        units[i].flow = FlowFieldCache_Acquire(&cache, &map, 15, 7);
+        units[i].flow_arrive_distance = 2;
+    }
+
+    FlowField *field = units[0].flow;
+
+    for (int frame = 0; frame < 2000; ++frame)
+    {
+        for (int i = 0; i < GROUP_SIZE; ++i)
+            Unit_Update(&units[i], &map, 1.0f / 60.0f);
+    }
+
+    assert(field->ref_count == 0);
+
+    for (int i = 0; i < GROUP_SIZE; ++i)
+    {
+        assert(units[i].flow == NULL);
+        assert(FlowField_GetDistance(field, units[i].tx, units[i].ty) <= GROUP_SIZE);
+
+        for (int j = i + 1; j < GROUP_SIZE; ++j)
+            assert(units[i].tx != units[j].tx || units[i].ty != units[j].ty);
+    }
+
+    FlowFieldCache_Free(&cache);
+}
+
+/*
+    Test 12: repeated queries hit the cache until a tile on the
+    cached path is occupied or the walkability revision changes, and
+    only when asked with the same search options
+*/
+static void test_path_cache(void)
+{
+    static Map map;
+    make_empty_map(&map);
+
+    static PathCache cache;
+    PathCache_Init(&cache);
+
+    Path first;
+    Path second;
+
+    bool found = PathCache_FindPath(&cache, &test_ctx, &map, 1, 1, 10, 1, NULL, &first);
+    assert(found);
+    assert(cache.stats.misses == 1 && cache.stats.hits == 0);
+
+    found = PathCache_FindPath(&cache, &test_ctx, &map, 1, 1, 10, 1, NULL, &second);
+    assert(found);
+    assert(cache.stats.hits == 1);
+    assert(second.length == first.length);
+
+    // Occupying a tile on the route must not serve the stale path
+    Map_SetOccupied(&map, 5, 1, true);
+    found = PathCache_FindPath(&cache, &test_ctx, &map, 1, 1, 10, 1, NULL, &second);
+    assert(found);
+    assert(cache.stats.misses == 2);
+    assert(cache.stats.invalidations == 1);
+    assert_path_valid(&map, &second);
+    Map_SetOccupied(&map, 5, 1, false);
+
+    // Terrain edits anywhere retire entries from the older revision
+    found = PathCache_FindPath(&cache, &test_ctx, &map, 1, 1, 10, 1, NULL, &second);
+    assert(found);
+    assert(cache.stats.hits == 2);
+
+    Map_SetWalkable(&map, 18, 13, false);
+    found = PathCache_FindPath(&cache, &test_ctx, &map, 1, 1, 10, 1, NULL, &second);
+    assert(found);
+    assert(cache.stats.misses == 3);
+
+    // Explicit hook drops entries crossing the tile
+    PathCache_InvalidateTile(&cache, second.tiles[1][0], second.tiles[1][1]);
+    found = PathCache_FindPath(&cache, &test_ctx, &map, 1, 1, 10, 1, NULL, &second);
+    assert(found);
+    assert(cache.stats.misses == 4);
+
+    // Each set of options keeps its own entry for the same endpoints
+    const PathOptions option_sets[] =
+    {
+        { 0 },
+        { .connectivity = PATH_CONNECTIVITY_8 },
+        { .smooth = true },
+        { .algorithm = PATH_ALGORITHM_JPS, .heuristic = PATH_HEURISTIC_LANDMARKS },
+    };
+    const int option_count = (int)(sizeof(option_sets) / sizeof(option_sets[0]));
+
+    Path expected[sizeof(option_sets) / sizeof(option_sets[0])];
+
+    PathCache_Clear(&cache);
+    unsigned long misses = cache.stats.misses;
+    unsigned long hits = cache.stats.hits;
+
+    for (int round = 0; round < 2; ++round)
+    {
+        for (int i = 0; i < option_count; ++i)
+        {
+            found = PathCache_FindPath(&cache, &test_ctx, &map, 1, 1, 12, 9, &option_sets[i], &second);
+            assert(found);
+
+            if (round == 0)
+            {
+                found = Pathfinding_FindPath(&test_ctx, &map, 1, 1, 12, 9, &option_sets[i], &expected[i]);
+                assert(found);
+            }
+
+            assert(second.length == expected[i].length);
+            assert(memcmp(second.tiles, expected[i].tiles, sizeof(int) * 2 * (size_t)second.length) == 0);
+        }
+    }
+
+    assert(cache.stats.misses == misses + (unsigned long)option_count);
+    assert(cache.stats.hits == hits + (unsigned long)option_count);
+    assert(expected[1].length < expected[0].length);
+    assert(expected[2].length < expected[0].length);
+}
+
+/*
+    Test 13: repairs after a tile on the route is occupied match a
+    fresh A* search and expand fewer nodes than the initial plan; a
+    route longer than a Path holds comes back cut to its first tiles;
+    repairs pick up published terrain edits, also after the change
+    log overflowed
+*/
+static void test_replan_matches_astar(void)
+{
+    static Replanner planner;
+    bool planner_ready = Replanner_Init(&planner, MAP_WIDTH, MAP_HEIGHT);
+    assert(planner_ready);
+
+    for (unsigned int seed = 1; seed <= 50; ++seed)
+    {
+        static Map map;
+        make_random_map(&map, seed, 20);
+        Map_SetWalkable(&map, 1, 1, true);
+        Map_SetWalkable(&map, 18, 13, true);
+
+        Path planned;
+        Path repaired;
+        Path expected;
+
+        bool found = Replanner_Plan(&planner, &map, 1, 1, 18, 13, &planned);
+        bool expected_found = Pathfinding_FindPath(&test_ctx, &map, 1, 1, 18, 13, NULL, &expected);
+        assert(found == expected_found);
+
+        if (!found || planned.length < 5)
+            continue;
+
+        assert(planned.length == expected.length);
+        assert_path_valid(&map, &planned);
+
+        int initial_expansions = planner.last_expansions;
+
+        // Unit moved one step, then someone stood two tiles ahead
+        int start_tx = planned.tiles[1][0];
+        int start_ty = planned.tiles[1][1];
+        Map_SetOccupied(&map, planned.tiles[3][0], planned.tiles[3][1], true);
+
+        found = Replanner_Replan(&planner, &map, start_tx, start_ty, &repaired);
+        expected_found = Pathfinding_FindPath(&test_ctx, &map, start_tx, start_ty, 18, 13, NULL, &expected);
+        assert(found == expected_found);
+
+        if (!found)
+            continue;
+
+        assert(repaired.length == expected.length);
+        assert_path_valid(&map, &repaired);
+        assert(planner.last_expansions < initial_expansions);
+    }
+
+    // Serpentine longer than MAX_PATH_LENGTH tiles
+    static Map map;
+    make_empty_map(&map);
+
+    for (int y = 1; y < MAP_HEIGHT; y += 2)
+    {
+        int gap = (y / 2) % 2 == 0 ? MAP_WIDTH - 1 : 0;
+
+        for (int x = 0; x < MAP_WIDTH; ++x)
+        {
+            if (x != gap)
+                Map_SetWalkable(&map, x, y, false);
+        }
+    }
+
+    Map_UpdateComponents(&map);
+
+    int goal_ty = MAP_HEIGHT % 2 == 0 ? MAP_HEIGHT - 2 : MAP_HEIGHT - 1;
+    Path head;
+    Path rest;
+
+    bool found = Replanner_Plan(&planner, &map, 0, 0, 0, goal_ty, &head);
+    assert(found);
+    assert(head.length == MAX_PATH_LENGTH);
+    assert(head.tiles[0][0] == 0 && head.tiles[0][1] == 0);
+    assert_path_valid(&map, &head);
+
+    // From the end of the cut route, the rest of the way fits
+    int last_tx = head.tiles[MAX_PATH_LENGTH - 1][0];
+    int last_ty = head.tiles[MAX_PATH_LENGTH - 1][1];
+
+    found = Replanner_Replan(&planner, &map, last_tx, last_ty, &rest);
+    assert(found);
+    assert(rest.length < MAX_PATH_LENGTH);
+    assert(rest.tiles[rest.length - 1][0] == 0 && rest.tiles[rest.length - 1][1] == goal_ty);
+    assert_path_valid(&map, &rest);
+
+    // Terrain edits reach the plan through the change log once published
+    make_empty_map(&map);
+    Path straight;
+
+    found = Replanner_Plan(&planner, &map, 1, 7, 12, 7, &straight);
+    assert(found);
+    assert(straight.length == 12);
+
+    Map_SetWalkable(&map, 6, 7, false);
+    Map_SetCost(&map, 6, 8, MAP_TILE_COST_MAX);
+    Map_UpdateComponents(&map);
+    Map_PublishChanges(&map);
+
+    Path detour;
+    Path expected;
+
+    found = Replanner_Replan(&planner, &map, 1, 7, &detour);
+    assert(found);
+    assert_path_valid(&map, &detour);
+    Pathfinding_FindPath(&test_ctx, &map, 1, 7, 12, 7, NULL, &expected);
+    assert(terrain_path_cost(&map, &detour) == terrain_path_cost(&map, &expected));
+
+    // Fallen behind the log: the whole-map change resyncs every tile
+    for (int i = 0; i <= MAP_CHANGE_LOG_SIZE; ++i)
+    {
+        Map_SetCost(&map, 0, 0, i % 2 == 0 ? MAP_COST_SWAMP : MAP_TILE_COST_MIN);
+        Map_PublishChanges(&map);
+    }
+
+    Map_SetWalkable(&map, 6, 6, false);
+    Map_UpdateComponents(&map);
+    Map_PublishChanges(&map);
+
+    found = Replanner_Replan(&planner, &map, 1, 7, &detour);
+    assert(found);
+    assert_path_valid(&map, &detour);
+    Pathfinding_FindPath(&test_ctx, &map, 1, 7, 12, 7, NULL, &expected);
+    assert(terrain_path_cost(&map, &detour) == terrain_path_cost(&map, &expected));
+
+    Replanner_Free(&planner);
+}
+
+/*
+    Test 14: a unit with a replanner walks around a unit that
+    stepped onto its route
+*/
+static void test_replan_unit_detour(void)
+{
+    static Map map;
+    make_empty_map(&map);
+
+    static Replanner planner;
+    bool planner_ready = Replanner_Init(&planner, MAP_WIDTH, MAP_HEIGHT);
+    assert(planner_ready);
+
+    Unit walker;
+    Unit blocker;
+    Path path;
+
+    Unit_Init(&walker, &map, &test_routes, 1, 7);
+    walker.replanner = &planner;
+
+    bool found = Replanner_Plan(&planner, &map, 1, 7, 12, 7, &path);
+    assert(found);
+    Unit_SetPath(&walker, &path);
+
+    Unit_Init(&blocker, &map, &test_routes, 6, 7);
+
+    for (int frame = 0; frame < 600; ++frame)
+    {
+        Unit_Update(&walker, &map, 1.0f / 60.0f);
+        assert(walker.tx != blocker.tx || walker.ty != blocker.ty);
+    }
+
+    assert(walker.tx == 12 && walker.ty == 7);
+
+    Replanner_Free(&planner);
+}
+
+/*
+    Test 15: region labels reject walled-off goals before searching
+    and agree with a flood fill after random walkability edits
+*/
+static void test_components(void)
+{
+    static Map map;
+    make_empty_map(&map);
+
+    Path path;
+
+    // A full wall down column 10 splits the map in two
+    for (int y = 0; y < MAP_HEIGHT; ++y)
+        Map_SetWalkable(&map, 10, y, false);
+
+    assert(map.components_dirty);
+    Map_UpdateComponents(&map);
+
+    assert(Map_AreConnected(&map, 1, 1, 8, 13));
+    assert(!Map_AreConnected(&map, 1, 1, 18, 1));
+
+    bool found = Pathfinding_FindPath(&test_ctx, &map, 1, 1, 18, 1, NULL, &path);
+    assert(!found);
+
+    // Opening a gap merges the regions again
+    Map_SetWalkable(&map, 10, 7, true);
+    Map_UpdateComponents(&map);
+
+    assert(Map_AreConnected(&map, 1, 1, 18, 1));
+    found = Pathfinding_FindPath(&test_ctx, &map, 1, 1, 18, 1, NULL, &path);
+    assert(found);
+
+    // Blocking a tile in open ground cannot split anything
+    Map_SetWalkable(&map, 4, 4, false);
+    assert(!map.components_dirty);
+
+    // Random edits: labels, whenever trusted, match a flood fill
+    FlowFieldCache cache;
+    bool cache_ready = FlowFieldCache_Init(&cache, TEST_NODE_COUNT);
+    assert(cache_ready);
+
+    unsigned int state = 7;
+
+    for (int edit = 0; edit < 400; ++edit)
+    {
+        state = state * 1103515245u + 12345u;
+        int tx = (int)((state >> 16) % MAP_WIDTH);
+        state = state * 1103515245u + 12345u;
+        int ty = (int)((state >> 16) % MAP_HEIGHT);
+
+        Map_SetWalkable(&map, tx, ty, !Map_IsWalkable(&map, tx, ty));
+
+        if (edit % 5 == 0)
+            Map_UpdateComponents(&map);
+
+        if (map.components_dirty || !Map_IsWalkable(&map, 0, 0))
+            continue;
+
+        FlowField *field = FlowFieldCache_Acquire(&cache, &map, 0, 0);
+        assert(field != NULL);
+
+        for (int y = 0; y < MAP_HEIGHT; ++y)
+        {
+            for (int x = 0; x < MAP_WIDTH; ++x)
+            {
+                if (!Map_IsWalkable(&map, x, y))
+                    continue;
+
+                bool reachable = FlowField_GetDistance(field, x, y) != FLOW_FIELD_UNREACHABLE;
+                assert(Map_AreConnected(&map, x, y, 0, 0) == reachable);
+            }
+        }
+
+        FlowField_Release(field);
+        FlowFieldCache_Invalidate(&cache, &map);
+    }
+
+    FlowFieldCache_Free(&cache);
+}
+
+/*
+    Test 16: batched queries give the same results as serial
+    searches whatever the worker count
+*/
+static void test_batch_matches_serial(void)
+{
+    enum { REQUEST_COUNT = 48 };
+
+    static PathRequest requests[REQUEST_COUNT];
+    static PathResult expected[REQUEST_COUNT];
+    static PathResult results[REQUEST_COUNT];
+
+    static Map map;
+    make_random_map(&map, 11, 25);
+
+    unsigned int state = 3;
+
+    for (int i = 0; i < REQUEST_COUNT; ++i)
+    {
+        PathRequest *request = &requests[i];
+
+        state = state * 1103515245u + 12345u;
+        request->start_tx = (int)((state >> 16) % MAP_WIDTH);
+        state = state * 1103515245u + 12345u;
+        request->start_ty = (int)((state >> 16) % MAP_HEIGHT);
+        state = state * 1103515245u + 12345u;
+        request->goal_tx = (int)((state >> 16) % MAP_WIDTH);
+        state = state * 1103515245u + 12345u;
+        request->goal_ty = (int)((state >> 16) % MAP_HEIGHT);
+
+        request->options = (PathOptions){0};
+        request->options.algorithm = i % 3 == 0 ? PATH_ALGORITHM_JPS : PATH_ALGORITHM_ASTAR;
+
+        expected[i].found = Pathfinding_FindPath(
+            &test_ctx, &map,
+            request->start_tx, request->start_ty,
+            request->goal_tx, request->goal_ty,
+            &request->options, &expected[i].path);
+    }
+
+    const int worker_counts[] = { 1, 2, 4 };
+
+    for (int w = 0; w < 3; ++w)
+    {
+        static PathWorkerPool pool;
+        bool pool_ready = PathWorkerPool_Init(&pool, worker_counts[w], TEST_NODE_COUNT);
+        assert(pool_ready);
+
+        // Two batches per pool so parked workers get reused
+        for (int batch = 0; batch < 2; ++batch)
+        {
+            Pathfinding_FindPaths(&pool, &map, requests, REQUEST_COUNT, results);
+
+            for (int i = 0; i < REQUEST_COUNT; ++i)
+            {
+                assert(results[i].found == expected[i].found);
+                assert(results[i].path.length == expected[i].path.length);
+
+                for (int t = 0; t < results[i].path.length; ++t)
+                {
+                    assert(results[i].path.tiles[t][0] == expected[i].path.tiles[t][0]);
+                    assert(results[i].path.tiles[t][1] == expected[i].path.tiles[t][1]);
+                }
+            }
+        }
+
+        PathWorkerPool_Free(&pool);
+    }
+}
+
+/*
+    Test 17: sliced searches resume across ticks within the budget
+    and deliver the same paths as uninterrupted searches
+*/
+static void test_scheduler_slices(void)
+{
+    static Map map;
+    make_random_map(&map, 5, 20);
+
+    enum { UNIT_COUNT = 4, BUDGET = 10 };
+
+    static PathContext sched_ctx;
+    bool ctx_ready = PathContext_Init(&sched_ctx, TEST_NODE_COUNT);
+    assert(ctx_ready);
+
+    static PathCache cache;
+    PathCache_Init(&cache);
+
+    PathScheduler scheduler;
+    PathScheduler_Init(&scheduler, &sched_ctx, &cache, BUDGET);
+
+    Unit units[UNIT_COUNT];
+    Path expected[UNIT_COUNT];
+    bool expected_found[UNIT_COUNT];
+
+    for (int i = 0; i < UNIT_COUNT; ++i)
+    {
+        Map_SetWalkable(&map, 0, 2 + 3 * i, true);
+        Unit_Init(&units[i], &map, &test_routes, 0, 2 + 3 * i);
+    }
+
+    Map_SetWalkable(&map, MAP_WIDTH - 1, MAP_HEIGHT / 2, true);
+
+    for (int i = 0; i < UNIT_COUNT; ++i)
+    {
+        expected_found[i] = Pathfinding_FindPath(
+            &test_ctx, &map, units[i].tx, units[i].ty, MAP_WIDTH - 1, MAP_HEIGHT / 2, NULL, &expected[i]);
+
+        bool queued = PathScheduler_Submit(&scheduler, &map, &units[i], MAP_WIDTH - 1, MAP_HEIGHT / 2, NULL);
+        assert(queued);
+        assert(units[i].path_pending);
+    }
+
+    int ticks = 0;
+
+    while (scheduler.count > 0)
+    {
+        int expanded_before = sched_ctx.expansions;
+        bool was_searching = scheduler.searching;
+
+        PathScheduler_Update(&scheduler, &map);
+        ticks++;
+
+        // A search still running after the tick stayed within budget
+        if (scheduler.searching && was_searching && scheduler.count > 0)
+            assert(sched_ctx.expansions - expanded_before <= BUDGET);
+
+        assert(ticks < 1000);
+    }
+
+    // The work was spread over many ticks
+    assert(ticks > UNIT_COUNT);
+
+    for (int i = 0; i < UNIT_COUNT; ++i)
+    {
+        assert(!units[i].path_pending);
+
+        static int queued[TEST_NODE_COUNT][2];
+        int queued_count = queued_tiles(&units[i], queued);
+
+        if (!expected_found[i])
+        {
+            assert(queued_count == 0);
+            continue;
+        }
+
+        assert(queued_count == expected[i].length - 1);
+
+        for (int t = 0; t < queued_count; ++t)
+        {
+            assert(queued[t][0] == expected[i].tiles[t + 1][0]);
+            assert(queued[t][1] == expected[i].tiles[t + 1][1]);
+        }
+    }
+
+    // Completed searches were cached: the same order resolves on submit
+    if (expected_found[0])
+    {
+        bool queued = PathScheduler_Submit(&scheduler, &map, &units[0], MAP_WIDTH - 1, MAP_HEIGHT / 2, NULL);
+        assert(queued);
+        assert(!units[0].path_pending);
+        assert(scheduler.count == 0);
+    }
+
+    // Cancelling drops a queued order
+    PathScheduler_Submit(&scheduler, &map, &units[1], 5, 5, NULL);
+    PathScheduler_Cancel(&scheduler, &units[1]);
+    assert(scheduler.count == 0);
+    assert(!units[1].path_pending);
+
+    PathContext_Free(&sched_ctx);
+}
+
+/*
+    Test 18: the landmark heuristic keeps paths optimal, never expands
+    more nodes than Manhattan overall, and is disabled by an opening
+    until the tables are rebuilt
+*/
+static void test_landmark_heuristic(void)
+{
+    static Map map;
+    const PathOptions alt_options = { .heuristic = PATH_HEURISTIC_LANDMARKS };
+
+    long manhattan_expansions = 0;
+    long landmark_expansions = 0;
+
+    for (unsigned int seed = 1; seed <= 40; ++seed)
+    {
+        make_empty_map(&map);
+
+        unsigned int state = seed;
+
+        for (int y = 0; y < MAP_HEIGHT; ++y)
+        {
+            for (int x = 0; x < MAP_WIDTH; ++x)
+            {
+                state = state * 1103515245u + 12345u;
+
+                if ((state >> 16) % 100 < 30)
+                    Map_SetWalkable(&map, x, y, false);
+            }
+        }
+
+        Map_SetWalkable(&map, 0, 0, true);
+        Map_SetWalkable(&map, MAP_WIDTH - 1, MAP_HEIGHT - 1, true);
+        Map_UpdateComponents(&map);
+
+        // Small budget: the rebuild has to resume across calls
+        int calls = 0;
+
+        while (map.landmark_build_index < MAP_LANDMARK_COUNT)
+        {
+            Map_UpdateLandmarks(&map, 16);
+            calls++;
+        }
+
+        assert(calls > 1);
+
+        Path manhattan;
+        Path landmark;
+
+        bool found = Pathfinding_FindPath(&test_ctx, &map, 0, 0, MAP_WIDTH - 1, MAP_HEIGHT - 1, NULL, &manhattan);
+        manhattan_expansions += test_ctx.expansions;
+
+        bool alt_found = Pathfinding_FindPath(
+            &test_ctx, &map, 0, 0, MAP_WIDTH - 1, MAP_HEIGHT - 1, &alt_options, &landmark);
+        landmark_expansions += test_ctx.expansions;
+
+        assert(found == alt_found);
+
+        if (found)
+        {
+            assert(landmark.length == manhattan.length);
+            assert_path_valid(&map, &landmark);
+        }
+    }
+
+    assert(landmark_expansions <= manhattan_expansions);
+
+    // Opening a tile may create a shortcut: tables are off until rebuilt
+    Map_SetWalkable(&map, 5, 5, false);
+    Map_UpdateLandmarks(&map, INT_MAX);
+    assert(map.landmark_usable[0]);
+
+    Map_SetWalkable(&map, 5, 5, true);
+    assert(!map.landmark_usable[0]);
+
+    Map_UpdateLandmarks(&map, INT_MAX);
+    assert(map.landmark_usable[0]);
+}
+
+/*
+    Test 19: bidirectional search returns paths of the same length as
+    A* from random starts to random goals, also with landmarks, refuses
+    an occupied goal and gives the same result when run in slices
+*/
+static void test_bidirectional_matches_astar(void)
+{
+    static Map map;
+    const PathOptions bidir_options = { .algorithm = PATH_ALGORITHM_BIDIRECTIONAL };
+    const PathOptions bidir_alt_options = {
+        .algorithm = PATH_ALGORITHM_BIDIRECTIONAL,
+        .heuristic = PATH_HEURISTIC_LANDMARKS
+    };
+
+    unsigned int state = 7;
+
+    for (int round = 0; round < 20; ++round)
+    {
+        make_empty_map(&map);
+
+        for (int y = 0; y < MAP_HEIGHT; ++y)
+        {
+            for (int x = 0; x < MAP_WIDTH; ++x)
+            {
+                state = state * 1103515245u + 12345u;
+
+                if ((state >> 16) % 100 < 30)
+                    Map_SetWalkable(&map, x, y, false);
+            }
+        }
+
+        Map_UpdateComponents(&map);
+        Map_UpdateLandmarks(&map, INT_MAX);
+
+        for (int query = 0; query < 10; ++query)
+        {
+            state = state * 1103515245u + 12345u;
+            int sx = (int)((state >> 16) % MAP_WIDTH);
+            state = state * 1103515245u + 12345u;
+            int sy = (int)((state >> 16) % MAP_HEIGHT);
+            state = state * 1103515245u + 12345u;
+            int gx = (int)((state >> 16) % MAP_WIDTH);
+            state = state * 1103515245u + 12345u;
+            int gy = (int)((state >> 16) % MAP_HEIGHT);
+
+            Path astar;
+            Path bidir;
+            Path bidir_alt;
+
+            bool found = Pathfinding_FindPath(&test_ctx, &map, sx, sy, gx, gy, NULL, &astar);
+            bool bidir_found = Pathfinding_FindPath(&test_ctx, &map, sx, sy, gx, gy, &bidir_options, &bidir);
+            bool alt_found = Pathfinding_FindPath(&test_ctx, &map, sx, sy, gx, gy, &bidir_alt_options, &bidir_alt);
+
+            assert(found == bidir_found);
+            assert(found == alt_found);
+
+            if (!found)
+                continue;
+
+            assert(bidir.length == astar.length);
+            assert(bidir_alt.length == astar.length);
+
+            assert(bidir.tiles[0][0] == sx && bidir.tiles[0][1] == sy);
+            assert(bidir.tiles[bidir.length - 1][0] == gx && bidir.tiles[bidir.length - 1][1] == gy);
+            assert_path_valid(&map, &bidir);
+            assert_path_valid(&map, &bidir_alt);
+        }
+    }
+
+    make_empty_map(&map);
+
+    Path path;
+
+    // Same tile
+    bool found = Pathfinding_FindPath(&test_ctx, &map, 3, 3, 3, 3, &bidir_options, &path);
+    assert(found);
+    assert(path.length == 1);
+
+    // Occupied goal fails like plain A*
+    Map_SetOccupied(&map, 10, 5, true);
+    found = Pathfinding_FindPath(&test_ctx, &map, 0, 5, 10, 5, &bidir_options, &path);
+    assert(!found);
+    Map_SetOccupied(&map, 10, 5, false);
+
+    // One expansion per step gives the same path as an uninterrupted search
+    Path whole;
+    found = Pathfinding_FindPath(&test_ctx, &map, 0, 0, MAP_WIDTH - 1, MAP_HEIGHT - 1, &bidir_options, &whole);
+    assert(found);
+
+    Pathfinding_BeginSearch(&test_ctx, &map, 0, 0, MAP_WIDTH - 1, MAP_HEIGHT - 1, &bidir_options);
+
+    while (Pathfinding_StepSearch(&test_ctx, &map, 1) == PATH_SEARCH_RUNNING)
+        ;
+
+    found = Pathfinding_FinishSearch(&test_ctx, &path);
+    assert(found);
+    assert(path.length == whole.length);
+    assert(memcmp(path.tiles, whole.tiles, sizeof(path.tiles[0]) * (size_t)path.length) == 0);
+}
+
+/*
+    Helper: cost of an 8-connected path including terrain, checking
+    every step is a free move that does not cut a corner
+*/
+static int diagonal_path_cost(const Map *map, const Path *path)
+{
+    int cost = 0;
+
+    for (int i = 1; i < path->length; ++i)
+    {
+        int x = path->tiles[i - 1][0];
+        int y = path->tiles[i - 1][1];
+        int dx = path->tiles[i][0] - x;
+        int dy = path->tiles[i][1] - y;
+
+        assert(dx >= -1 && dx <= 1 && dy >= -1 && dy <= 1);
+        assert(dx != 0 || dy != 0);
+        assert(Map_IsWalkable(map, x + dx, y + dy));
+        assert(!Map_IsOccupied(map, x + dx, y + dy));
+
+        if (dx != 0 && dy != 0)
+        {
+            assert(Map_IsWalkable(map, x + dx, y) && !Map_IsOccupied(map, x + dx, y));
+            assert(Map_IsWalkable(map, x, y + dy) && !Map_IsOccupied(map, x, y + dy));
+            cost += PATH_COST_DIAGONAL * Map_GetCost(map, x + dx, y + dy);
+        }
+        else
+        {
+            cost += PATH_COST_STRAIGHT * Map_GetCost(map, x + dx, y + dy);
+        }
+    }
+
+    return cost;
+}
+
+/*
+    Test 20: 8-connected search moves diagonally, never cuts a corner
+    unless allowed, and agrees on cost across A*, bidirectional and
+    landmark searches
+*/
+static void test_diagonal_movement(void)
+{
+    static Map map;
+    const PathOptions diagonal = { .connectivity = PATH_CONNECTIVITY_8 };
+    const PathOptions cutting = { .connectivity = PATH_CONNECTIVITY_8, .corner_cutting = true };
+
+    make_empty_map(&map);
+
+    Path path;
+
+    // Open map: straight diagonal
+    bool found = Pathfinding_FindPath(&test_ctx, &map, 0, 0, 9, 9, &diagonal, &path);
+    assert(found);
+    assert(path.length == 10);
+    assert(diagonal_path_cost(&map, &path) == 9 * PATH_COST_DIAGONAL);
+
+    // JPS has no diagonal rules and runs as A*
+    const PathOptions jps = { .algorithm = PATH_ALGORITHM_JPS, .connectivity = PATH_CONNECTIVITY_8 };
+    found = Pathfinding_FindPath(&test_ctx, &map, 0, 0, 9, 9, &jps, &path);
+    assert(found);
+    assert(path.length == 10);
+
+    // One blocked orthogonal: go around it unless cutting is allowed
+    Map_SetWalkable(&map, 3, 2, false);
+
+    found = Pathfinding_FindPath(&test_ctx, &map, 2, 2, 3, 3, &diagonal, &path);
+    assert(found);
+    assert(path.length == 3);
+
+    found = Pathfinding_FindPath(&test_ctx, &map, 2, 2, 3, 3, &cutting, &path);
+    assert(found);
+    assert(path.length == 2);
+
+    // A unit standing on the orthogonal counts as blocking too
+    Map_SetWalkable(&map, 3, 2, true);
+    Map_SetOccupied(&map, 2, 3, true);
+
+    found = Pathfinding_FindPath(&test_ctx, &map, 2, 2, 3, 3, &diagonal, &path);
+    assert(found);
+    assert(path.length == 3);
+
+    // Both orthogonals blocked: no squeezing through, even when cutting
+    Map_SetWalkable(&map, 3, 2, false);
+    Map_SetWalkable(&map, 1, 2, false);
+    Map_SetWalkable(&map, 2, 1, false);
+
+    found = Pathfinding_FindPath(&test_ctx, &map, 2, 2, 3, 3, &cutting, &path);
+    assert(!found);
+
+    Map_SetOccupied(&map, 2, 3, false);
+
+    // Random maps: same cost whichever search runs
+    const PathOptions bidir = {
+        .algorithm = PATH_ALGORITHM_BIDIRECTIONAL,
+        .connectivity = PATH_CONNECTIVITY_8
+    };
+    const PathOptions landmarks = {
+        .heuristic = PATH_HEURISTIC_LANDMARKS,
+        .connectivity = PATH_CONNECTIVITY_8
+    };
+
+    unsigned int state = 11;
+
+    for (int round = 0; round < 20; ++round)
+    {
+        make_empty_map(&map);
+
+        for (int y = 0; y < MAP_HEIGHT; ++y)
+        {
+            for (int x = 0; x < MAP_WIDTH; ++x)
+            {
+                state = state * 1103515245u + 12345u;
+
+                if ((state >> 16) % 100 < 25)
+                    Map_SetWalkable(&map, x, y, false);
+            }
+        }
+
+        Map_SetWalkable(&map, 0, 0, true);
+        Map_SetWalkable(&map, MAP_WIDTH - 1, MAP_HEIGHT - 1, true);
+        Map_UpdateComponents(&map);
+        Map_UpdateLandmarks(&map, INT_MAX);
+
+        Path straight;
+        Path astar;
+        Path bidir_path;
+        Path landmark_path;
+
+        bool straight_found = Pathfinding_FindPath(
+            &test_ctx, &map, 0, 0, MAP_WIDTH - 1, MAP_HEIGHT - 1, NULL, &straight);
+        bool astar_found = Pathfinding_FindPath(
+            &test_ctx, &map, 0, 0, MAP_WIDTH - 1, MAP_HEIGHT - 1, &diagonal, &astar);
+        bool bidir_found = Pathfinding_FindPath(
+            &test_ctx, &map, 0, 0, MAP_WIDTH - 1, MAP_HEIGHT - 1, &bidir, &bidir_path);
+        bool landmark_found = Pathfinding_FindPath(
+            &test_ctx, &map, 0, 0, MAP_WIDTH - 1, MAP_HEIGHT - 1, &landmarks, &landmark_path);
+
+        // Without corner cutting diagonals never connect new regions
+        assert(astar_found == straight_found);
+        assert(astar_found == bidir_found);
+        assert(astar_found == landmark_found);
+
+        if (!astar_found)
+            continue;
+
+        int cost = diagonal_path_cost(&map, &astar);
+
+        assert(diagonal_path_cost(&map, &bidir_path) == cost);
+        assert(diagonal_path_cost(&map, &landmark_path) == cost);
+        assert(astar.length <= straight.length);
+    }
+}
+
+/*
+    Test 21: terrain costs steer the search around swamps, every open
+    set, algorithm and the replanner agree on the cost, and units slow
+    down on costly tiles
+*/
+static void test_terrain_costs(void)
+{
+    static Map map;
+    static Replanner planner;
+
+    const PathOptions bucket = { .open_set = PATH_OPEN_SET_BUCKET_QUEUE };
+    const PathOptions scan = { .open_set = PATH_OPEN_SET_LINEAR_SCAN };
+    const PathOptions jps = { .algorithm = PATH_ALGORITHM_JPS };
+    const PathOptions bidir = { .algorithm = PATH_ALGORITHM_BIDIRECTIONAL };
+    const PathOptions landmarks = { .open_set = PATH_OPEN_SET_BUCKET_QUEUE, .heuristic = PATH_HEURISTIC_LANDMARKS };
+    const PathOptions diagonal_bucket = {
+        .open_set = PATH_OPEN_SET_BUCKET_QUEUE,
+        .connectivity = PATH_CONNECTIVITY_8
+    };
+    const PathOptions diagonal_heap = { .connectivity = PATH_CONNECTIVITY_8 };
+
+    bool planner_ready = Replanner_Init(&planner, MAP_WIDTH, MAP_HEIGHT);
+    assert(planner_ready);
+
+    // Swamp column with a road gap two rows down: worth the detour
+    make_empty_map(&map);
+    assert(Map_HasUniformCost(&map));
+
+    for (int y = 0; y < MAP_HEIGHT; ++y)
+    {
+        if (y != 7)
+            Map_SetCost(&map, 10, y, MAP_TILE_COST_MAX);
+    }
+
+    assert(!Map_HasUniformCost(&map));
+
+    Path path;
+    bool found = Pathfinding_FindPath(&test_ctx, &map, 5, 5, 15, 5, NULL, &path);
+    assert(found);
+    assert(path.length == 15);
+    assert(terrain_path_cost(&map, &path) == 14);
+
+    // Clamped to range, and back to uniform once cleared
+    Map_SetCost(&map, 0, 0, 99);
+    assert(Map_GetCost(&map, 0, 0) == MAP_TILE_COST_MAX);
+    Map_SetCost(&map, 0, 0, 0);
+    assert(Map_GetCost(&map, 0, 0) == MAP_TILE_COST_MIN);
+
+    unsigned int state = 5;
+
+    for (int round = 0; round < 20; ++round)
+    {
+        make_empty_map(&map);
+
+        for (int y = 0; y < MAP_HEIGHT; ++y)
+        {
+            for (int x = 0; x < MAP_WIDTH; ++x)
+            {
+                state = state * 1103515245u + 12345u;
+                int roll = (int)((state >> 16) % 100);
+
+                if (roll < 20)
+                    Map_SetWalkable(&map, x, y, false);
+                else if (roll < 45)
+                    Map_SetCost(&map, x, y, MAP_COST_GRASS);
+                else if (roll < 60)
+                    Map_SetCost(&map, x, y, MAP_COST_SWAMP);
+            }
+        }
+
+        Map_SetWalkable(&map, 0, 0, true);
+        Map_SetWalkable(&map, MAP_WIDTH - 1, MAP_HEIGHT - 1, true);
+        Map_UpdateComponents(&map);
+        Map_UpdateLandmarks(&map, INT_MAX);
+
+        const PathOptions *variants[] = { &bucket, &scan, &jps, &bidir, &landmarks };
+        Path reference;
+
+        bool reference_found = Pathfinding_FindPath(
+            &test_ctx, &map, 0, 0, MAP_WIDTH - 1, MAP_HEIGHT - 1, NULL, &reference);
+
+        if (!reference_found)
+            continue;
+
+        int cost = terrain_path_cost(&map, &reference);
+
+        for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); ++v)
+        {
+            found = Pathfinding_FindPath(
+                &test_ctx, &map, 0, 0, MAP_WIDTH - 1, MAP_HEIGHT - 1, variants[v], &path);
+            assert(found);
+            assert_path_valid(&map, &path);
+            assert(terrain_path_cost(&map, &path) == cost);
+        }
+
+        found = Replanner_Plan(&planner, &map, 0, 0, MAP_WIDTH - 1, MAP_HEIGHT - 1, &path);
+        assert(found);
+        assert(terrain_path_cost(&map, &path) == cost);
+
+        Path diagonal;
+        Path diagonal_buckets;
+
+        found = Pathfinding_FindPath(
+            &test_ctx, &map, 0, 0, MAP_WIDTH - 1, MAP_HEIGHT - 1, &diagonal_heap, &diagonal);
+        assert(found);
+        found = Pathfinding_FindPath(
+            &test_ctx, &map, 0, 0, MAP_WIDTH - 1, MAP_HEIGHT - 1, &diagonal_bucket, &diagonal_buckets);
+        assert(found);
+        assert(diagonal_path_cost(&map, &diagonal_buckets) == diagonal_path_cost(&map, &diagonal));
+    }
+
+    // Same step on road and swamp: swamp takes four times as many ticks
+    int ticks[2];
+    const int terrain[2] = { MAP_COST_ROAD, MAP_COST_SWAMP };
+
+    for (int t = 0; t < 2; ++t)
+    {
+        make_empty_map(&map);
+        Map_SetCost(&map, 4, 3, terrain[t]);
+
+        Unit unit;
+        Unit_Init(&unit, &map, &test_routes, 3, 3);
+
+        Path step = { .tiles = { { 3, 3 }, { 4, 3 } }, .length = 2 };
+        Unit_SetPath(&unit, &step);
+
+        ticks[t] = 0;
+
+        do
+        {
+            Unit_Update(&unit, &map, 1.0f / 60.0f);
+            ticks[t]++;
+        } while (unit.tx != 4);
+    }
+
+    assert(ticks[1] >= 4 * ticks[0] - 1);
+    assert(ticks[1] <= 4 * ticks[0] + 1);
+
+    Replanner_Free(&planner);
+}
+
+/*
+    Test 22: claims expire with the clock, and two cooperative units
+    swap ends of a corridor through a one-tile alcove without
+    colliding or replanning every step
+*/
+static void test_cooperative_corridor(void)
+{
+    static Map map;
+    static ReservationTable table;
+    static CooperativeSearch search;
+
+    bool table_ready = ReservationTable_Init(&table, MAP_WIDTH, MAP_HEIGHT, 0.1f);
+    assert(table_ready);
+
+    bool search_ready = CooperativeSearch_Init(&search, &table);
+    assert(search_ready);
+
+    // One claim per (tile, step), gone once the step has passed
+    bool reserved = ReservationTable_Reserve(&table, 3, 3, 2, 1);
+    assert(reserved);
+    reserved = ReservationTable_Reserve(&table, 3, 3, 2, 2);
+    assert(!reserved);
+    assert(ReservationTable_IsFree(&table, 3, 3, 2, 1));
+    assert(ReservationTable_IsFree(&table, 3, 3, 1, 2));
+
+    ReservationTable_Advance(&table, 0.25f);
+    assert(table.now == 2);
+    assert(ReservationTable_GetOwner(&table, 3, 3, 2) == 1);
+
+    ReservationTable_Advance(&table, 0.1f);
+    assert(ReservationTable_GetOwner(&table, 3, 3, 2) == -1);
+
+    ReservationTable_Hold(&table, 4, 4, 1);
+    assert(ReservationTable_GetOwner(&table, 4, 4, table.now + RESERVATION_WINDOW) == 1);
+    ReservationTable_Release(&table, 1);
+    assert(ReservationTable_GetOwner(&table, 4, 4, table.now) == -1);
+
+    // Corridor along row 7 with an alcove above its middle
+    make_empty_map(&map);
+
+    for (int y = 0; y < MAP_HEIGHT; ++y)
+    {
+        for (int x = 0; x < MAP_WIDTH; ++x)
+        {
+            bool corridor = y == 7 && x >= 2 && x <= 17;
+            bool alcove = x == 10 && y == 6;
+
+            if (!corridor && !alcove)
+                Map_SetWalkable(&map, x, y, false);
+        }
+    }
+
+    Map_UpdateComponents(&map);
+
+    // A lone route is reserved step by step and ends on the goal
+    CooperativePath route;
+    bool found = Cooperative_FindPath(&search, &map, 1, 2, 7, 9, 7, &route);
+    assert(found);
+    assert(route.path.length == 8);
+    assert(route.path.tiles[7][0] == 9 && route.path.tiles[7][1] == 7);
+
+    for (int i = 1; i < route.path.length; ++i)
+    {
+        assert(route.depart[i] >= table.now);
+        assert(ReservationTable_GetOwner(&table, route.path.tiles[i][0], route.path.tiles[i][1], route.depart[i] + 1) == 1);
+    }
+
+    ReservationTable_Release(&table, 1);
+
+    // Restart the clock at the game's step length
+    ReservationTable_Free(&table);
+    table_ready = ReservationTable_Init(&table, MAP_WIDTH, MAP_HEIGHT, TILE_SIZE / UNIT_DEFAULT_SPEED);
+    assert(table_ready);
+
+    Unit units[2];
+
+    Unit_Init(&units[0], &map, &test_routes, 2, 7);
+    Unit_Init(&units[1], &map, &test_routes, 17, 7);
+
+    for (int i = 0; i < 2; ++i)
+    {
+        units[i].id = i + 1;
+        units[i].cooperative = &search;
+    }
+
+    Unit_SetCooperativeGoal(&units[0], 17, 7);
+    Unit_SetCooperativeGoal(&units[1], 2, 7);
+
+    int plans = 0;
+    const float dt = 1.0f / 60.0f;
+
+    for (int frame = 0; frame < 60 * 20; ++frame)
+    {
+        ReservationTable_Advance(&table, dt);
+
+        for (int i = 0; i < 2; ++i)
+        {
+            int planned_at = units[i].planned_at;
+
+            Unit_Update(&units[i], &map, dt);
+
+            if (units[i].planned_at != planned_at)
+                plans++;
+        }
+
+        assert(units[0].tx != units[1].tx || units[0].ty != units[1].ty);
+    }
+
+    assert(units[0].tx == 17 && units[0].ty == 7);
+    assert(units[1].tx == 2 && units[1].ty == 7);
+    assert(!units[0].moving && !units[1].moving);
+
+    // A handful of windows each, not a replan per step
+    assert(plans <= 16);
+
+    CooperativeSearch_Free(&search);
+    ReservationTable_Free(&table);
+}
+
+/*
+    Helper: true if a unit walking straight between consecutive
+    waypoints only passes over walkable tiles no costlier than max_cost.
+    Samples each segment finely instead of walking the grid.
+*/
+static bool waypoints_clear(const Map *map, const Path *path, int max_cost)
+{
+    for (int i = 1; i < path->length; ++i)
+    {
+        float ax = (float)path->tiles[i - 1][0];
+        float ay = (float)path->tiles[i - 1][1];
+        float bx = (float)path->tiles[i][0];
+        float by = (float)path->tiles[i][1];
+
+        for (int k = 0; k <= 256; ++k)
+        {
+            float t = (float)k / 256.0f;
+            int tx = (int)floorf(ax + (bx - ax) * t + 0.5f);
+            int ty = (int)floorf(ay + (by - ay) * t + 0.5f);
+
+            if (!Map_IsWalkable(map, tx, ty) || Map_GetCost(map, tx, ty) > max_cost)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+    Test 23: smoothing reduces routes to waypoints with clear straight
+    segments, fits routes longer than MAX_PATH_LENGTH tiles, keeps to
+    cheap terrain, and units walk the segments directly without
+    freeing the tiles of units they pass over
+*/
+static void test_path_smoothing(void)
+{
+    static Map map;
+
+    const PathOptions smooth = { .smooth = true };
+    const PathOptions smooth_diagonal = { .smooth = true, .connectivity = PATH_CONNECTIVITY_8 };
+
+    // Open map: one straight segment, whatever the connectivity
+    make_empty_map(&map);
+
+    Path path;
+    bool found = Pathfinding_FindPath(&test_ctx, &map, 0, 0, MAP_WIDTH - 1, MAP_HEIGHT - 1, &smooth, &path);
+    assert(found);
+    assert(path.length == 2);
+    assert(path.tiles[1][0] == MAP_WIDTH - 1 && path.tiles[1][1] == MAP_HEIGHT - 1);
+
+    found = Pathfinding_FindPath(&test_ctx, &map, 0, 0, MAP_WIDTH - 1, MAP_HEIGHT - 1, &smooth_diagonal, &path);
+    assert(found);
+    assert(path.length == 2);
+
+    // Wall with a gap: the route bends at the gap, in place or from the search
+    for (int y = 0; y < MAP_HEIGHT; ++y)
+    {
+        if (y != 2)
+            Map_SetWalkable(&map, 10, y, false);
+    }
+
+    Map_UpdateComponents(&map);
+
+    Path tiles;
+    found = Pathfinding_FindPath(&test_ctx, &map, 2, 12, 17, 12, NULL, &tiles);
+    assert(found);
+
+    Path smoothed;
+    found = Pathfinding_FindPath(&test_ctx, &map, 2, 12, 17, 12, &smooth, &smoothed);
+    assert(found);
+    assert(smoothed.length >= 3 && smoothed.length < tiles.length);
+    assert(waypoints_clear(&map, &smoothed, MAP_TILE_COST_MIN));
+
+    Pathfinding_SmoothPath(&map, &tiles);
+    assert(tiles.length == smoothed.length);
+    assert(memcmp(tiles.tiles, smoothed.tiles, sizeof(int) * 2 * (size_t)smoothed.length) == 0);
+
+    // Serpentine: far more tiles than MAX_PATH_LENGTH, few turns
+    make_empty_map(&map);
+
+    for (int y = 1; y < MAP_HEIGHT; y += 2)
+    {
+        int gap = (y / 2) % 2 == 0 ? MAP_WIDTH - 1 : 0;
+
+        for (int x = 0; x < MAP_WIDTH; ++x)
+        {
+            if (x != gap)
+                Map_SetWalkable(&map, x, y, false);
+        }
+    }
+
+    Map_UpdateComponents(&map);
+
+    int goal_ty = MAP_HEIGHT % 2 == 0 ? MAP_HEIGHT - 2 : MAP_HEIGHT - 1;
+
+    // Every tile of the route does not fit
+    found = Pathfinding_FindPath(&test_ctx, &map, 0, 0, 0, goal_ty, NULL, &path);
+    assert(!found);
+
+    found = Pathfinding_FindPath(&test_ctx, &map, 0, 0, 0, goal_ty, &smooth, &path);
+    assert(found);
+    assert(path.length <= MAP_HEIGHT * 2);
+    assert(path.tiles[path.length - 1][0] == 0 && path.tiles[path.length - 1][1] == goal_ty);
+    assert(waypoints_clear(&map, &path, MAP_TILE_COST_MIN));
+
+    // Road around a swamp: the shortcut across it is never taken
+    make_empty_map(&map);
+
+    for (int y = 0; y < MAP_HEIGHT; ++y)
+    {
+        for (int x = 0; x < MAP_WIDTH; ++x)
+        {
+            if (y != 0 && x != 10)
+                Map_SetCost(&map, x, y, MAP_COST_SWAMP);
+        }
+    }
+
+    found = Pathfinding_FindPath(&test_ctx, &map, 0, 0, 10, 10, &smooth, &path);
+    assert(found);
+    assert(path.length == 3);
+    assert(path.tiles[1][0] == 10 && path.tiles[1][1] == 0);
+    assert(waypoints_clear(&map, &path, MAP_TILE_COST_MIN));
+
+    // A unit walks straight across and holds one tile on the way
+    make_empty_map(&map);
+
+    found = Pathfinding_FindPath(&test_ctx, &map, 0, 0, 12, 9, &smooth, &path);
+    assert(found);
+
+    Unit unit;
+    Unit_Init(&unit, &map, &test_routes, 0, 0);
+    Unit_SetPath(&unit, &path);
+    assert(RoutePool_CountSegments(&test_routes, unit.movement.first_chunk) == 1);
+
+    int frames = 0;
+
+    while ((unit.moving || Unit_HasQueuedMove(&unit)) && frames < 600)
+    {
+        Unit_Update(&unit, &map, 1.0f / 60.0f);
+        frames++;
+
+        int occupied = 0;
+
+        for (int y = 0; y < MAP_HEIGHT; ++y)
+            for (int x = 0; x < MAP_WIDTH; ++x)
+                occupied += Map_IsOccupied(&map, x, y);
+
+        assert(occupied == 1);
+        assert(Map_IsOccupied(&map, unit.tx, unit.ty));
+    }
+
+    assert(unit.tx == 12 && unit.ty == 9);
+
+    // 15 tiles in a straight line instead of 21 tile steps
+    float seconds = frames / 60.0f;
+    assert(seconds < 16.0f * TILE_SIZE / UNIT_DEFAULT_SPEED);
+
+    // Segments ignore occupancy: passing over a unit standing on one
+    // leaves that unit's tile occupied
+    make_empty_map(&map);
+
+    Unit mover;
+    Unit stander;
+    Unit_Init(&mover, &map, &test_routes, 0, 5);
+    Unit_Init(&stander, &map, &test_routes, 7, 5);
+
+    path.length = 2;
+    path.tiles[0][0] = 0;
+    path.tiles[0][1] = 5;
+    path.tiles[1][0] = 15;
+    path.tiles[1][1] = 5;
+    Unit_SetPath(&mover, &path);
+
+    bool passed = false;
+
+    for (int frame = 0; frame < 600 && (mover.moving || Unit_HasQueuedMove(&mover)); ++frame)
+    {
+        Unit_Update(&mover, &map, 1.0f / 60.0f);
+        passed |= mover.tx == stander.tx && mover.ty == stander.ty;
+        assert(Map_IsOccupied(&map, stander.tx, stander.ty));
+    }
+
+    assert(passed);
+    assert(mover.tx == 15 && mover.ty == 5);
+    assert(Map_IsOccupied(&map, 15, 5));
+    assert(Map_IsOccupied(&map, 7, 5));
+
+    for (int x = 0; x < MAP_WIDTH; ++x)
+    {
+        if (x != 7 && x != 15)
+            assert(!Map_IsOccupied(&map, x, 5));
+    }
+}
+
+/*
+    Test 24: queues store runs and waypoints as segments in the shared
+    pool, decode back to the same tiles and schedule, and a full pool
+    cuts the route short instead of failing
+*/
+static void test_route_pool(void)
+{
+    static Map map;
+    static int decoded[TEST_NODE_COUNT][2];
+
+    // The queue is a cursor into the pool, not an inline tile array
+    assert(sizeof(MovementQueue) <= 64);
+    assert(sizeof(RouteChunk) == 64);
+
+    make_empty_map(&map);
+
+    // An L-shaped route is two runs
+    Path path;
+    path.length = 0;
+
+    for (int x = 2; x <= 12; ++x)
+    {
+        path.tiles[path.length][0] = x;
+        path.tiles[path.length][1] = 3;
+        path.length++;
+    }
+
+    for (int y = 4; y <= 9; ++y)
+    {
+        path.tiles[path.length][0] = 12;
+        path.tiles[path.length][1] = y;
+        path.length++;
+    }
+
+    int free_before = test_routes.free_count;
+
+    Unit unit;
+    Unit_Init(&unit, &map, &test_routes, 2, 3);
+    Unit_SetPath(&unit, &path);
+
+    assert(RoutePool_CountSegments(&test_routes, unit.movement.first_chunk) == 2);
+    assert(test_routes.free_count == free_before - 1);
+
+    int count = queued_tiles(&unit, decoded);
+    assert(count == path.length - 1);
+
+    for (int i = 0; i < count; ++i)
+    {
+        assert(decoded[i][0] == path.tiles[i + 1][0]);
+        assert(decoded[i][1] == path.tiles[i + 1][1]);
+    }
+
+    // Walking it consumes the route and hands the chunk back
+    for (int frame = 0; frame < 600 && (unit.moving || Unit_HasQueuedMove(&unit)); ++frame)
+        Unit_Update(&unit, &map, 1.0f / 60.0f);
+
+    assert(unit.tx == 12 && unit.ty == 9);
+    assert(unit.movement.first_chunk == -1);
+    assert(test_routes.free_count == free_before);
+
+    // Diagonal runs merge too; every tile decodes in order
+    const PathOptions diagonal = { .connectivity = PATH_CONNECTIVITY_8 };
+    bool found = Pathfinding_FindPath(&test_ctx, &map, 0, 0, 14, 6, &diagonal, &path);
+    assert(found);
+
+    Unit_Init(&unit, &map, &test_routes, 0, 0);
+    Unit_SetPath(&unit, &path);
+    assert(RoutePool_CountSegments(&test_routes, unit.movement.first_chunk) <= 2);
+
+    count = queued_tiles(&unit, decoded);
+    assert(count == path.length - 1);
+    assert(memcmp(decoded, path.tiles[1], sizeof(int) * 2 * (size_t)count) == 0);
+
+    Unit_ClearPath(&unit);
+    assert(test_routes.free_count == free_before);
+
+    // Reserved moves keep their own segment and departure
+    int depart[MAX_PATH_LENGTH];
+
+    path.length = 0;
+
+    for (int x = 0; x < 8; ++x)
+    {
+        path.tiles[path.length][0] = x;
+        path.tiles[path.length][1] = 0;
+        depart[path.length] = x < 4 ? 10 + 2 * x : -1;
+        path.length++;
+    }
+
+    int first_chunk = RoutePool_Store(&test_routes, &path, depart);
+    assert(RoutePool_CountSegments(&test_routes, first_chunk) == 4);
+
+    RouteCursor cursor = Route_Begin(first_chunk, 0, 0);
+
+    for (int i = 1; i < path.length; ++i)
+    {
+        int tx;
+        int ty;
+        int step;
+
+        bool more = Route_Peek(&test_routes, &cursor, &tx, &ty, &step);
+        assert(more);
+        assert(tx == i && ty == 0);
+        assert(step == depart[i]);
+
+        Route_Advance(&test_routes, &cursor);
+    }
+
+    assert(cursor.chunk == -1);
+    RoutePool_Release(&test_routes, first_chunk);
+
+    // Two chunks hold fourteen segments; a staircase needs more
+    RoutePool small;
+    bool small_ready = RoutePool_Init(&small, 2);
+    assert(small_ready);
+
+    path.length = 0;
+
+    for (int i = 0; i < 30; ++i)
+    {
+        path.tiles[path.length][0] = (i + 1) / 2;
+        path.tiles[path.length][1] = i / 2;
+        path.length++;
+    }
+
+    first_chunk = RoutePool_Store(&small, &path, NULL);
+    assert(small.free_count == 0);
+    assert(RoutePool_CountSegments(&small, first_chunk) == 2 * ROUTE_CHUNK_SEGMENTS);
+
+    cursor = Route_Begin(first_chunk, 0, 0);
+
+    for (int i = 1; i <= 2 * ROUTE_CHUNK_SEGMENTS; ++i)
+    {
+        int tx;
+        int ty;
+        int step;
+
+        bool more = Route_Peek(&small, &cursor, &tx, &ty, &step);
+        assert(more);
+        assert(tx == path.tiles[i][0] && ty == path.tiles[i][1]);
+
+        Route_Advance(&small, &cursor);
+    }
+
+    assert(cursor.chunk == -1);
+
+    RoutePool_Release(&small, first_chunk);
+    assert(small.free_count == 2);
+
+    RoutePool_Free(&small);
+}
+
+/*
+    Test 25: queries leave begin and end events in the trace ring,
+    the ring keeps the most recent events in order when it wraps, and
+    workers record concurrently without losing events
+*/
+static void test_trace_ring(void)
+{
+#if TRACE_LEVEL == 0
+    // Nothing is recorded in this build
+    return;
+#endif
+
+    static TraceEvent events[TRACE_RING_SIZE];
+    static Map map;
+
+    make_empty_map(&map);
+    Map_SetWalkable(&map, 15, 5, false);
+
+    Trace_Clear();
+
+    Path path;
+    bool found = Pathfinding_FindPath(&test_ctx, &map, 2, 2, 10, 2, NULL, &path);
+    assert(found);
+
+    found = Pathfinding_FindPath(&test_ctx, &map, 2, 2, 15, 5, NULL, &path);
+    assert(!found);
+
+    int count = Trace_Snapshot(events, TRACE_RING_SIZE);
+    assert(count == 4);
+
+    assert(events[0].type == TRACE_EVENT_PATH_BEGIN);
+    assert(events[0].flags == TRACE_FLAG_GOAL_WALKABLE);
+    assert(events[0].args[0] == 2 && events[0].args[1] == 2);
+    assert(events[0].args[2] == 10 && events[0].args[3] == 2);
+
+    assert(events[1].type == TRACE_EVENT_PATH_END);
+    assert(events[1].flags == TRACE_FLAG_FOUND);
+    assert(events[1].args[0] == PATH_SEARCH_FOUND);
+    assert(events[1].args[2] == 9);
+
+    assert(events[2].type == TRACE_EVENT_PATH_BEGIN);
+    assert((events[2].flags & TRACE_FLAG_GOAL_WALKABLE) == 0);
+    assert(events[3].type == TRACE_EVENT_PATH_END);
+    assert(events[3].flags == 0);
+    assert(events[3].args[1] == test_ctx.expansions);
+
+    // Wrapped: only the newest TRACE_RING_SIZE remain, oldest first
+    Trace_Clear();
+
+    for (int i = 0; i < TRACE_RING_SIZE + 100; ++i)
+        Trace_Record(TRACE_EVENT_MOVE_ORDER, 0, i, 0, 0, 0);
+
+    count = Trace_Snapshot(events, TRACE_RING_SIZE);
+    assert(count == TRACE_RING_SIZE);
+    assert(Trace_Count() == TRACE_RING_SIZE + 100);
+
+    for (int i = 0; i < count; ++i)
+    {
+        assert(events[i].args[0] == 100 + i);
+        assert(events[i].sequence == (uint32_t)(100 + i));
+    }
+
+    // A short snapshot takes the newest events
+    count = Trace_Snapshot(events, 10);
+    assert(count == 10);
+    assert(events[9].args[0] == TRACE_RING_SIZE + 99);
+
+    // Workers record concurrently; every query is accounted for
+    enum { REQUEST_COUNT = 64 };
+
+    static PathRequest requests[REQUEST_COUNT];
+    static PathResult results[REQUEST_COUNT];
+
+    for (int i = 0; i < REQUEST_COUNT; ++i)
+    {
+        requests[i].start_tx = i % MAP_WIDTH;
+        requests[i].start_ty = 0;
+        requests[i].goal_tx = MAP_WIDTH - 1 - i % MAP_WIDTH;
+        requests[i].goal_ty = MAP_HEIGHT - 1;
+        requests[i].options = (PathOptions){0};
+    }
+
+    static PathWorkerPool pool;
+    bool pool_ready = PathWorkerPool_Init(&pool, 4, TEST_NODE_COUNT);
+    assert(pool_ready);
+
+    Trace_Clear();
+    Pathfinding_FindPaths(&pool, &map, requests, REQUEST_COUNT, results);
+    PathWorkerPool_Free(&pool);
+
+    count = Trace_Snapshot(events, TRACE_RING_SIZE);
+    assert(count == 2 * REQUEST_COUNT);
+
+    int begins = 0;
+    int ends = 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        assert(events[i].sequence == (uint32_t)i);
+
+        begins += events[i].type == TRACE_EVENT_PATH_BEGIN;
+        ends += events[i].type == TRACE_EVENT_PATH_END;
+    }
+
+    assert(begins == REQUEST_COUNT && ends == REQUEST_COUNT);
+
+    // The dump decodes one line per event after its header
+    FILE *dump = tmpfile();
+    assert(dump != NULL);
+
+    Trace_Dump(dump);
+    rewind(dump);
+
+    char line[256];
+    int lines = 0;
+
+    while (fgets(line, sizeof(line), dump))
+        lines++;
+
+    fclose(dump);
+    assert(lines == 1 + count);
+}
+
+/*
+    Test 26: searches report their counters into the attached stats,
+    every open set counts the same nodes, the histogram places times
+    within its precision, and a full second rolls the window
+*/
+static void test_path_stats(void)
+{
+    static Map map;
+    static PathStats stats;
+
+    make_empty_map(&map);
+    Map_SetWalkable(&map, 15, 5, false);
+
+    PathStats_Init(&stats);
+    test_ctx.stats = &stats;
+
+    Path path;
+    bool found = Pathfinding_FindPath(&test_ctx, &map, 2, 2, 10, 2, NULL, &path);
+    assert(found);
+
+    int expansions = test_ctx.expansions;
+    int opened = test_ctx.opened;
+    assert(opened >= expansions && test_ctx.peak_open > 0);
+    assert(test_ctx.peak_open <= opened);
+
+    found = Pathfinding_FindPath(&test_ctx, &map, 2, 2, 15, 5, NULL, &path);
+    assert(!found);
+
+    test_ctx.stats = NULL;
+
+    assert(stats.total.searches == 2);
+    assert(stats.total.found == 1 && stats.total.failed == 1);
+    assert(stats.total.expansions == expansions + test_ctx.expansions);
+    assert(stats.total.opened == opened + test_ctx.opened);
+    assert(stats.total.path_length == 9);
+    assert(stats.current.searches == 2);
+    assert(stats.max_ns > 0);
+
+    // The open set structure does not change what is counted
+    PathOptions options = {0};
+    int heap_opened = 0;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        options.open_set = i == 0 ? PATH_OPEN_SET_BINARY_HEAP
+            : i == 1 ? PATH_OPEN_SET_LINEAR_SCAN
+            : PATH_OPEN_SET_BUCKET_QUEUE;
+
+        found = Pathfinding_FindPath(&test_ctx, &map, 0, 0, 3, 0, &options, &path);
+        assert(found);
+
+        if (i == 0)
+            heap_opened = test_ctx.opened;
+
+        // Straight run on an empty map: the open sets agree exactly
+        if (i == 1)
+            assert(test_ctx.opened == heap_opened);
+
+        assert(test_ctx.opened > 0 && test_ctx.peak_open > 0);
+    }
+
+    // Known times: percentiles land in the right bucket from above
+    PathStats_Reset(&stats);
+
+    for (int i = 1; i <= 100; ++i)
+    {
+        PathSearchReport report = { .found = true, .elapsed_ns = i * 1000LL };
+        PathStats_Record(&stats, &report);
+    }
+
+    long long p50 = PathStats_Percentile(&stats, 50.0);
+    long long p99 = PathStats_Percentile(&stats, 99.0);
+    long long p100 = PathStats_Percentile(&stats, 100.0);
+
+    assert(p50 >= 50000 && p50 <= 50000 + 50000 / PATH_STATS_SUB_BUCKETS);
+    assert(p99 >= 99000 && p99 <= 99000 + 99000 / PATH_STATS_SUB_BUCKETS);
+    assert(p100 == 100000);
+
+    // Small times are exact
+    PathStats_Reset(&stats);
+
+    PathSearchReport tiny = { .found = true, .elapsed_ns = 7 };
+    PathStats_Record(&stats, &tiny);
+
+    long long exact = PathStats_Percentile(&stats, 50.0);
+    assert(exact == 7);
+
+    // The window closes after a second of game time
+    PathStats_Update(&stats, 0.5f);
+    assert(stats.last_second.searches == 0);
+
+    PathStats_Update(&stats, 0.6f);
+    assert(stats.last_second.searches == 1);
+    assert(stats.current.searches == 0);
+    assert(stats.total.searches == 1);
+}
+
+/*
+    Test 27: maps take their size at runtime; one context serves any
+    map up to its capacity, and searches on larger maps fail cleanly
+*/
+static void test_runtime_map_size(void)
+{
+    static Map map;
+    static PathContext big_ctx;
+    static FlowFieldCache cache;
+
+    // Wider than the default map and not square
+    const int width = 37;
+    const int height = 9;
+
+    Map_Free(&map);
+    bool map_ready = Map_Init(&map, width, height);
+    assert(map_ready);
+    assert(Map_TileCount(&map) == width * height);
+    assert(Map_IsInside(&map, width - 1, height - 1));
+    assert(!Map_IsInside(&map, width, 0));
+    assert(!Map_IsInside(&map, 0, height));
+
+    // Wall with a gap at the bottom
+    for (int y = 0; y < height - 1; ++y)
+        Map_SetWalkable(&map, 20, y, false);
+
+    Map_UpdateComponents(&map);
+
+    // The shared context is sized for the default map, too small here
+    Path path;
+    bool found = Pathfinding_FindPath(&test_ctx, &map, 0, 0, width - 1, 0, NULL, &path);
+    assert(!found);
+
+    bool ctx_ready = PathContext_Init(&big_ctx, 1024 * 1024);
+    assert(ctx_ready);
+
+    found = Pathfinding_FindPath(&big_ctx, &map, 0, 0, width - 1, 0, NULL, &path);
+    assert(found);
+    assert(path.length == (width - 1) + 2 * (height - 1) + 1);
+    assert(path.tiles[path.length - 1][0] == width - 1 && path.tiles[path.length - 1][1] == 0);
+
+    // Flow fields index by the same size
+    bool cache_ready = FlowFieldCache_Init(&cache, Map_TileCount(&map));
+    assert(cache_ready);
+
+    FlowField *field = FlowFieldCache_Acquire(&cache, &map, width - 1, 0);
+    assert(field != NULL);
+    assert(FlowField_GetDistance(field, 0, 0) == path.length - 1);
+    assert(FlowField_GetDistance(field, width, 0) == FLOW_FIELD_UNREACHABLE);
+
+    FlowField_Release(field);
+    FlowFieldCache_Free(&cache);
+
+    // A large map; smoothing keeps the open diagonal to two waypoints
+    Map_Free(&map);
+    map_ready = Map_Init(&map, 1024, 1024);
+    assert(map_ready);
+
+    PathOptions options = { .connectivity = PATH_CONNECTIVITY_8, .smooth = true };
+    found = Pathfinding_FindPath(&big_ctx, &map, 0, 0, 1023, 1023, &options, &path);
+    assert(found);
+    assert(path.length == 2);
+    assert(path.tiles[1][0] == 1023 && path.tiles[1][1] == 1023);
+
+    // Bad sizes are refused
+    Map_Free(&map);
+    map_ready = Map_Init(&map, 0, 10);
+    assert(!map_ready);
+
+    PathContext_Free(&big_ctx);
+}
+
+/*
+    Test 28: walkability and occupancy are bit layers; row reads line
+    up at any offset, and JPS jumps scanned a word at a time agree with
+    A* on maps several words wide
+*/
+static void test_bit_layers(void)
+{
+    static Map map;
+    static PathContext wide_ctx;
+
+    const int width = 150;
+    const int height = 12;
+
+    Map_Free(&map);
+    bool map_ready = Map_Init(&map, width, height);
+    assert(map_ready);
+
+    // Runs crossing the left edge, a word boundary and the right edge
+    uint64_t row = Map_WalkableRow(&map, -3, 0);
+    assert(row == ~(uint64_t)0 << 3);
+
+    Map_SetWalkable(&map, 64, 1, false);
+    row = Map_WalkableRow(&map, 60, 1);
+    assert(row == ~((uint64_t)1 << 4));
+
+    row = Map_WalkableRow(&map, width - 10, 2);
+    assert(row == ((uint64_t)1 << 10) - 1);
+
+    row = Map_OccupiedRow(&map, width - 10, 2);
+    assert(row == ~(((uint64_t)1 << 10) - 1));
+
+    row = Map_WalkableRow(&map, 0, height);
+    assert(row == 0);
+
+    // Row writes across a word boundary land on the single-tile view
+    Map_SetOccupiedRow(&map, 62, 3, 0xF, true);
+    assert(!Map_IsOccupied(&map, 61, 3));
+    assert(Map_IsOccupied(&map, 62, 3) && Map_IsOccupied(&map, 63, 3));
+    assert(Map_IsOccupied(&map, 64, 3) && Map_IsOccupied(&map, 65, 3));
+    assert(!Map_IsOccupied(&map, 66, 3));
+
+    row = Map_PassableRow(&map, 62, 3);
+    assert((row & 0xF) == 0);
+    assert(((row >> 4) & 1u) == 1);
+
+    Map_SetOccupiedRow(&map, 62, 3, 0x5, false);
+    assert(!Map_IsOccupied(&map, 62, 3) && Map_IsOccupied(&map, 63, 3));
+    assert(!Map_IsOccupied(&map, 64, 3) && Map_IsOccupied(&map, 65, 3));
+
+    // Bits past the map are ignored rather than wrapped into the next row
+    Map_SetOccupiedRow(&map, width - 2, 4, ~(uint64_t)0, true);
+    assert(Map_IsOccupied(&map, width - 1, 4));
+    assert(!Map_IsOccupied(&map, 0, 5));
+
+    bool ctx_ready = PathContext_Init(&wide_ctx, width * height);
+    assert(ctx_ready);
+
+    PathOptions astar_options = { 0 };
+    PathOptions jps_options = { .algorithm = PATH_ALGORITHM_JPS };
+
+    Map_Free(&map);
+
+    for (unsigned int seed = 1; seed <= 20; ++seed)
+    {
+        map_ready = Map_Init(&map, width, height);
+        assert(map_ready);
+
+        unsigned int state = seed;
+
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                state = state * 1103515245u + 12345u;
+
+                if ((int)((state >> 16) % 100) < (int)(seed % 3) * 10)
+                    Map_SetWalkable(&map, x, y, false);
+            }
+        }
+
+        int start_ty = (int)(seed % height);
+        int goal_ty = height - 1 - start_ty;
+
+        Map_SetWalkable(&map, 0, start_ty, true);
+        Map_SetWalkable(&map, width - 1, goal_ty, true);
+
+        Path astar_path;
+        Path jps_path;
+        bool astar_found = Pathfinding_FindPath(&wide_ctx, &map, 0, start_ty, width - 1, goal_ty, &astar_options, &astar_path);
+        bool jps_found = Pathfinding_FindPath(&wide_ctx, &map, 0, start_ty, width - 1, goal_ty, &jps_options, &jps_path);
+
+        assert(astar_found == jps_found);
+
+        if (astar_found)
+            assert(astar_path.length == jps_path.length);
+
+        Map_Free(&map);
+    }
+
+    PathContext_Free(&wide_ctx);
+}
+
+/*
+    Helper: random walls, swamp and units on a 37x21 map, a size that
+    leaves partial blocks on both edges, stored in the given layout.
+*/
+static void build_layout_map(Map *map, const MapLayout *layout, unsigned int seed)
+{
+    Map_Free(map);
+    bool map_ready = Map_InitLayout(map, 37, 21, layout);
+    assert(map_ready);
+
+    unsigned int state = seed;
+
+    for (int y = 0; y < map->height; y++)
+    {
+        for (int x = 0; x < map->width; x++)
+        {
+            state = state * 1103515245u + 12345u;
+            unsigned int roll = (state >> 16) % 100;
+
+            if (roll < 25)
+                Map_SetWalkable(map, x, y, false);
+            else if (roll < 40)
+                Map_SetCost(map, x, y, MAP_COST_SWAMP);
+            else if (roll < 45)
+                Map_SetOccupied(map, x, y, true);
+        }
+    }
+
+    Map_SetWalkable(map, 0, 0, true);
+    Map_SetOccupied(map, 0, 0, false);
+    Map_SetWalkable(map, map->width - 1, map->height - 1, true);
+    Map_SetOccupied(map, map->width - 1, map->height - 1, false);
+    Map_UpdateComponents(map);
+}
+
+/*
+    Test 29: blocked and Z-ordered storage answer every Map_* query
+    like row-major storage, including row reads across blocks and
+    region labels, so searches on them find the same paths
+*/
+static void test_map_layouts(void)
+{
+    static Map row_map;
+    static Map block_map;
+    static PathContext layout_ctx;
+
+    const MapLayout layouts[] =
+    {
+        { .block_size = 8 },
+        { .block_size = 16 },
+        { .block_size = 8, .morton = true },
+        { .block_size = 16, .morton = true },
+    };
+
+    bool ctx_ready = PathContext_Init(&layout_ctx, 37 * 21);
+    assert(ctx_ready);
+
+    for (size_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); ++l)
+    {
+        for (unsigned int seed = 1; seed <= 5; ++seed)
+        {
+            build_layout_map(&row_map, NULL, seed);
+            build_layout_map(&block_map, &layouts[l], seed);
+
+            for (int y = 0; y < row_map.height; y++)
+            {
+                for (int x = 0; x < row_map.width; x++)
+                {
+                    assert(Map_IsWalkable(&block_map, x, y) == Map_IsWalkable(&row_map, x, y));
+                    assert(Map_IsOccupied(&block_map, x, y) == Map_IsOccupied(&row_map, x, y));
+                    assert(Map_GetCost(&block_map, x, y) == Map_GetCost(&row_map, x, y));
+                    assert(Map_AreConnected(&block_map, 0, 0, x, y) == Map_AreConnected(&row_map, 0, 0, x, y));
+                }
+
+                for (int x = -70; x < row_map.width; x += 13)
+                {
+                    assert(Map_WalkableRow(&block_map, x, y) == Map_WalkableRow(&row_map, x, y));
+                    assert(Map_OccupiedRow(&block_map, x, y) == Map_OccupiedRow(&row_map, x, y));
+                }
+            }
+
+            // Row writes go through the layout too
+            Map_SetOccupiedRow(&row_map, 5, 3, 0x0F0F0F0F, true);
+            Map_SetOccupiedRow(&block_map, 5, 3, 0x0F0F0F0F, true);
+            assert(Map_OccupiedRow(&block_map, 0, 3) == Map_OccupiedRow(&row_map, 0, 3));
+
+            PathOptions options = { 0 };
+            PathOptions jps_options = { .algorithm = PATH_ALGORITHM_JPS };
+            Path row_path;
+            Path block_path;
+
+            bool row_found = Pathfinding_FindPath(&layout_ctx, &row_map, 0, 0, 36, 20, &options, &row_path);
+            bool block_found = Pathfinding_FindPath(&layout_ctx, &block_map, 0, 0, 36, 20, &options, &block_path);
+
+            assert(row_found == block_found);
+
+            if (row_found)
+            {
+                assert(row_path.length == block_path.length);
+                assert(memcmp(row_path.tiles, block_path.tiles, sizeof(int) * 2 * (size_t)row_path.length) == 0);
+            }
+
+            row_found = Pathfinding_FindPath(&layout_ctx, &row_map, 0, 0, 36, 20, &jps_options, &row_path);
+            block_found = Pathfinding_FindPath(&layout_ctx, &block_map, 0, 0, 36, 20, &jps_options, &block_path);
+
+            assert(row_found == block_found);
+
+            if (row_found)
+                assert(row_path.length == block_path.length);
+        }
+    }
+
+    // Only 8 and 16 tile blocks are supported
+    Map_Free(&block_map);
+    MapLayout odd_layout = { .block_size = 12 };
+    bool map_ready = Map_InitLayout(&block_map, 37, 21, &odd_layout);
+    assert(!map_ready);
+
+    Map_Free(&row_map);
+    Map_Free(&block_map);
+    PathContext_Free(&layout_ctx);
+}
+
+/*
+    Helper: overwrites bytes of a saved map file, at an offset into the
+    section of the given type, or into the header for MAP_SECTION_NONE
+*/
+static void patch_map_file(const char *path, uint32_t type, long at, const void *data, size_t size)
+{
+    FILE *file = fopen(path, "r+b");
+    assert(file != NULL);
+
+    MapFileHeader header;
+    MapFileSection sections[MAP_FILE_MAX_SECTIONS];
+    size_t read_ok = fread(&header, sizeof(header), 1, file);
+    assert(read_ok == 1 && header.section_count <= MAP_FILE_MAX_SECTIONS);
+    read_ok = fread(sections, sizeof(MapFileSection), header.section_count, file);
+    assert(read_ok == header.section_count);
+
+    long base = 0;
+
+    for (uint32_t i = 0; i < header.section_count && type != MAP_SECTION_NONE; ++i)
+    {
+        if (sections[i].type == type)
+            base = (long)sections[i].offset;
+    }
+
+    assert(type == MAP_SECTION_NONE || base != 0);
+
+    if (at < 0)
+    {
+        for (uint32_t i = 0; i < header.section_count; ++i)
+        {
+            if (sections[i].type == type)
+                at += (long)sections[i].size;
+        }
+    }
+
+    fseek(file, base + at, SEEK_SET);
+    fwrite(data, 1, size, file);
+    fclose(file);
+}
+
+/*
+    Test 30: a saved map loads back through a mapping with the same
+    layers, edits to the loaded map stay out of the file, and damaged
+    files, whether in structure or in tile values, are refused
+*/
+static void test_map_file(void)
+{
+    static Map saved;
+    static Map loaded;
+
+    const char *path = "test_map.rtsmap";
+    const MapLayout layouts[] =
+    {
+        { 0 },
+        { .block_size = 16, .morton = true },
+    };
+
+    for (size_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); ++l)
+    {
+        build_layout_map(&saved, &layouts[l], 7);
+
+        bool saved_ok = MapFile_Save(&saved, path);
+        assert(saved_ok);
+
+        Map_Free(&loaded);
+        bool loaded_ok = MapFile_Load(&loaded, path);
+        assert(loaded_ok);
+
+        assert(loaded.width == saved.width && loaded.height == saved.height);
+        assert(loaded.layout.block_size == saved.layout.block_size);
+        assert(loaded.layout.morton == saved.layout.morton);
+        assert(Map_HasUniformCost(&loaded) == Map_HasUniformCost(&saved));
+
+        // Layers point into the mapping rather than a copy
+        assert(loaded.mapping != NULL);
+        assert((uint8_t *)loaded.walkable_bits > (uint8_t *)loaded.mapping);
+        assert((uintptr_t)loaded.tiles % MAP_FILE_ALIGNMENT == 0);
+
+        Map_UpdateComponents(&loaded);
+
+        for (int y = 0; y < saved.height; y++)
+        {
+            for (int x = 0; x < saved.width; x++)
+            {
+                assert(Map_IsWalkable(&loaded, x, y) == Map_IsWalkable(&saved, x, y));
+                assert(Map_IsOccupied(&loaded, x, y) == Map_IsOccupied(&saved, x, y));
+                assert(Map_GetCost(&loaded, x, y) == Map_GetCost(&saved, x, y));
+                assert(Map_AreConnected(&loaded, 0, 0, x, y) == Map_AreConnected(&saved, 0, 0, x, y));
+            }
+        }
+
+        static PathContext file_ctx;
+        Path saved_path;
+        Path loaded_path;
+
+        bool ctx_ready = PathContext_Init(&file_ctx, Map_TileCount(&saved));
+        assert(ctx_ready);
+
+        bool saved_found = Pathfinding_FindPath(&file_ctx, &saved, 0, 0, saved.width - 1, saved.height - 1, NULL, &saved_path);
+        bool loaded_found = Pathfinding_FindPath(&file_ctx, &loaded, 0, 0, saved.width - 1, saved.height - 1, NULL, &loaded_path);
+        assert(saved_found == loaded_found);
+        assert(!saved_found || saved_path.length == loaded_path.length);
+
+        PathContext_Free(&file_ctx);
+
+        // Edits copy pages privately; the file keeps the saved state
+        bool was_walkable = Map_IsWalkable(&loaded, 3, 3);
+        Map_SetWalkable(&loaded, 3, 3, !was_walkable);
+        Map_SetOccupied(&loaded, 4, 4, true);
+        assert(Map_IsWalkable(&loaded, 3, 3) == !was_walkable);
+
+        static Map reloaded;
+        Map_Free(&reloaded);
+        loaded_ok = MapFile_Load(&reloaded, path);
+        assert(loaded_ok);
+        assert(Map_IsWalkable(&reloaded, 3, 3) == was_walkable);
+        assert(Map_IsOccupied(&reloaded, 4, 4) == Map_IsOccupied(&saved, 4, 4));
+        Map_Free(&reloaded);
+
+        // Costs out of range are refused
+        const int bad_costs[] = { MAP_TILE_COST_MIN - 1, MAP_TILE_COST_MAX + 1 };
+
+        for (size_t c = 0; c < sizeof(bad_costs) / sizeof(bad_costs[0]); ++c)
+        {
+            saved_ok = MapFile_Save(&saved, path);
+            assert(saved_ok);
+
+            Tile bad_tile = { .cost = bad_costs[c] };
+            patch_map_file(path, MAP_SECTION_COST, (long)sizeof(Tile) * 5, &bad_tile, sizeof(bad_tile));
+
+            loaded_ok = MapFile_Load(&reloaded, path);
+            assert(!loaded_ok);
+        }
+
+        // The last byte of either bit layer covers padding only: past
+        // the width of the last row, or padding tiles of the last block
+        const uint32_t bit_sections[] = { MAP_SECTION_WALKABLE, MAP_SECTION_OCCUPIED };
+        const uint8_t padding_bits = 0x80;
+
+        for (size_t b = 0; b < sizeof(bit_sections) / sizeof(bit_sections[0]); ++b)
+        {
+            saved_ok = MapFile_Save(&saved, path);
+            assert(saved_ok);
+
+            patch_map_file(path, bit_sections[b], -1, &padding_bits, sizeof(padding_bits));
+
+            loaded_ok = MapFile_Load(&reloaded, path);
+            assert(!loaded_ok);
+        }
+
+        // A wrong costly tile count in the header is not trusted
+        saved_ok = MapFile_Save(&saved, path);
+        assert(saved_ok);
+
+        int32_t wrong_count = 0;
+        patch_map_file(path, MAP_SECTION_NONE, (long)offsetof(MapFileHeader, costly_tile_count),
+            &wrong_count, sizeof(wrong_count));
+
+        loaded_ok = MapFile_Load(&reloaded, path);
+        assert(loaded_ok);
+        assert(!Map_HasUniformCost(&saved));
+        assert(!Map_HasUniformCost(&reloaded));
+        Map_Free(&reloaded);
+    }
+
+    // A truncated file and a wrong magic are both refused
+    FILE *file = fopen(path, "r+b");
+    assert(file != NULL);
+    uint32_t bad_magic = 0x12345678u;
+    fwrite(&bad_magic, sizeof(bad_magic), 1, file);
+    fclose(file);
+
+    Map_Free(&loaded);
+    bool loaded_ok = MapFile_Load(&loaded, path);
+    assert(!loaded_ok);
+
+    // Header and section table intact, sections cut off
+    bool saved_ok = MapFile_Save(&saved, path);
+    assert(saved_ok);
+
+    unsigned char head[200];
+    file = fopen(path, "rb");
+    assert(file != NULL);
+    size_t head_size = fread(head, 1, sizeof(head), file);
+    fclose(file);
+    assert(head_size == sizeof(head));
+
+    file = fopen(path, "wb");
+    assert(file != NULL);
+    fwrite(head, 1, head_size, file);
+    fclose(file);
+
+    loaded_ok = MapFile_Load(&loaded, path);
+    assert(!loaded_ok);
+
+    loaded_ok = MapFile_Load(&loaded, "missing.rtsmap");
+    assert(!loaded_ok);
+
+    remove(path);
+    Map_Free(&saved);
+}
+
+/*
+    Test 31: edits bump the map and chunk revisions, pile up as one
+    dirty rectangle per chunk until published, and reach every reader
+    once; a reader left too far behind is told everything changed
+*/
+static void test_map_changes(void)
+{
+    static Map map;
+    make_empty_map(&map);
+
+    MapChangeReader reader;
+    MapChange changes[8];
+    Map_ChangeReaderInit(&map, &reader);
+
+    assert(Map_GetRevision(&map) == 0);
+
+    Map_SetOccupied(&map, 3, 3, true);
+    assert(Map_GetRevision(&map) == 1);
+    assert(Map_GetChunkRevision(&map, 0, 0) == 1);
+    assert(Map_GetChunkRevision(&map, MAP_CHUNK_SIZE, 0) == 0);
+
+    // Writing the value already there is not an edit
+    Map_SetOccupied(&map, 3, 3, true);
+    Map_SetWalkable(&map, 4, 4, true);
+    assert(Map_GetRevision(&map) == 1);
+
+    Map_SetWalkable(&map, 5, 7, false);
+    Map_SetCost(&map, MAP_CHUNK_SIZE + 2, 2, MAP_COST_SWAMP);
+    assert(Map_GetRevision(&map) == 3);
+
+    // Nothing is readable until published
+    int count = Map_ReadChanges(&map, &reader, changes, 8);
+    assert(count == 0);
+
+    Map_PublishChanges(&map);
+    count = Map_ReadChanges(&map, &reader, changes, 8);
+    assert(count == 2);
+
+    assert(changes[0].min_tx == 3 && changes[0].min_ty == 3);
+    assert(changes[0].max_tx == 5 && changes[0].max_ty == 7);
+    assert(changes[0].flags == (MAP_CHANGE_OCCUPIED | MAP_CHANGE_WALKABLE));
+    assert(changes[0].revision == 2);
+
+    assert(changes[1].min_tx == MAP_CHUNK_SIZE + 2 && changes[1].max_tx == MAP_CHUNK_SIZE + 2);
+    assert(changes[1].flags == MAP_CHANGE_COST);
+    assert(changes[1].revision == 3);
+
+    count = Map_ReadChanges(&map, &reader, changes, 8);
+    assert(count == 0);
+
+    // Row writes record only the tiles that flip
+    Map_SetOccupiedRow(&map, 2, 3, 0x3, true);
+    assert(Map_GetRevision(&map) == 4);
+    Map_PublishChanges(&map);
+
+    // A reader drains at its own pace, capacity permitting
+    MapChangeReader slow_reader;
+    Map_ChangeReaderInit(&map, &slow_reader);
+
+    Map_SetOccupied(&map, MAP_CHUNK_SIZE + 1, 1, true);
+    Map_PublishChanges(&map);
+
+    count = Map_ReadChanges(&map, &slow_reader, changes, 1);
+    assert(count == 1);
+    assert(changes[0].min_tx == MAP_CHUNK_SIZE + 1);
+
+    count = Map_ReadChanges(&map, &reader, changes, 1);
+    assert(count == 1);
+    assert(changes[0].min_tx == 2 && changes[0].max_tx == 2);
+
+    count = Map_ReadChanges(&map, &reader, changes, 8);
+    assert(count == 1);
+
+    // More ticks than the log holds: one change covering the map
+    for (int tick = 0; tick <= MAP_CHANGE_LOG_SIZE; ++tick)
+    {
+        Map_SetOccupied(&map, 0, 0, tick % 2 == 0);
+        Map_PublishChanges(&map);
+    }
+
+    count = Map_ReadChanges(&map, &reader, changes, 8);
+    assert(count == 1);
+    assert(changes[0].min_tx == 0 && changes[0].max_tx == MAP_WIDTH - 1);
+    assert(changes[0].min_ty == 0 && changes[0].max_ty == MAP_HEIGHT - 1);
+    assert(changes[0].flags == MAP_CHANGE_ALL);
+
+    count = Map_ReadChanges(&map, &reader, changes, 8);
+    assert(count == 0);
+
+    // The cluster graph picks up walls from the log alone
+    static ClusterGraph graph;
+    static ClusterPath abstract_path;
+
+    make_empty_map(&map);
+    bool graph_ready = ClusterGraph_Init(&graph, &map);
+    assert(graph_ready);
+
+    MapChangeReader graph_reader;
+    Map_ChangeReaderInit(&map, &graph_reader);
+
+    for (int y = 0; y < MAP_HEIGHT; y++)
+        Map_SetWalkable(&map, CLUSTER_SIZE, y, false);
+
+    Map_PublishChanges(&map);
+    ClusterGraph_ApplyMapChanges(&graph, &map, &graph_reader);
+
+    bool found = ClusterGraph_FindPath(&graph, &map, 0, 0, MAP_WIDTH - 1, 0, &abstract_path);
+    assert(found == false);
+
+    Map_SetWalkable(&map, CLUSTER_SIZE, 3, true);
+    Map_PublishChanges(&map);
+    ClusterGraph_ApplyMapChanges(&graph, &map, &graph_reader);
+
+    found = ClusterGraph_FindPath(&graph, &map, 0, 0, MAP_WIDTH - 1, 0, &abstract_path);
+    assert(found == true);
+
+    ClusterGraph_Free(&graph);
+}
+
+/*
+    Helper: tiles of the route the last found search reconstructed,
+    which may be longer than a Path holds
+*/
+static int route_tile_count(const PathContext *ctx, int goal_index)
+{
+    int count = 1;
+
+    while (ctx->route[count - 1] != goal_index)
+        ++count;
+
+    return count;
+}
+
+/*
+    Test 32: JPS asked for the bucket queue still finds shortest paths
+    when single jumps cost more than the queue's bucket span
+*/
+static void test_jps_long_jumps(void)
+{
+    enum { SIZE = 600 };
+
+    static Map map;
+    static PathContext big_ctx;
+
+    bool map_ready = Map_Init(&map, SIZE, SIZE);
+    assert(map_ready);
+
+    bool ctx_ready = PathContext_Init(&big_ctx, SIZE * SIZE);
+    assert(ctx_ready);
+
+    const PathOptions astar = { .algorithm = PATH_ALGORITHM_ASTAR };
+    const PathOptions jps_bucket =
+    {
+        .algorithm = PATH_ALGORITHM_JPS,
+        .open_set = PATH_OPEN_SET_BUCKET_QUEUE
+    };
+
+    // Sparse walls leave rows and columns open for hundreds of tiles
+    unsigned int state = 7;
+
+    for (int y = 0; y < SIZE; ++y)
+    {
+        for (int x = 0; x < SIZE; ++x)
+        {
+            state = state * 1103515245u + 12345u;
+
+            if ((state >> 16) % 1000 < 2)
+                Map_SetWalkable(&map, x, y, false);
+        }
+    }
+
+    Map_SetWalkable(&map, 0, 0, true);
+    Map_UpdateComponents(&map);
+
+    static const int goals[][2] = {
+        { SIZE - 1, SIZE - 1 }, { SIZE - 1, 0 }, { 0, SIZE - 1 }, { 450, 300 }, { 599, 17 }
+    };
+
+    // Uniform 4-connected steps: the tile count is the route cost
+    for (size_t i = 0; i < sizeof(goals) / sizeof(goals[0]); ++i)
+    {
+        int gx = goals[i][0];
+        int gy = goals[i][1];
+        Path path;
+
+        if (!Map_IsWalkable(&map, gx, gy))
+            continue;
+
+        Pathfinding_FindPath(&big_ctx, &map, 0, 0, gx, gy, &astar, &path);
+        assert(big_ctx.status == PATH_SEARCH_FOUND);
+        int astar_tiles = route_tile_count(&big_ctx, gy * SIZE + gx);
+
+        Pathfinding_FindPath(&big_ctx, &map, 0, 0, gx, gy, &jps_bucket, &path);
+        assert(big_ctx.status == PATH_SEARCH_FOUND);
+        assert(big_ctx.open_set == PATH_OPEN_SET_BINARY_HEAP);
+        int jps_tiles = route_tile_count(&big_ctx, gy * SIZE + gx);
+
+        assert(jps_tiles == astar_tiles);
+    }
+
+    PathContext_Free(&big_ctx);
+    Map_Free(&map);
+}
+
+/*
+    Test 33: with a cluster graph, long orders search one sector
+    segment at a time and still bring the unit to a goal farther
+    than a single path can reach
+*/
+static void test_scheduler_clusters(void)
+{
+    enum { SIZE = 64, WALL_X = 32, GAP_Y = 60 };
+
+    static Map map;
+    static PathContext sched_ctx;
+    static ClusterGraph graph;
+    static ClusterPath abstract_path;
+
+    bool map_ready = Map_Init(&map, SIZE, SIZE);
+    assert(map_ready);
+    bool ctx_ready = PathContext_Init(&sched_ctx, SIZE * SIZE);
+    assert(ctx_ready);
+
+    // The only way across is far down the wall: a detour longer than a path holds
+    for (int y = 0; y < SIZE; ++y)
+    {
+        if (y != GAP_Y)
+            Map_SetWalkable(&map, WALL_X, y, false);
+    }
+
+    Map_UpdateComponents(&map);
+
+    bool graph_ready = ClusterGraph_Init(&graph, &map);
+    assert(graph_ready);
+
+    PathScheduler scheduler;
+    PathScheduler_Init(&scheduler, &sched_ctx, NULL, PATH_SCHEDULER_DEFAULT_BUDGET);
+    scheduler.clusters = &graph;
+
+    Unit unit;
+    Unit_Init(&unit, &map, &test_routes, 2, 2);
+
+    // Without room for an abstract route the order searches the whole way
+    PathScheduler_Submit(&scheduler, &map, &unit, SIZE - 4, 2, NULL);
+    assert(unit.abstract_segment == -1);
+    assert(scheduler.requests[scheduler.head].goal_tx == SIZE - 4);
+
+    unit.abstract_path = &abstract_path;
+
+    // Short orders skip the abstract graph
+    PathScheduler_Submit(&scheduler, &map, &unit, 4, 4, NULL);
+    assert(unit.abstract_segment == -1);
+
+    PathScheduler_Submit(&scheduler, &map, &unit, SIZE - 4, 2, NULL);
+    assert(unit.abstract_segment == 0);
+    assert(abstract_path.count > 2);
+    assert(scheduler.count == 1);
+    assert(scheduler.requests[scheduler.head].goal_tx == abstract_path.waypoints[1][0]);
+    assert(scheduler.requests[scheduler.head].goal_ty == abstract_path.waypoints[1][1]);
+
+    int segments = abstract_path.count - 1;
+    int searched = 0;
+    int last_segment = -1;
+
+    for (int tick = 0; tick < 20000 && (unit.abstract_segment >= 0 || unit.moving || unit.path_pending); ++tick)
+    {
+        PathScheduler_Continue(&scheduler, &map, &unit);
+
+        // Each search only reaches the next waypoint
+        if (unit.path_pending && unit.abstract_segment != last_segment)
+        {
+            const PathSchedulerRequest *request = &scheduler.requests[scheduler.head];
+
+            assert(request->goal_tx == abstract_path.waypoints[unit.abstract_segment + 1][0]);
+            assert(request->goal_ty == abstract_path.waypoints[unit.abstract_segment + 1][1]);
+
+            last_segment = unit.abstract_segment;
+            searched++;
+        }
+
+        PathScheduler_Update(&scheduler, &map);
+        Unit_Update(&unit, &map, 1.0f / 60.0f);
+    }
+
+    assert(searched == segments);
+    assert(unit.abstract_segment == -1);
+    assert(unit.tx == SIZE - 4 && unit.ty == 2);
+
+    // A new order drops the rest of the abstract route
+    PathScheduler_Submit(&scheduler, &map, &unit, 2, 2, NULL);
+    assert(unit.abstract_segment == 0);
+    PathScheduler_Submit(&scheduler, &map, &unit, SIZE - 6, 4, NULL);
+    assert(unit.abstract_segment == -1);
+    PathScheduler_Cancel(&scheduler, &unit);
+
+    ClusterGraph_Free(&graph);
+    PathContext_Free(&sched_ctx);
+    Map_Free(&map);
+}
+
+int main(void)
+{
+    printf("Running pathfinding tests...\n");
+
+    bool ctx_ready = PathContext_Init(&test_ctx, TEST_NODE_COUNT);
+    assert(ctx_ready);
+
+    bool routes_ready = RoutePool_Init(&test_routes, ROUTE_POOL_DEFAULT_CHUNKS);
+    assert(routes_ready);
+
+    test_straight_path();
+    test_blocked_goal();
+    test_same_tile();
+    test_open_sets_match();
+    test_context_reuse();
+    test_debug_sink();
+    test_jps_matches_astar();
+    test_cluster_matches_astar();
+    test_cluster_incremental_update();
+    test_flow_field_sharing();
+    test_flow_field_group();
+    test_path_cache();
+    test_replan_matches_astar();
+    test_replan_unit_detour();
+    test_components();
+    test_batch_matches_serial();
+    test_scheduler_slices();
+    test_landmark_heuristic();
+    test_bidirectional_matches_astar();
+    test_diagonal_movement();
+    test_terrain_costs();
+    test_cooperative_corridor();
+    test_path_smoothing();
+    test_route_pool();
+    test_trace_ring();
+    test_path_stats();
+    test_runtime_map_size();
+    test_bit_layers();
+    test_map_layouts();
+    test_map_file();
+    test_map_changes();
+    test_jps_long_jumps();
+    test_scheduler_clusters();
+
+    PathContext_Free(&test_ctx);
+    RoutePool_Free(&test_routes);
 
     printf("All tests passed.\n");
 